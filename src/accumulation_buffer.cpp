@@ -0,0 +1,182 @@
+#include "accumulation_buffer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <type_traits>
+#include "samplers/hash.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define RTRT_HAS_FSYNC
+#endif
+
+// bump whenever the header or payload layout changes
+constexpr uint32_t CHECKPOINT_VERSION = 1;
+constexpr char CHECKPOINT_MAGIC[8] = {'R', 'T', 'R', 'T', 'A', 'C', 'C', '\0'};
+// reads back byte swapped on a machine with the other endianness
+constexpr uint32_t CHECKPOINT_BYTE_ORDER = 0x01020304;
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t width;
+    uint32_t height;
+    uint32_t sampler_type;
+    uint32_t samples_per_pass;
+    uint32_t pass_index;
+    uint32_t padding;
+    uint64_t scene_key;
+    // covers the payload, sums followed by sample counts
+    uint64_t checksum;
+};
+
+static_assert(std::is_trivially_copyable_v<CheckpointHeader>);
+
+AccumulationBuffer::AccumulationBuffer(uint32_t width, uint32_t height, SamplerType sampler_type, uint32_t samples_per_pass, uint64_t scene_key)
+  : width(width),
+    height(height),
+    sums((size_t)width * height * 3, 0.0f),
+    sample_counts((size_t)width * height, 0),
+    pass_index(0),
+    sampler_type(sampler_type),
+    samples_per_pass(samples_per_pass),
+    scene_key(scene_key) { }
+
+void AccumulationBuffer::Resolve(const ResolveSettings& settings, uint8_t* out_pixels) const {
+    // a row at a time so the linear copy stays small
+    std::vector<float> row((size_t)width * 4);
+    for (uint32_t y = 0; y < height; y++) {
+        size_t i_start = (size_t)y * width;
+        for (uint32_t x = 0; x < width; x++) {
+            size_t i = i_start + x;
+            Vec3f color(sums[i * 3 + 0], sums[i * 3 + 1], sums[i * 3 + 2]);
+            if (sample_counts[i] > 0) {
+                color /= (float)sample_counts[i];
+            }
+
+            row[x * 4 + 0] = color.x;
+            row[x * 4 + 1] = color.y;
+            row[x * 4 + 2] = color.z;
+            row[x * 4 + 3] = 1.0f;
+        }
+
+        Resolve::ResolvePixels(row.data(), (uint32_t)i_start, width, width, settings, out_pixels + i_start * 4);
+    }
+}
+
+bool AccumulationBuffer::WriteCheckpoint(const char* path, std::string* out_error) const {
+    size_t sums_size = sums.size() * sizeof(float);
+    size_t counts_size = sample_counts.size() * sizeof(uint32_t);
+
+    CheckpointHeader header;
+    memset((void*)&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.byte_order = CHECKPOINT_BYTE_ORDER;
+    header.width = width;
+    header.height = height;
+    header.sampler_type = (uint32_t)sampler_type;
+    header.samples_per_pass = samples_per_pass;
+    header.pass_index = pass_index;
+    header.scene_key = scene_key;
+    header.checksum = Hash::fnv1a(sample_counts.data(), counts_size, Hash::fnv1a(sums.data(), sums_size));
+
+    // the rename only counts as done once the data it points at is
+    //   on disk, otherwise a power cut can leave an empty checkpoint
+    std::string temp_path = std::string(path) + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (file == nullptr) {
+        *out_error = "couldn't write \"" + temp_path + "\"";
+        return false;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(sums.data(), 1, sums_size, file) == sums_size &&
+              fwrite(sample_counts.data(), 1, counts_size, file) == counts_size &&
+              fflush(file) == 0;
+#ifdef RTRT_HAS_FSYNC
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    ok = (fclose(file) == 0) && ok;
+
+    std::error_code error;
+    if (!ok) {
+        *out_error = "couldn't write \"" + temp_path + "\"";
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        *out_error = "couldn't move checkpoint into place: " + error.message();
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    return true;
+}
+
+bool AccumulationBuffer::ReadCheckpoint(const char* path, std::string* out_error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        *out_error = std::string("couldn't open \"") + path + "\"";
+        return false;
+    }
+
+    CheckpointHeader header;
+    if (!in.read((char*)&header, sizeof(header))) {
+        *out_error = "checkpoint is truncated";
+        return false;
+    }
+
+    if (memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+        *out_error = "not a checkpoint";
+        return false;
+    }
+    if (header.byte_order != CHECKPOINT_BYTE_ORDER) {
+        *out_error = "checkpoint was written with a different byte order";
+        return false;
+    }
+    if (header.version != CHECKPOINT_VERSION) {
+        *out_error = "checkpoint was written by a different version";
+        return false;
+    }
+    if (header.width != width || header.height != height) {
+        *out_error = "checkpoint is for a different image size";
+        return false;
+    }
+    if (header.sampler_type != (uint32_t)sampler_type || header.samples_per_pass != samples_per_pass) {
+        *out_error = "checkpoint was made with different sampling settings";
+        return false;
+    }
+    if (header.scene_key != scene_key) {
+        *out_error = "checkpoint is for a different scene or camera";
+        return false;
+    }
+
+    // read into scratch space so a bad file leaves this buffer alone
+    std::vector<float> read_sums(sums.size());
+    std::vector<uint32_t> read_counts(sample_counts.size());
+    size_t sums_size = read_sums.size() * sizeof(float);
+    size_t counts_size = read_counts.size() * sizeof(uint32_t);
+    in.read((char*)read_sums.data(), sums_size);
+    in.read((char*)read_counts.data(), counts_size);
+    if (!in || in.peek() != std::ifstream::traits_type::eof()) {
+        *out_error = "checkpoint is the wrong size";
+        return false;
+    }
+
+    uint64_t checksum = Hash::fnv1a(read_counts.data(), counts_size, Hash::fnv1a(read_sums.data(), sums_size));
+    if (checksum != header.checksum) {
+        *out_error = "checkpoint is corrupt";
+        return false;
+    }
+
+    sums = std::move(read_sums);
+    sample_counts = std::move(read_counts);
+    pass_index = header.pass_index;
+    return true;
+}
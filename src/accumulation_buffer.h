@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "samplers/sampler.h"
+#include "vec3.h"
+#include "resolve.h"
+
+// float running sums of a progressive render plus everything needed to
+//   pick it back up exactly where it stopped. checkpoints are the raw
+//   sums, so a resumed render adds the exact same floats in the exact
+//   same order as one that never stopped and ends up bit identical
+class AccumulationBuffer {
+   private:
+    uint32_t width;
+    uint32_t height;
+    // rgb, summed in sample order per pixel
+    std::vector<float> sums;
+    std::vector<uint32_t> sample_counts;
+    uint32_t pass_index;
+    SamplerType sampler_type;
+    uint32_t samples_per_pass;
+    // identifies the scene and camera, a checkpoint from a
+    //   different setup is refused instead of blended in
+    uint64_t scene_key;
+
+   public:
+    AccumulationBuffer(uint32_t width, uint32_t height, SamplerType sampler_type, uint32_t samples_per_pass, uint64_t scene_key);
+
+    void AddSamples(uint32_t pixel_index, const Vec3f& sum, uint32_t count) {
+        sums[pixel_index * 3 + 0] += sum.x;
+        sums[pixel_index * 3 + 1] += sum.y;
+        sums[pixel_index * 3 + 2] += sum.z;
+        sample_counts[pixel_index] += count;
+    }
+
+    void EndPass() { pass_index++; }
+
+    // averages into linear RGBA and resolves that into RGBA8
+    void Resolve(const ResolveSettings& settings, uint8_t* out_pixels) const;
+
+    // writes to a temporary file, flushes it to disk and renames it into
+    //   place, so a crash at any point leaves the previous checkpoint intact
+    bool WriteCheckpoint(const char* path, std::string* out_error) const;
+
+    // fails without touching the buffer if the file is damaged or was
+    //   made with a different size, sampler or scene
+    bool ReadCheckpoint(const char* path, std::string* out_error);
+
+    uint32_t get_width() const { return width; }
+    uint32_t get_height() const { return height; }
+    uint32_t get_pass_index() const { return pass_index; }
+    uint32_t get_samples_per_pass() const { return samples_per_pass; }
+    uint32_t get_sample_count(uint32_t pixel_index) const { return sample_counts[pixel_index]; }
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// std allocator that hands out memory aligned to Alignment bytes,
+//   used to start hot arrays on a cache line boundary
+template <typename T, size_t Alignment>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) { }
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* ptr, size_t count) {
+        ::operator delete(ptr, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, CACHE_LINE_SIZE>>;
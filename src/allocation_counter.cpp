@@ -0,0 +1,84 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// relaxed since it's only ever compared between two points a thread
+//   pool Wait (or something else that synchronizes) apart
+static std::atomic<uint64_t> allocation_count(0);
+
+static void* allocate(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    // malloc(0) is allowed to return null, new isn't
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+static void* allocate_aligned(size_t size, std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    // aligned_alloc wants the size to be a multiple of the alignment
+    size_t align = (size_t)alignment;
+    size_t rounded = (size + align - 1) / align * align;
+    void* ptr = std::aligned_alloc(align, rounded == 0 ? align : rounded);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+uint64_t AllocationCounter::get_count() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+// the nothrow and array forms all forward to these
+//   in the standard library so they're counted too
+
+void* operator new(size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return allocate_aligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return allocate_aligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+
+// counts every heap allocation the process makes. allocation_counter.cpp
+//   replaces the global operator new, so this works for all code
+//   including the standard library's containers
+namespace AllocationCounter {
+    // allocations since startup, read it before and after
+    //   something to see how many that made
+    uint64_t get_count();
+};
@@ -0,0 +1,1326 @@
+#include "benchmark.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <string>
+#include "renderer.h"
+#include "scenes.h"
+#include "perf_counters.h"
+#include "ray_stats.h"
+#include "samplers/hash.h"
+#include "materials/lambertian.h"
+#include "materials/metal.h"
+#include "math_utils.h"
+#include "transform.h"
+#include "scene_file/scene_loader.h"
+#include "resolve.h"
+#include "upscaler.h"
+#include "interval.h"
+#include "allocation_counter.h"
+#include "cpu_topology.h"
+#include "frame_pipeline.h"
+#include "objects/sphere.h"
+#include "objects/blas.h"
+#include <thread>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+
+constexpr uint32_t BENCH_WIDTH = 200;
+constexpr uint32_t BENCH_HEIGHT = 150;
+constexpr uint32_t REFERENCE_SPP = 4096;
+// independent samples from another seed, so no sampler being measured
+//   shares samples with the reference
+constexpr uint32_t REFERENCE_SEED = 0x7e5ca1e5;
+constexpr uint32_t MAX_BENCH_SPP = 64;
+constexpr uint32_t PERF_BENCH_SPP = 8;
+constexpr uint32_t PERF_BENCH_FRAMES = 3;
+
+constexpr uint32_t REFIT_SPHERE_GRID = 48;
+constexpr uint32_t REFIT_INSTANCE_COUNT = 1024;
+constexpr uint32_t REFIT_FRAMES = 240;
+// trace a frame this often to see how traversal degrades
+constexpr uint32_t REFIT_TRACE_INTERVAL = 24;
+constexpr uint32_t REFIT_TRACE_WIDTH = 100;
+constexpr uint32_t REFIT_TRACE_HEIGHT = 75;
+constexpr float REFIT_FRAME_TIME = 1.0f / 30.0f;
+constexpr float REFIT_WANDER_DISTANCE = 3.0f;
+
+constexpr uint32_t INCREMENTAL_SPP = 8;
+constexpr uint32_t INCREMENTAL_EDIT_SPHERE = 40;
+constexpr float INCREMENTAL_MOVE_DISTANCE = 0.3f;
+
+// wide enough for the periphery to matter
+constexpr uint32_t VRS_WIDTH = 960;
+constexpr uint32_t VRS_HEIGHT = 540;
+constexpr uint32_t VRS_SPP = 8;
+// square around the centre the fovea error is measured in, as a
+//   fraction of the height. inside the full rate radius
+constexpr float VRS_FOVEA_SIZE = 0.25f;
+
+constexpr uint32_t SCENE_FILE_GRID = 500;
+constexpr uint32_t SCENE_FILE_INSTANCES = 10000;
+constexpr uint32_t SCENE_FILE_MATERIALS = 64;
+constexpr uint32_t SCENE_FILE_LOADS = 5;
+
+// enough passes over a 4K frame for the timings to settle
+constexpr uint32_t RESOLVE_PASSES = 20;
+constexpr float RESOLVE_MAX_RADIANCE = 4.0f;
+
+constexpr uint32_t UPSCALE_PASSES = 20;
+constexpr float UPSCALE_LOW_RES_SCALES[] = {0.1f, 0.5f};
+// blocks of the fake G-buffer, roughly object sized at the low res scale
+constexpr uint32_t UPSCALE_OBJECT_SIZE = 7;
+
+constexpr uint32_t SCALING_WIDTH = 320;
+constexpr uint32_t SCALING_HEIGHT = 240;
+constexpr uint32_t SCALING_SPP = 8;
+// best of this many frames per pool
+constexpr uint32_t SCALING_FRAMES = 3;
+
+constexpr uint32_t PIPELINE_WIDTH = 400;
+constexpr uint32_t PIPELINE_HEIGHT = 300;
+constexpr uint32_t PIPELINE_FRAMES = 60;
+constexpr double PIPELINE_FRAME_BUDGET_MS = 10.0;
+// stands in for a present that blocks on vsync
+constexpr double PIPELINE_PRESENT_MS = 8.0;
+constexpr uint32_t PIPELINE_MAX_DEPTH = 3;
+
+constexpr uint32_t INTERSECTION_RAY_COUNT = 1 << 12;
+constexpr uint32_t INTERSECTION_SPHERE_COUNT = 64;
+constexpr uint32_t INTERSECTION_BOX_COUNT = 64;
+constexpr uint32_t INTERSECTION_PASSES = 32;
+// spheres per side of the Blas grid
+constexpr uint32_t INTERSECTION_BLAS_GRID = 24;
+// length of the rays that don't take the unit length path
+constexpr float INTERSECTION_RAY_SCALE = 2.5f;
+
+constexpr uint32_t PRESET_WIDTH = 320;
+constexpr uint32_t PRESET_HEIGHT = 240;
+constexpr uint32_t PRESET_SPP = 8;
+// best of this many frames per kernel
+constexpr uint32_t PRESET_FRAMES = 3;
+
+// frames before counting, for buffers that are created on first use
+constexpr uint32_t ALLOCATION_WARMUP_FRAMES = 3;
+constexpr uint32_t ALLOCATION_FRAMES = 20;
+constexpr uint32_t ALLOCATION_SPP = 2;
+constexpr float ALLOCATION_CAMERA_STEP = 0.02f;
+
+constexpr uint32_t DISPATCH_HIT_COUNT = 1 << 14;
+constexpr uint32_t DISPATCH_PASSES = 64;
+constexpr uint32_t DISPATCH_MATERIAL_COUNT = 16;
+
+struct BenchScene {
+    const char* name;
+    HittableList objects;
+    CompiledScene compiled;
+};
+
+static std::vector<BenchScene> get_bench_scenes() {
+    std::vector<BenchScene> scenes;
+    scenes.push_back({"default", Scenes::create_default(), {}});
+    scenes.push_back({"random_spheres", Scenes::create_random_spheres(12, 1), {}});
+    scenes.push_back({"instanced", Scenes::create_instanced(144, 1), {}});
+
+    for (BenchScene& scene : scenes) {
+        scene.compiled = CompiledScene::Compile(scene.objects);
+    }
+
+    return scenes;
+}
+
+static double get_rmse(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    double sum = 0.0;
+    uint32_t count = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        // skip alpha
+        if (i % 4 == 3) continue;
+
+        double diff = ((double)a[i] - (double)b[i]) / 255.0;
+        sum += diff * diff;
+        count++;
+    }
+
+    return std::sqrt(sum / count);
+}
+
+// linear radiance of every pixel, averaged from RenderRegion's sums so
+//   there's no tone map or quantization in the way
+static std::vector<float> render_linear(Renderer* renderer, const Camera& camera, const CompiledScene& scene) {
+    std::vector<float> linear((size_t)BENCH_WIDTH * BENCH_HEIGHT * 3);
+    renderer->RenderRegion(0, 0, BENCH_WIDTH, BENCH_HEIGHT, camera, scene, linear.data());
+    for (float& value : linear) {
+        value /= (float)renderer->get_samples_per_pixel();
+    }
+
+    return linear;
+}
+
+static double get_linear_rmse(const std::vector<float>& a, const std::vector<float>& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        double diff = (double)a[i] - (double)b[i];
+        sum += diff * diff;
+    }
+
+    return std::sqrt(sum / a.size());
+}
+
+void Benchmark::RunSamplerConvergence() {
+    HittableList objects = Scenes::create_default();
+    CompiledScene scene = CompiledScene::Compile(objects);
+    Camera camera = Scenes::create_default_camera((float)BENCH_WIDTH / BENCH_HEIGHT);
+    Renderer renderer(BENCH_WIDTH, BENCH_HEIGHT, 1.0f);
+
+    std::cout << "=== sampler convergence (linear RMSE vs spp, "
+              << BENCH_WIDTH << "x" << BENCH_HEIGHT << ", reference "
+              << REFERENCE_SPP << "spp independent, own seed) ===\n";
+
+    uint32_t seed = renderer.get_sampler_seed();
+    renderer.set_sampler_type(SamplerType::Independent);
+    renderer.set_sampler_seed(REFERENCE_SEED);
+    renderer.set_samples_per_pixel(REFERENCE_SPP);
+    std::vector<float> reference = render_linear(&renderer, camera, scene);
+    renderer.set_sampler_seed(seed);
+
+    const SamplerType types[] = {
+        SamplerType::Independent,
+        SamplerType::Stratified,
+        SamplerType::Sobol,
+        SamplerType::BlueNoise
+    };
+
+    std::cout << std::setw(8) << "spp";
+    for (SamplerType type : types) {
+        std::cout << std::setw(14) << sampler_type_name(type);
+    }
+    std::cout << "\n";
+
+    for (uint32_t spp = 1; spp <= MAX_BENCH_SPP; spp *= 2) {
+        std::cout << std::setw(8) << spp;
+        for (SamplerType type : types) {
+            renderer.set_sampler_type(type);
+            renderer.set_samples_per_pixel(spp);
+            std::vector<float> image = render_linear(&renderer, camera, scene);
+            std::cout << std::setw(14) << std::fixed << std::setprecision(5) << get_linear_rmse(image, reference);
+        }
+        std::cout << "\n";
+    }
+}
+
+static void print_perf_row(const std::string& label, const PerfValues& v, double rays) {
+    auto get = [&v](PerfEvent event) { return (double)v.values[(uint32_t)event]; };
+    auto valid = [&v](PerfEvent event) { return v.valid[(uint32_t)event]; };
+    auto print_per_ray = [&](PerfEvent event) {
+        if (valid(event)) {
+            std::cout << std::setw(14) << std::setprecision(3) << get(event) / rays;
+        } else {
+            std::cout << std::setw(14) << "n/a";
+        }
+    };
+
+    std::cout << std::left << std::setw(12) << label << std::right << std::fixed;
+
+    if (valid(PerfEvent::Cycles)) {
+        std::cout << std::setw(14) << std::setprecision(0) << get(PerfEvent::Cycles);
+    } else {
+        std::cout << std::setw(14) << "n/a";
+    }
+
+    if (valid(PerfEvent::Cycles) && valid(PerfEvent::Instructions) && get(PerfEvent::Cycles) > 0) {
+        std::cout << std::setw(10) << std::setprecision(2) << get(PerfEvent::Instructions) / get(PerfEvent::Cycles);
+    } else {
+        std::cout << std::setw(10) << "n/a";
+    }
+
+    print_per_ray(PerfEvent::L1DMisses);
+    print_per_ray(PerfEvent::LLCMisses);
+    print_per_ray(PerfEvent::BranchMisses);
+    std::cout << "\n";
+}
+
+void Benchmark::RunHardwareCounters() {
+    Renderer renderer(BENCH_WIDTH, BENCH_HEIGHT, 1.0f);
+    renderer.set_samples_per_pixel(PERF_BENCH_SPP);
+
+    const std::vector<int32_t>& thread_ids = renderer.get_thread_pool().get_worker_thread_ids();
+    std::vector<std::unique_ptr<PerfCounters>> counters;
+    bool available = false;
+    for (int32_t thread_id : thread_ids) {
+        counters.push_back(std::make_unique<PerfCounters>(thread_id));
+        available = available || counters.back()->is_available();
+    }
+
+    std::cout << "=== hardware counters (" << BENCH_WIDTH << "x" << BENCH_HEIGHT << ", "
+              << PERF_BENCH_SPP << "spp, " << PERF_BENCH_FRAMES << " frames, "
+              << thread_ids.size() << " threads) ===\n";
+
+    if (!available) {
+        std::cout << "hardware counters unavailable ("
+                  << (counters.empty() ? std::string("no worker threads") : counters[0]->get_error())
+                  << "), reporting wall clock only\n";
+    }
+
+    Camera camera = Scenes::create_default_camera((float)BENCH_WIDTH / BENCH_HEIGHT);
+    std::vector<uint8_t> image(BENCH_WIDTH * BENCH_HEIGHT * 4);
+
+    for (const BenchScene& scene : get_bench_scenes()) {
+        std::vector<PerfValues> thread_values(counters.size(), PerfValues {});
+        double total_ms = 0.0;
+        double rays = 0.0;
+
+        for (uint32_t frame = 0; frame < PERF_BENCH_FRAMES; frame++) {
+            for (auto& c : counters) c->Start();
+            auto start = std::chrono::steady_clock::now();
+
+            renderer.RenderImage(image.data(), camera, scene.compiled);
+
+            total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            for (auto& c : counters) c->Stop();
+
+            for (size_t i = 0; i < counters.size(); i++) {
+                thread_values[i] += counters[i]->Read();
+            }
+
+            // every ray when the stats are compiled in, otherwise
+            //   only the primary rays are known up front
+            if (RayStats::is_enabled()) {
+                rays += (double)RayStats::get_last_frame().get_total_rays();
+            } else {
+                rays += (double)BENCH_WIDTH * BENCH_HEIGHT * PERF_BENCH_SPP;
+            }
+        }
+
+        std::cout << "--- " << scene.name << ": "
+                  << std::fixed << std::setprecision(2) << total_ms / PERF_BENCH_FRAMES << " ms/frame, "
+                  << rays / (total_ms / 1000.0) / 1e6 << " M" << (RayStats::is_enabled() ? "" : " primary")
+                  << " rays/sec\n";
+
+        if (!available) continue;
+
+        std::string per_ray = RayStats::is_enabled() ? "/ray" : "/prim ray";
+        std::cout << std::left << std::setw(12) << "thread" << std::right
+                  << std::setw(14) << "cycles"
+                  << std::setw(10) << "IPC"
+                  << std::setw(14) << ("L1D" + per_ray)
+                  << std::setw(14) << ("LLC" + per_ray)
+                  << std::setw(14) << ("brmiss" + per_ray) << "\n";
+
+        // rays aren't tracked per thread, so each thread's misses are
+        //   divided by an even share of the frame's rays
+        PerfValues total {};
+        double rays_per_thread = rays / counters.size();
+        for (size_t i = 0; i < counters.size(); i++) {
+            print_perf_row(std::to_string(i), thread_values[i], rays_per_thread);
+            total += thread_values[i];
+        }
+        print_perf_row("total", total, rays);
+    }
+}
+
+void Benchmark::RunMaterialDispatch() {
+    // a mix of both material types in random order, like the hits
+    //   of a frame would be
+    std::vector<std::shared_ptr<Material>> owned;
+    MaterialTable table;
+    uint32_t state = 7;
+    auto rand = [&state]() {
+        state = Hash::mix(state + 1);
+        return Hash::to_unit_float(state);
+    };
+
+    for (uint32_t i = 0; i < DISPATCH_MATERIAL_COUNT; i++) {
+        if (i % 2 == 0) {
+            owned.push_back(std::make_shared<Lambertian>(Vec3f(rand(), rand(), rand())));
+        } else {
+            owned.push_back(std::make_shared<Metal>(Vec3f(rand(), rand(), rand()), rand()));
+        }
+        table.Add(owned.back());
+    }
+
+    std::vector<HitData> hits(DISPATCH_HIT_COUNT);
+    std::vector<Ray> in_rays;
+    for (uint32_t i = 0; i < DISPATCH_HIT_COUNT; i++) {
+        uint32_t m = (uint32_t)(rand() * DISPATCH_MATERIAL_COUNT) % DISPATCH_MATERIAL_COUNT;
+        hits[i].point = Vec3f(rand(), rand(), rand());
+        hits[i].normal = Vec3f::normalize(Vec3f(rand() - 0.5f, rand() + 0.1f, rand() - 0.5f));
+        hits[i].material = owned[m].get();
+        hits[i].material_index = m;
+        hits[i].t = 1.0f;
+        hits[i].front_face = true;
+        in_rays.emplace_back(Vec3f(0.0f), hits[i].point - hits[i].normal * 2.0f);
+    }
+
+    std::unique_ptr<Sampler> sampler = create_sampler(SamplerType::Independent, 1, 1);
+
+    auto run = [&](bool use_table) {
+        Vec3f sum(0.0f);
+        uint32_t accepted = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        for (uint32_t pass = 0; pass < DISPATCH_PASSES; pass++) {
+            for (uint32_t i = 0; i < DISPATCH_HIT_COUNT; i++) {
+                sampler->StartSample(i, pass, 0);
+
+                Vec3f attenuation;
+                Ray scattered({0, 0, 0}, {0, 0, 0});
+                bool did_scatter = use_table
+                                       ? table.Scatter(hits[i].material_index, in_rays[i], hits[i], *sampler, &attenuation, &scattered)
+                                       : hits[i].material->Scatter(in_rays[i], hits[i], *sampler, &attenuation, &scattered);
+
+                accepted += did_scatter;
+                sum += attenuation + scattered.get_direction();
+            }
+        }
+
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        // print the sums so the work can't be optimized away
+        std::cout << std::left << std::setw(10) << (use_table ? "table" : "virtual") << std::right
+                  << std::setw(12) << std::fixed << std::setprecision(2) << ns / ((double)DISPATCH_HIT_COUNT * DISPATCH_PASSES) << " ns/scatter"
+                  << "   (checksum " << std::setprecision(1) << sum.x + sum.y + sum.z << ", " << accepted << " accepted)\n";
+    };
+
+    std::cout << "=== material dispatch (" << DISPATCH_MATERIAL_COUNT << " materials, "
+              << DISPATCH_HIT_COUNT * DISPATCH_PASSES << " scatters, table is "
+              << table.get_count() * sizeof(MaterialRecord) << " bytes) ===\n";
+    run(false);
+    run(true);
+}
+
+struct RefitPolicy {
+    const char* name;
+    float rebuild_threshold;
+};
+
+void Benchmark::RunBvhRefit() {
+    const RefitPolicy policies[] = {
+        {"rebuild", 0.0f},
+        {"refit", INFINITY_F},
+        {"auto", CompiledScene().get_rebuild_threshold()}
+    };
+
+    Camera camera = Scenes::create_default_camera((float)REFIT_TRACE_WIDTH / REFIT_TRACE_HEIGHT);
+    Renderer renderer(REFIT_TRACE_WIDTH, REFIT_TRACE_HEIGHT, 1.0f);
+    renderer.set_samples_per_pixel(1);
+    std::vector<uint8_t> pixels(REFIT_TRACE_WIDTH * REFIT_TRACE_HEIGHT * 4);
+
+    std::cout << "=== bvh refit vs rebuild (" << REFIT_FRAMES << " animated frames, trace every "
+              << REFIT_TRACE_INTERVAL << " at " << REFIT_TRACE_WIDTH << "x" << REFIT_TRACE_HEIGHT << " 1spp) ===\n";
+    std::cout << std::left << std::setw(24) << "scene/policy" << std::right
+              << std::setw(14) << "update ms" << std::setw(10) << "rebuilds"
+              << std::setw(14) << "trace ms 0" << std::setw(14) << "trace ms end"
+              << std::setw(10) << "slowdown" << std::setw(10) << "sah" << "\n";
+
+    HittableList sphere_objects = Scenes::create_random_spheres(REFIT_SPHERE_GRID, 1);
+    HittableList instance_objects = Scenes::create_instanced(REFIT_INSTANCE_COUNT, 1);
+
+    for (uint32_t scene_kind = 0; scene_kind < 2; scene_kind++) {
+        bool animate_instances = scene_kind == 1;
+
+        for (const RefitPolicy& policy : policies) {
+            CompiledScene scene = CompiledScene::Compile(animate_instances ? instance_objects : sphere_objects);
+            scene.set_rebuild_threshold(policy.rebuild_threshold);
+
+            // every object wanders on its own circle so neighbours in
+            //   the tree drift apart, sphere 0 is the ground and stays put
+            uint32_t count = animate_instances ? scene.get_instance_count() : scene.get_sphere_count();
+            uint32_t first = animate_instances ? 0 : 1;
+            std::vector<Vec3f> base_centers;
+            std::vector<Transform> base_transforms;
+            for (uint32_t i = 0; i < count; i++) {
+                if (animate_instances) {
+                    base_transforms.push_back(scene.get_instance_transform(i));
+                } else {
+                    base_centers.push_back(scene.get_sphere_center(i));
+                }
+            }
+
+            double update_ms = 0.0;
+            uint32_t rebuilds = 0;
+            double first_trace_ms = 0.0;
+            double last_trace_ms = 0.0;
+
+            for (uint32_t frame = 0; frame < REFIT_FRAMES; frame++) {
+                float time = frame * REFIT_FRAME_TIME;
+
+                auto start = std::chrono::steady_clock::now();
+                for (uint32_t i = first; i < count; i++) {
+                    float speed = 0.5f + Hash::to_unit_float(Hash::mix(i));
+                    float phase = Hash::to_unit_float(Hash::mix(i + count)) * 2.0f * Utils::PI;
+                    Vec3f offset(
+                        (std::cos(time * speed + phase) - std::cos(phase)) * REFIT_WANDER_DISTANCE,
+                        0.0f,
+                        (std::sin(time * speed + phase) - std::sin(phase)) * REFIT_WANDER_DISTANCE
+                    );
+
+                    if (animate_instances) {
+                        scene.SetInstanceTransform(i, Transform::translate(offset) * base_transforms[i]);
+                    } else {
+                        scene.SetSphereCenter(i, base_centers[i] + offset);
+                    }
+                }
+
+                CompiledScene::UpdateResult result = scene.Update(&renderer.get_thread_pool());
+                update_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                rebuilds += (result.world == BvhUpdate::Rebuild) + (result.tlas == BvhUpdate::Rebuild);
+
+                if (frame % REFIT_TRACE_INTERVAL == 0 || frame == REFIT_FRAMES - 1) {
+                    auto trace_start = std::chrono::steady_clock::now();
+                    renderer.RenderImage(pixels.data(), camera, scene);
+                    last_trace_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - trace_start).count();
+                    if (frame == 0) first_trace_ms = last_trace_ms;
+                }
+            }
+
+            float quality = animate_instances ? scene.GetTlasQualityRatio() : scene.GetWorldQualityRatio();
+            std::string label = std::string(animate_instances ? "instances" : "spheres") + "/" + policy.name;
+            std::cout << std::left << std::setw(24) << label << std::right << std::fixed
+                      << std::setw(14) << std::setprecision(3) << update_ms / REFIT_FRAMES
+                      << std::setw(10) << rebuilds
+                      << std::setw(14) << std::setprecision(2) << first_trace_ms
+                      << std::setw(14) << last_trace_ms
+                      << std::setw(10) << last_trace_ms / first_trace_ms
+                      << std::setw(10) << quality << "\n";
+        }
+    }
+}
+
+void Benchmark::RunIncremental() {
+    HittableList objects = Scenes::create_random_spheres(12, 1);
+    CompiledScene scene = CompiledScene::Compile(objects);
+    Camera camera = Scenes::create_default_camera((float)BENCH_WIDTH / BENCH_HEIGHT);
+    Renderer renderer(BENCH_WIDTH, BENCH_HEIGHT, 1.0f);
+    renderer.set_samples_per_pixel(INCREMENTAL_SPP);
+
+    std::vector<uint8_t> incremental(BENCH_WIDTH * BENCH_HEIGHT * 4);
+    std::vector<uint8_t> reference(BENCH_WIDTH * BENCH_HEIGHT * 4);
+
+    std::cout << "=== incremental re-render (" << BENCH_WIDTH << "x" << BENCH_HEIGHT << ", "
+              << INCREMENTAL_SPP << "spp, " << renderer.get_tile_count() << " tiles) ===\n";
+    std::cout << std::left << std::setw(12) << "edit" << std::right
+              << std::setw(10) << "tiles" << std::setw(14) << "dirty ms"
+              << std::setw(14) << "full ms" << std::setw(10) << "speedup"
+              << std::setw(14) << "rmse" << "\n";
+
+    auto start = std::chrono::steady_clock::now();
+    renderer.RenderImage(incremental.data(), camera, scene);
+    double full_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    auto report = [&](const char* edit) {
+        uint32_t dirty = renderer.GetDirtyTileCount();
+        auto dirty_start = std::chrono::steady_clock::now();
+        renderer.RenderDirty(incremental.data(), camera, scene);
+        double dirty_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - dirty_start).count();
+
+        // a full render of the edited scene, anything the
+        //   invalidation missed shows up as error here
+        auto full_start = std::chrono::steady_clock::now();
+        renderer.RenderImage(reference.data(), camera, scene);
+        full_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - full_start).count();
+
+        std::cout << std::left << std::setw(12) << edit << std::right << std::fixed
+                  << std::setw(10) << dirty
+                  << std::setw(14) << std::setprecision(2) << dirty_ms
+                  << std::setw(14) << full_ms
+                  << std::setw(10) << full_ms / std::max(dirty_ms, 1e-3)
+                  << std::setw(14) << std::setprecision(5) << get_rmse(incremental, reference) << "\n";
+
+        incremental = reference;
+    };
+
+    // material colour, everything that saw the material is redone
+    uint32_t material_index = scene.get_materials().get_count() / 2;
+    MaterialRecord record = scene.get_materials().get_record(material_index);
+    record.albedo = Vec3f(0.1f, 0.9f, 0.2f);
+    scene.SetMaterial(material_index, record);
+    renderer.InvalidateMaterial(material_index);
+    report("material");
+
+    // move a sphere, tiles that saw it before plus its new footprint
+    uint32_t sphere = INCREMENTAL_EDIT_SPHERE;
+    renderer.InvalidateObject(scene.get_sphere_object_id(sphere));
+    scene.SetSphereCenter(sphere, scene.get_sphere_center(sphere) + Vec3f(INCREMENTAL_MOVE_DISTANCE, 0, 0));
+    scene.Update();
+    renderer.InvalidateBounds(scene.GetSphereBounds(sphere));
+    report("move");
+}
+
+void Benchmark::RunVariableRate() {
+    HittableList objects = Scenes::create_random_spheres(12, 1);
+    CompiledScene scene = CompiledScene::Compile(objects);
+    Camera camera = Scenes::create_default_camera((float)VRS_WIDTH / VRS_HEIGHT);
+
+    std::vector<uint8_t> reference(VRS_WIDTH * VRS_HEIGHT * 4);
+    std::vector<uint8_t> image(VRS_WIDTH * VRS_HEIGHT * 4);
+
+    uint32_t fovea_size = (uint32_t)(VRS_HEIGHT * VRS_FOVEA_SIZE);
+    uint32_t fovea_x = (VRS_WIDTH - fovea_size) / 2;
+    uint32_t fovea_y = (VRS_HEIGHT - fovea_size) / 2;
+    auto get_fovea_rmse = [&]() {
+        double sum = 0.0;
+        for (uint32_t y = fovea_y; y < fovea_y + fovea_size; y++) {
+            for (uint32_t x = fovea_x; x < fovea_x + fovea_size; x++) {
+                for (uint32_t c = 0; c < 3; c++) {
+                    size_t i = ((size_t)y * VRS_WIDTH + x) * 4 + c;
+                    double diff = ((double)image[i] - (double)reference[i]) / 255.0;
+                    sum += diff * diff;
+                }
+            }
+        }
+        return std::sqrt(sum / ((double)fovea_size * fovea_size * 3));
+    };
+
+    std::cout << "=== variable rate shading (" << VRS_WIDTH << "x" << VRS_HEIGHT << ", " << VRS_SPP << "spp) ===\n";
+    std::cout << std::left << std::setw(12) << "source" << std::right
+              << std::setw(12) << "ms" << std::setw(10) << "speedup" << std::setw(8) << "passes"
+              << std::setw(14) << "rmse" << std::setw(14) << "fovea rmse" << "\n";
+
+    const ShadingRateSource sources[] = {ShadingRateSource::Off, ShadingRateSource::Center, ShadingRateSource::Variance};
+    double full_rate_ms = 0.0;
+    for (ShadingRateSource source : sources) {
+        Renderer renderer(VRS_WIDTH, VRS_HEIGHT, 1.0f);
+        renderer.set_samples_per_pixel(VRS_SPP);
+        renderer.set_shading_rate_source(source);
+
+        // variance shades coarse first and refines on later passes,
+        //   so keep going until nothing is left dirty
+        auto start = std::chrono::steady_clock::now();
+        std::vector<uint8_t>& out = source == ShadingRateSource::Off ? reference : image;
+        renderer.RenderImage(out.data(), camera, scene);
+        uint32_t passes = 1;
+        while (renderer.RenderDirty(out.data(), camera, scene) > 0) {
+            passes++;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (source == ShadingRateSource::Off) {
+            full_rate_ms = ms;
+            image = reference;
+        }
+
+        std::cout << std::left << std::setw(12) << ShadingRate::source_name(source) << std::right << std::fixed
+                  << std::setw(12) << std::setprecision(2) << ms
+                  << std::setw(10) << full_rate_ms / std::max(ms, 1e-3)
+                  << std::setw(8) << passes
+                  << std::setw(14) << std::setprecision(5) << get_rmse(image, reference)
+                  << std::setw(14) << get_fovea_rmse() << "\n";
+    }
+}
+
+static bool write_bench_scene_file(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    out << "# generated by --bench scene_file\n";
+    out << "camera 0 2 -8  1 2  look_at 0 0 0\n";
+    for (uint32_t i = 0; i < SCENE_FILE_MATERIALS; i++) {
+        float r = Hash::to_unit_float(Hash::mix(i * 3 + 0));
+        float g = Hash::to_unit_float(Hash::mix(i * 3 + 1));
+        float b = Hash::to_unit_float(Hash::mix(i * 3 + 2));
+        if (i % 4 == 0) {
+            out << "material m" << i << " metal " << r << " " << g << " " << b << " " << r * 0.5f << "\n";
+        } else {
+            out << "material m" << i << " lambertian " << r << " " << g << " " << b << "\n";
+        }
+    }
+
+    float half = SCENE_FILE_GRID * 0.5f;
+    for (uint32_t z = 0; z < SCENE_FILE_GRID; z++) {
+        for (uint32_t x = 0; x < SCENE_FILE_GRID; x++) {
+            uint32_t h = Hash::mix(z * SCENE_FILE_GRID + x);
+            out << "sphere " << x - half << " -0.8 " << z - half << " 0.2 m" << h % SCENE_FILE_MATERIALS << "\n";
+        }
+    }
+
+    out << "asset rock\n";
+    out << "    sphere 0 0 0 0.3 m1\n";
+    out << "    sphere 0.25 0 0 0.12 m0\n";
+    out << "    sphere -0.2 0.1 0.1 0.15 m2\n";
+    out << "end\n";
+    for (uint32_t i = 0; i < SCENE_FILE_INSTANCES; i++) {
+        float x = (Hash::to_unit_float(Hash::mix(i * 2 + 0)) - 0.5f) * SCENE_FILE_GRID;
+        float z = (Hash::to_unit_float(Hash::mix(i * 2 + 1)) - 0.5f) * SCENE_FILE_GRID;
+        out << "instance rock " << x << " 0 " << z << " rotate 0 1 0 " << i % 360 << " scale 1 1 1\n";
+    }
+
+    return (bool)out;
+}
+
+void Benchmark::RunSceneFile() {
+    std::string path = (std::filesystem::temp_directory_path() / "rtrt_bench.scene").string();
+    std::string cache_path = SceneFile::get_cache_path(path.c_str());
+
+    std::cout << "=== scene file (" << SCENE_FILE_GRID * SCENE_FILE_GRID << " spheres, "
+              << SCENE_FILE_INSTANCES << " instances, best of " << SCENE_FILE_LOADS << ") ===\n";
+
+    if (!write_bench_scene_file(path)) {
+        std::cerr << "couldn't write \"" << path << "\"\n";
+        return;
+    }
+
+    double best_parse_ms = INFINITY_F;
+    double best_write_ms = INFINITY_F;
+    double best_cache_ms = INFINITY_F;
+    size_t scene_bytes = 0;
+    bool caches_match = true;
+    std::string error;
+
+    for (uint32_t i = 0; i < SCENE_FILE_LOADS; i++) {
+        // without a cache this parses and writes one
+        std::filesystem::remove(cache_path);
+        SceneFile::LoadedScene parsed;
+        SceneFile::LoadReport parse_report;
+        if (!SceneFile::Load(path.c_str(), &parsed, &parse_report, &error)) {
+            std::cerr << error << "\n";
+            return;
+        }
+
+        SceneFile::LoadedScene cached;
+        SceneFile::LoadReport cache_report;
+        if (!SceneFile::Load(path.c_str(), &cached, &cache_report, &error) || !cache_report.from_cache) {
+            std::cerr << "cache wasn't used: " << (error.empty() ? cache_report.cache_message : error) << "\n";
+            return;
+        }
+
+        best_parse_ms = std::min(best_parse_ms, parse_report.parse_ms);
+        best_write_ms = std::min(best_write_ms, parse_report.cache_write_ms);
+        best_cache_ms = std::min(best_cache_ms, cache_report.cache_load_ms);
+        scene_bytes = parsed.view.get_byte_size();
+
+        // the cache has to hold exactly what was parsed
+        auto same = [](auto a, auto b) {
+            return a.size() == b.size() && memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+        };
+        caches_match &= same(parsed.view.materials, cached.view.materials) &&
+                         same(parsed.view.world_spheres, cached.view.world_spheres) &&
+                         same(parsed.view.asset_spheres, cached.view.asset_spheres) &&
+                         same(parsed.view.assets, cached.view.assets) &&
+                         same(parsed.view.instances, cached.view.instances);
+    }
+
+    double text_mb = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+    double cache_mb = std::filesystem::file_size(cache_path) / (1024.0 * 1024.0);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "text:  " << text_mb << " MB, parsed in " << best_parse_ms << " ms ("
+              << text_mb / (best_parse_ms / 1000.0) << " MB/s)\n";
+    std::cout << "cache: " << cache_mb << " MB, written in " << best_write_ms << " ms, mapped in "
+              << std::setprecision(3) << best_cache_ms << " ms\n";
+    std::cout << std::setprecision(2) << "scene data: " << scene_bytes / (1024.0 * 1024.0) << " MB, cache "
+              << (caches_match ? "matches" : "DOESN'T match") << " the parsed scene\n";
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(cache_path);
+}
+
+// what RenderBatch did per pixel before the resolve pass existed
+static void resolve_inline_gamma(const float* linear, uint32_t count, uint8_t* out_pixels) {
+    static const Interval intensity(0.0f, 1.0f);
+
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t c = 0; c < 3; c++) {
+            float v = Utils::correct_gamma(linear[i * 4 + c]);
+            out_pixels[i * 4 + c] = (uint8_t)(intensity.Clamp(v) * 255.0f);
+        }
+        out_pixels[i * 4 + 3] = 255;
+    }
+}
+
+void Benchmark::RunResolve() {
+    std::cout << "=== resolve pass throughput (single thread, " << (Resolve::is_simd() ? "SSE2" : "no SIMD") << ") ===\n";
+
+    struct Resolution {
+        const char* name;
+        uint32_t width;
+        uint32_t height;
+    };
+    const Resolution resolutions[] = {{"1080p", 1920, 1080}, {"4K", 3840, 2160}};
+
+    for (const Resolution& resolution : resolutions) {
+        uint32_t pixel_count = resolution.width * resolution.height;
+
+        // HDR noise so every branch of the curves and the clamp get hit
+        std::vector<float, AlignedAllocator<float, CACHE_LINE_SIZE>> linear((size_t)pixel_count * 4);
+        for (size_t i = 0; i < linear.size(); i++) {
+            linear[i] = Hash::to_unit_float(Hash::mix((uint32_t)i)) * RESOLVE_MAX_RADIANCE;
+        }
+
+        std::vector<uint8_t> simd_pixels((size_t)pixel_count * 4);
+        std::vector<uint8_t> scalar_pixels((size_t)pixel_count * 4);
+        double bytes_per_pass = (double)pixel_count * (4 * sizeof(float) + 4);
+
+        auto time_gb_per_s = [&](auto resolve) {
+            resolve();
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t pass = 0; pass < RESOLVE_PASSES; pass++) {
+                resolve();
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return bytes_per_pass * RESOLVE_PASSES / seconds / 1e9;
+        };
+
+        std::cout << resolution.name << " (" << resolution.width << "x" << resolution.height << ", "
+                  << std::fixed << std::setprecision(1) << bytes_per_pass / (1024.0 * 1024.0) << " MB per pass):\n";
+
+        double inline_gb_s = time_gb_per_s([&]() {
+            resolve_inline_gamma(linear.data(), pixel_count, scalar_pixels.data());
+        });
+        std::cout << std::setprecision(2) << "  old inline gamma      " << std::setw(6) << inline_gb_s << " GB/s\n";
+
+        for (ToneMap tone_map : {ToneMap::Clamp, ToneMap::Reinhard, ToneMap::Aces}) {
+            for (bool dither : {false, true}) {
+                ResolveSettings settings;
+                settings.tone_map = tone_map;
+                settings.dither = dither;
+
+                double simd_gb_s = time_gb_per_s([&]() {
+                    Resolve::ResolvePixels(linear.data(), 0, pixel_count, resolution.width, settings, simd_pixels.data());
+                });
+                double scalar_gb_s = time_gb_per_s([&]() {
+                    Resolve::ResolvePixelsScalar(linear.data(), 0, pixel_count, resolution.width, settings, scalar_pixels.data());
+                });
+
+                std::string label = std::string(Resolve::tone_map_name(tone_map)) + (dither ? " + dither" : "");
+                std::cout << "  " << std::left << std::setw(20) << label << std::right
+                          << "  " << std::setw(6) << simd_gb_s << " GB/s, scalar " << std::setw(6) << scalar_gb_s << " GB/s"
+                          << (simd_pixels == scalar_pixels ? "" : "  (OUTPUTS DIFFER)") << "\n";
+            }
+        }
+    }
+}
+
+// what CopyPixelsBatch did before the upscaler existed
+static void upscale_memcpy_nearest(const uint8_t* src, uint32_t src_width, float scale, uint32_t dst_width, uint32_t dst_height, uint8_t* dst) {
+    for (uint32_t i = 0; i < dst_width * dst_height; i++) {
+        uint32_t y = i / dst_width;
+        uint32_t x = i - (y * dst_width);
+        uint32_t sample_index = (uint32_t)(y * scale) * src_width + (uint32_t)(x * scale);
+        memcpy(&dst[(size_t)i * 4], &src[(size_t)sample_index * 4], 4);
+    }
+}
+
+void Benchmark::RunUpscale() {
+    std::cout << "=== upscale throughput (single thread, " << (Upscaler::has_avx2() ? "AVX2" : "no AVX2") << ") ===\n";
+
+    struct Resolution {
+        const char* name;
+        uint32_t width;
+        uint32_t height;
+    };
+    const Resolution resolutions[] = {{"1080p", 1920, 1080}, {"4K", 3840, 2160}};
+
+    for (const Resolution& resolution : resolutions) {
+        for (float scale : UPSCALE_LOW_RES_SCALES) {
+            uint32_t src_width = (uint32_t)(resolution.width * scale);
+            uint32_t src_height = (uint32_t)(resolution.height * scale);
+
+            // noise over a gradient with blocky objects in the G-buffer
+            std::vector<float, AlignedAllocator<float, CACHE_LINE_SIZE>> src((size_t)src_width * src_height * 4);
+            std::vector<GBufferSample> gbuffer((size_t)src_width * src_height);
+            for (uint32_t y = 0; y < src_height; y++) {
+                for (uint32_t x = 0; x < src_width; x++) {
+                    size_t i = (size_t)y * src_width + x;
+                    uint32_t object = (x / UPSCALE_OBJECT_SIZE) * 31 + (y / UPSCALE_OBJECT_SIZE);
+                    for (uint32_t c = 0; c < 3; c++) {
+                        src[i * 4 + c] = (float)((uint8_t)((x + y * c) + (Hash::mix((uint32_t)i * 3 + c) & 31))) / 255.0f;
+                    }
+                    src[i * 4 + 3] = 1.0f;
+                    gbuffer[i] = {1.0f + (float)(Hash::mix(object) % 8), object};
+                }
+            }
+
+            size_t dst_size = (size_t)resolution.width * resolution.height * 4;
+            std::vector<uint8_t, AlignedAllocator<uint8_t, CACHE_LINE_SIZE>> simd_pixels(dst_size);
+            std::vector<uint8_t, AlignedAllocator<uint8_t, CACHE_LINE_SIZE>> scalar_pixels(dst_size);
+            std::vector<uint8_t> low_res_pixels((size_t)src_width * src_height * 4);
+            Upscaler upscaler(src_width, src_height, resolution.width, resolution.height, 1);
+            ResolveSettings settings;
+
+            auto time_gb_per_s = [&](auto upscale) {
+                upscale();
+                auto start = std::chrono::steady_clock::now();
+                for (uint32_t pass = 0; pass < UPSCALE_PASSES; pass++) {
+                    upscale();
+                }
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                return (double)dst_size * UPSCALE_PASSES / seconds / 1e9;
+            };
+
+            std::cout << resolution.name << " from " << src_width << "x" << src_height << " (output GB/s):\n";
+
+            // the old path resolved at low res and copied bytes
+            double memcpy_gb_s = time_gb_per_s([&]() {
+                Resolve::ResolvePixels(src.data(), 0, src_width * src_height, src_width, settings, low_res_pixels.data());
+                upscale_memcpy_nearest(low_res_pixels.data(), src_width, scale, resolution.width, resolution.height, simd_pixels.data());
+            });
+            std::cout << std::fixed << std::setprecision(2) << "  old nearest memcpy  " << std::setw(6) << memcpy_gb_s << "\n";
+
+            for (UpscaleFilter filter : {UpscaleFilter::Nearest, UpscaleFilter::Bilinear, UpscaleFilter::EdgeAware}) {
+                upscaler.set_use_avx2(true);
+                double simd_gb_s = time_gb_per_s([&]() {
+                    upscaler.UpscaleRows(src.data(), gbuffer.data(), filter, settings, 0, resolution.height, 0, simd_pixels.data());
+                });
+                upscaler.set_use_avx2(false);
+                double scalar_gb_s = time_gb_per_s([&]() {
+                    upscaler.UpscaleRows(src.data(), gbuffer.data(), filter, settings, 0, resolution.height, 0, scalar_pixels.data());
+                });
+
+                std::cout << "  " << std::left << std::setw(18) << Upscaler::filter_name(filter) << std::right
+                          << "  " << std::setw(6) << simd_gb_s << ", scalar " << std::setw(6) << scalar_gb_s
+                          << (simd_pixels == scalar_pixels ? "" : "  (OUTPUTS DIFFER)") << "\n";
+            }
+        }
+    }
+}
+
+void Benchmark::RunThreadScaling() {
+    HittableList objects = Scenes::create_random_spheres(12, 1);
+    CompiledScene scene = CompiledScene::Compile(objects);
+    Camera camera = Scenes::create_default_camera((float)SCALING_WIDTH / SCALING_HEIGHT);
+    std::vector<uint8_t> pixels(SCALING_WIDTH * SCALING_HEIGHT * 4);
+
+    std::vector<CpuTopology::LogicalCpu> cpus = CpuTopology::get_logical_cpus();
+    std::vector<int32_t> nodes;
+    uint32_t core_count = 0;
+    for (size_t i = 0; i < cpus.size(); i++) {
+        bool same_core = i > 0 && cpus[i].package_id == cpus[i - 1].package_id && cpus[i].core_id == cpus[i - 1].core_id;
+        core_count += !same_core;
+        if (std::find(nodes.begin(), nodes.end(), cpus[i].numa_node) == nodes.end()) {
+            nodes.push_back(cpus[i].numa_node);
+        }
+    }
+
+    std::cout << "=== thread placement scaling (" << SCALING_WIDTH << "x" << SCALING_HEIGHT << ", " << SCALING_SPP << "spp, "
+              << cpus.size() << " cpus, " << core_count << " cores, " << nodes.size() << " numa nodes) ===\n";
+    std::cout << std::left << std::setw(12) << "placement" << std::right
+              << std::setw(8) << "threads" << std::setw(12) << "ms" << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << "\n";
+
+    auto run_placement = [&](const char* label, ThreadPlacement placement, uint32_t max_threads) {
+        double single_thread_ms = 0.0;
+        for (uint32_t threads = 1; ; threads = std::min(threads * 2, max_threads)) {
+            placement.thread_count = threads;
+            Renderer renderer(SCALING_WIDTH, SCALING_HEIGHT, 1.0f, placement);
+            renderer.set_samples_per_pixel(SCALING_SPP);
+
+            double best_ms = 0.0;
+            for (uint32_t frame = 0; frame < SCALING_FRAMES; frame++) {
+                auto start = std::chrono::steady_clock::now();
+                renderer.RenderImage(pixels.data(), camera, scene);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                best_ms = frame == 0 ? ms : std::min(best_ms, ms);
+            }
+
+            if (threads == 1) single_thread_ms = best_ms;
+            double speedup = single_thread_ms / std::max(best_ms, 1e-3);
+            std::cout << std::left << std::setw(12) << label << std::right << std::fixed
+                      << std::setw(8) << threads
+                      << std::setw(12) << std::setprecision(2) << best_ms
+                      << std::setw(10) << speedup
+                      << std::setw(11) << std::setprecision(0) << speedup / threads * 100.0 << "%\n";
+
+            if (threads == max_threads) break;
+        }
+    };
+
+    // unpinned gets as many threads as smt so the two line up
+    const ThreadPlacementPolicy policies[] = {ThreadPlacementPolicy::Unpinned, ThreadPlacementPolicy::Cores, ThreadPlacementPolicy::SmtThreads};
+    for (ThreadPlacementPolicy policy : policies) {
+        ThreadPlacement placement;
+        placement.policy = policy;
+        run_placement(CpuTopology::policy_name(policy), placement, policy == ThreadPlacementPolicy::Cores ? core_count : (uint32_t)cpus.size());
+    }
+
+    // one node's cores only, memory included, against the
+    //   same thread count spread over the whole machine
+    if (nodes.size() > 1) {
+        for (int32_t node : nodes) {
+            ThreadPlacement placement;
+            placement.policy = ThreadPlacementPolicy::Cores;
+            placement.numa_node = node;
+
+            std::vector<uint32_t> node_cpus;
+            std::string error;
+            if (node < 0 || !CpuTopology::select_cpus(placement, &node_cpus, &error)) continue;
+
+            std::string label = "node " + std::to_string(node);
+            run_placement(label.c_str(), placement, (uint32_t)node_cpus.size());
+        }
+    }
+}
+
+void Benchmark::RunFramePipeline() {
+    HittableList objects = Scenes::create_random_spheres(12, 1);
+    CompiledScene scene = CompiledScene::Compile(objects);
+    Camera camera = Scenes::create_default_camera((float)PIPELINE_WIDTH / PIPELINE_HEIGHT);
+
+    std::cout << "=== frame pipeline (" << PIPELINE_WIDTH << "x" << PIPELINE_HEIGHT << ", " << PIPELINE_FRAME_BUDGET_MS
+              << " ms frame budget, " << PIPELINE_PRESENT_MS << " ms present) ===\n";
+    std::cout << std::setw(6) << "depth" << std::setw(12) << "ms/frame" << std::setw(14) << "latency ms" << "\n";
+
+    for (uint32_t depth = 1; depth <= PIPELINE_MAX_DEPTH; depth++) {
+        Renderer renderer(PIPELINE_WIDTH, PIPELINE_HEIGHT, 1.0f);
+        renderer.set_frame_budget_ms(PIPELINE_FRAME_BUDGET_MS);
+
+        // submit times by frame, to see how long each took to reach the screen
+        std::vector<std::chrono::steady_clock::time_point> submitted(PIPELINE_FRAMES);
+        uint32_t presented = 0;
+        double latency_ms = 0.0;
+
+        FramePipeline pipeline(&renderer, PIPELINE_WIDTH, PIPELINE_HEIGHT, depth, [&](const uint8_t*) {
+            latency_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitted[presented++]).count();
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(PIPELINE_PRESENT_MS));
+            return true;
+        });
+
+        // every tile stays dirty so each frame uses its whole budget
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < PIPELINE_FRAMES; i++) {
+            pipeline.BeginFrame();
+            renderer.InvalidateAll();
+            submitted[i] = std::chrono::steady_clock::now();
+            pipeline.Submit(camera, scene);
+        }
+        pipeline.Drain();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::setw(6) << depth << std::fixed << std::setprecision(2)
+                  << std::setw(12) << ms / PIPELINE_FRAMES
+                  << std::setw(14) << latency_ms / PIPELINE_FRAMES << "\n";
+    }
+}
+
+// the slab test before rays carried their sign bits, min/max sorting
+//   the two planes of every axis
+static float aabb_hit_distance_min_max(const Aabb& box, const Vec3f& origin, const Vec3f& inv_dir, float t_min, float t_max) {
+    float tx0 = (box.min.x - origin.x) * inv_dir.x;
+    float tx1 = (box.max.x - origin.x) * inv_dir.x;
+    float ty0 = (box.min.y - origin.y) * inv_dir.y;
+    float ty1 = (box.max.y - origin.y) * inv_dir.y;
+    float tz0 = (box.min.z - origin.z) * inv_dir.z;
+    float tz1 = (box.max.z - origin.z) * inv_dir.z;
+
+    float t_enter = std::fmax(std::fmax(std::fmin(tx0, tx1), std::fmin(ty0, ty1)), std::fmax(std::fmin(tz0, tz1), t_min));
+    float t_exit = std::fmin(std::fmin(std::fmax(tx0, tx1), std::fmax(ty0, ty1)), std::fmin(std::fmax(tz0, tz1), t_max));
+
+    return t_enter <= t_exit ? t_enter : INFINITY_F;
+}
+
+void Benchmark::RunIntersection() {
+    uint32_t state = 11;
+    auto rand = [&state]() {
+        state = Hash::mix(state + 1);
+        return Hash::to_unit_float(state);
+    };
+    auto rand_vec = [&](float extent) {
+        return Vec3f(rand() - 0.5f, rand() - 0.5f, rand() - 0.5f) * extent;
+    };
+
+    // the same rays twice, once unit length and once scaled so they
+    //   take the general path, every test should hit the same things
+    float extent = (float)INTERSECTION_BLAS_GRID;
+    std::vector<Ray> unit_rays;
+    std::vector<Ray> scaled_rays;
+    std::vector<Vec3f> origins;
+    std::vector<Vec3f> directions;
+    for (uint32_t i = 0; i < INTERSECTION_RAY_COUNT; i++) {
+        origins.push_back(rand_vec(extent));
+        directions.push_back(Vec3f::normalize(rand_vec(1.0f)));
+        unit_rays.emplace_back(origins.back(), directions.back());
+        scaled_rays.emplace_back(origins.back(), directions.back() * INTERSECTION_RAY_SCALE);
+    }
+
+    std::shared_ptr<Material> material = std::make_shared<Lambertian>(Vec3f(0.5f));
+    std::vector<Sphere> spheres;
+    std::vector<Aabb> boxes;
+    for (uint32_t i = 0; i < INTERSECTION_SPHERE_COUNT; i++) {
+        spheres.emplace_back(rand_vec(extent), 0.5f + rand() * 2.0f, material);
+    }
+    for (uint32_t i = 0; i < INTERSECTION_BOX_COUNT; i++) {
+        Vec3f min = rand_vec(extent);
+        boxes.emplace_back(min, min + Vec3f(1.0f + rand() * 3.0f, 1.0f + rand() * 3.0f, 1.0f + rand() * 3.0f));
+    }
+
+    HittableList grid;
+    for (uint32_t z = 0; z < INTERSECTION_BLAS_GRID; z++) {
+        for (uint32_t y = 0; y < INTERSECTION_BLAS_GRID; y++) {
+            for (uint32_t x = 0; x < INTERSECTION_BLAS_GRID; x++) {
+                Vec3f center = Vec3f((float)x, (float)y, (float)z) - Vec3f(extent * 0.5f) + rand_vec(0.5f);
+                grid.Add(std::make_shared<Sphere>(center, 0.1f + rand() * 0.3f, material));
+            }
+        }
+    }
+    std::shared_ptr<Blas> blas = Blas::Build(grid);
+
+    // ns per call of test(ray index), which returns something to sum
+    //   into a checksum so the work can't be optimized away
+    auto time_ns = [&](uint32_t calls_per_ray, auto test, double* out_checksum) {
+        double checksum = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t pass = 0; pass < INTERSECTION_PASSES; pass++) {
+            for (uint32_t i = 0; i < INTERSECTION_RAY_COUNT; i++) {
+                checksum += test(i);
+            }
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        *out_checksum = checksum / INTERSECTION_PASSES;
+        return ns / ((double)INTERSECTION_PASSES * INTERSECTION_RAY_COUNT * calls_per_ray);
+    };
+
+    auto print_row = [](const char* label, double ns, const char* unit, double checksum) {
+        std::cout << "  " << std::left << std::setw(22) << label << std::right
+                  << std::setw(8) << std::fixed << std::setprecision(2) << ns << " ns/" << unit
+                  << "   (checksum " << std::setprecision(1) << checksum << ")\n";
+    };
+
+    std::cout << "=== intersection (single thread, " << INTERSECTION_RAY_COUNT << " rays, scaled rays are "
+              << INTERSECTION_RAY_SCALE << "x unit length) ===\n";
+
+    double checksum;
+    double ns = time_ns(1, [&](uint32_t i) {
+        Ray ray(origins[i], directions[i]);
+        return ray.get_inv_direction().x + ray.get_sign_mask();
+    }, &checksum);
+    print_row("ray setup", ns, "ray", checksum);
+
+    // hits are counted, t differs with the ray length
+    Interval ray_t(0.001f, INFINITY_F);
+    for (bool unit : {false, true}) {
+        const std::vector<Ray>& rays = unit ? unit_rays : scaled_rays;
+        ns = time_ns(INTERSECTION_SPHERE_COUNT, [&](uint32_t i) {
+            uint32_t hits = 0;
+            for (const Sphere& sphere : spheres) {
+                HitData hit_data;
+                hits += sphere.Hit(rays[i], ray_t, &hit_data);
+            }
+            return hits;
+        }, &checksum);
+        print_row(unit ? "Sphere::Hit, unit" : "Sphere::Hit, scaled", ns, "test", checksum);
+    }
+
+    for (bool sign : {false, true}) {
+        ns = time_ns(INTERSECTION_BOX_COUNT, [&](uint32_t i) {
+            uint32_t hits = 0;
+            for (const Aabb& box : boxes) {
+                float dist = sign ? aabb_hit_distance(box, unit_rays[i], 0.001f, INFINITY_F)
+                                  : aabb_hit_distance_min_max(box, unit_rays[i].get_origin(), unit_rays[i].get_inv_direction(), 0.001f, INFINITY_F);
+                hits += dist != INFINITY_F;
+            }
+            return hits;
+        }, &checksum);
+        print_row(sign ? "slab, sign bits" : "slab, min/max", ns, "box", checksum);
+    }
+
+    std::cout << "Blas of " << blas->get_sphere_count() << " spheres:\n";
+    for (bool unit : {false, true}) {
+        const std::vector<Ray>& rays = unit ? unit_rays : scaled_rays;
+        ns = time_ns(1, [&](uint32_t i) {
+            float t_closest = INFINITY_F;
+            uint32_t sphere;
+            return blas->Hit(rays[i], 0.001f, &t_closest, &sphere) ? 1 : 0;
+        }, &checksum);
+        print_row(unit ? "Blas::Hit, unit" : "Blas::Hit, scaled", ns, "ray", checksum);
+    }
+}
+
+void Benchmark::RunRenderPresets() {
+    HittableList objects = Scenes::create_default();
+    CompiledScene scene = CompiledScene::Compile(objects);
+    Camera camera = Scenes::create_default_camera((float)PRESET_WIDTH / PRESET_HEIGHT);
+    std::vector<uint8_t> pixels(PRESET_WIDTH * PRESET_HEIGHT * 4);
+
+    std::cout << "=== render presets (" << PRESET_WIDTH << "x" << PRESET_HEIGHT << ", best of " << PRESET_FRAMES
+              << ", rmse against final at the same spp) ===\n";
+    std::cout << std::left << std::setw(14) << "preset" << std::right << std::setw(6) << "depth" << std::setw(6) << "spp"
+              << std::setw(12) << "full ms" << std::setw(12) << "low res ms" << std::setw(10) << "rmse" << "\n";
+
+    for (uint32_t spp : {1u, PRESET_SPP}) {
+        std::vector<uint8_t> final_pixels;
+
+        for (uint32_t i = 0; i < RenderKernel::PRESET_COUNT; i++) {
+            RenderPreset preset = (RenderPreset)i;
+            Renderer renderer(PRESET_WIDTH, PRESET_HEIGHT, 0.5f);
+            renderer.set_samples_per_pixel(spp);
+            renderer.set_render_preset(preset);
+
+            auto time_best_ms = [&](auto render) {
+                double best_ms = 0.0;
+                for (uint32_t frame = 0; frame < PRESET_FRAMES; frame++) {
+                    auto start = std::chrono::steady_clock::now();
+                    render();
+                    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    best_ms = frame == 0 ? ms : std::min(best_ms, ms);
+                }
+                return best_ms;
+            };
+
+            // low res frames take the G-buffer writing kernels
+            renderer.set_low_res(true);
+            double low_res_ms = time_best_ms([&]() { renderer.RenderFrame(pixels.data(), camera, scene); });
+            renderer.set_low_res(false);
+            double full_ms = time_best_ms([&]() { renderer.RenderImage(pixels.data(), camera, scene); });
+
+            if (preset == RenderPreset::Final) {
+                final_pixels = pixels;
+            }
+
+            std::cout << std::left << std::setw(14) << RenderKernel::preset_name(preset) << std::right << std::fixed
+                      << std::setw(6) << RenderKernel::get_max_depth(preset) << std::setw(6) << spp
+                      << std::setw(12) << std::setprecision(2) << full_ms << std::setw(12) << low_res_ms
+                      << std::setw(10) << std::setprecision(3) << get_rmse(pixels, final_pixels) << "\n";
+        }
+    }
+}
+
+bool Benchmark::RunAllocations() {
+    HittableList objects = Scenes::create_random_spheres(12, 1);
+    CompiledScene scene = CompiledScene::Compile(objects);
+
+    struct AllocationCase {
+        const char* name;
+        bool low_res;
+        UpscaleFilter upscale_filter;
+        ShadingRateSource shading_rate_source;
+        InterleaveMode interleave_mode;
+    };
+
+    const AllocationCase cases[] = {
+        {"full res", false, UpscaleFilter::EdgeAware, ShadingRateSource::Off, InterleaveMode::Off},
+        {"vrs variance", false, UpscaleFilter::EdgeAware, ShadingRateSource::Variance, InterleaveMode::Off},
+        {"low res nearest", true, UpscaleFilter::Nearest, ShadingRateSource::Off, InterleaveMode::Off},
+        {"low res edge", true, UpscaleFilter::EdgeAware, ShadingRateSource::Off, InterleaveMode::Off},
+        {"checkerboard", true, UpscaleFilter::EdgeAware, ShadingRateSource::Off, InterleaveMode::Checkerboard},
+        {"quad", true, UpscaleFilter::EdgeAware, ShadingRateSource::Off, InterleaveMode::Quad}
+    };
+
+    std::cout << "=== heap allocations per frame (" << BENCH_WIDTH << "x" << BENCH_HEIGHT << ", " << ALLOCATION_FRAMES << " frames) ===\n";
+
+    bool passed = true;
+    for (const AllocationCase& test : cases) {
+        Camera camera = Scenes::create_default_camera((float)BENCH_WIDTH / BENCH_HEIGHT);
+        std::vector<uint8_t> pixels(BENCH_WIDTH * BENCH_HEIGHT * 4);
+
+        Renderer renderer(BENCH_WIDTH, BENCH_HEIGHT, 0.5f);
+        renderer.set_samples_per_pixel(ALLOCATION_SPP);
+        renderer.set_low_res(test.low_res);
+        renderer.set_upscale_filter(test.upscale_filter);
+        renderer.set_shading_rate_source(test.shading_rate_source);
+        renderer.set_interleave_mode(test.interleave_mode);
+
+        // low res frames are the moving ones, full res frames get their
+        //   tiles dirtied again so every frame has work to do
+        auto render_frame = [&]() {
+            if (test.low_res) {
+                camera.MoveBy(Vec3f(ALLOCATION_CAMERA_STEP, 0.0f, 0.0f));
+            } else {
+                renderer.InvalidateAll();
+            }
+            renderer.RenderFrame(pixels.data(), camera, scene);
+        };
+
+        for (uint32_t i = 0; i < ALLOCATION_WARMUP_FRAMES; i++) {
+            render_frame();
+        }
+
+        uint64_t before = AllocationCounter::get_count();
+        for (uint32_t i = 0; i < ALLOCATION_FRAMES; i++) {
+            render_frame();
+        }
+        uint64_t allocations = AllocationCounter::get_count() - before;
+
+        std::cout << "  " << std::left << std::setw(18) << test.name << std::right
+                  << std::setw(8) << allocations << (allocations == 0 ? "" : "  (ALLOCATES)") << "\n";
+        passed &= allocations == 0;
+    }
+
+    return passed;
+}
+
+int Benchmark::Run(const char* name) {
+    bool run_all = name == nullptr;
+    bool ran_any = false;
+    bool passed = true;
+
+    if (run_all || strcmp(name, "samplers") == 0) {
+        RunSamplerConvergence();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "materials") == 0) {
+        RunMaterialDispatch();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "perf") == 0) {
+        RunHardwareCounters();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "refit") == 0) {
+        RunBvhRefit();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "incremental") == 0) {
+        RunIncremental();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "vrs") == 0) {
+        RunVariableRate();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "scene_file") == 0) {
+        RunSceneFile();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "resolve") == 0) {
+        RunResolve();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "upscale") == 0) {
+        RunUpscale();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "scaling") == 0) {
+        RunThreadScaling();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "pipeline") == 0) {
+        RunFramePipeline();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "intersection") == 0) {
+        RunIntersection();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "presets") == 0) {
+        RunRenderPresets();
+        ran_any = true;
+    }
+
+    if (run_all || strcmp(name, "allocations") == 0) {
+        passed &= RunAllocations();
+        ran_any = true;
+    }
+
+    if (!ran_any) {
+        std::cerr << "unknown benchmark \"" << name << "\"\n";
+        return 1;
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace Benchmark {
+    // renders a reference image with independent samples on its own seed
+    //   and measures the linear RMSE of every sampler against it over an
+    //   increasing number of samples
+    void RunSamplerConvergence();
+
+    // per render thread hardware counters (linux perf_event_open) around
+    //   every frame of every benchmark scene, falls back to wall clock
+    //   only when the counters can't be opened
+    void RunHardwareCounters();
+
+    // virtual Material::Scatter through object pointers against the
+    //   flat MaterialTable switch, on the same shuffled set of hits
+    void RunMaterialDispatch();
+
+    // animates a scene of loose spheres and one of instances for a long
+    //   run under three update policies (always rebuild, always refit and
+    //   refit with the automatic SAH rebuild), reporting update time and
+    //   how much slower tracing gets as the refit trees degrade
+    void RunBvhRefit();
+
+    // edits one material and moves one sphere in a converged frame, then
+    //   re-renders only the invalidated tiles and compares time and
+    //   result against re-rendering the whole frame
+    void RunIncremental();
+
+    // renders a frame at every variable rate shading source until no tile
+    //   is dirty, against full rate: time and error over the whole frame
+    //   and inside the fovea
+    void RunVariableRate();
+
+    // writes a large generated scene file, then times parsing it (which
+    //   also writes the binary cache) against loading it from the cache
+    void RunSceneFile();
+
+    // resolve pass throughput (linear float framebuffer in, RGBA8 out) in
+    //   GB/s at 1080p and 4K for every tone map, SIMD against scalar and
+    //   against the old inline gamma and quantize
+    void RunResolve();
+
+    // low res to full res upscale and resolve throughput at 1080p and 4K
+    //   output for every filter, AVX2 with streaming stores against scalar
+    //   and the old low res resolve plus per pixel nearest memcpy
+    void RunUpscale();
+
+    // renders the same frame with every thread placement policy (and each
+    //   NUMA node on its own, on machines with more than one) at doubling
+    //   thread counts, reporting speedup over one thread
+    void RunThreadScaling();
+
+    // frames through the FramePipeline at every depth with a present that
+    //   blocks like vsync would, time per frame against how long frames
+    //   take from being submitted to being shown
+    void RunFramePipeline();
+
+    // single thread cost of one intersection test with unit length rays
+    //   against longer ones, sphere by sphere and through a Blas, and of
+    //   the sign bit slab test against the old min/max one
+    void RunIntersection();
+
+    // full res and low res frames with every render preset at one and
+    //   several samples per pixel, so with the single sample kernels too,
+    //   and how far each preset's image is from the final one
+    void RunRenderPresets();
+
+    // counts heap allocations over steady state frames in every render
+    //   mode, false if any of them allocated. --bench allocations exits
+    //   with 1 then so it can gate a build
+    bool RunAllocations();
+
+    // entry point for "--bench [name]", runs everything when no name is given
+    int Run(const char* name);
+};
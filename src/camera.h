@@ -20,11 +20,13 @@ class Camera {
     void RotateBy(const Vec3f& offset);
 
     Vec3f get_position() const { return position; }
+    Vec3f get_rotation() const { return rotation; }
     float get_aspect_ratio() const { return aspect_ratio; }
     float get_focal_length() const { return focal_length; }
     float get_viewport_width() const { return viewport_width; }
     float get_viewport_height() const { return viewport_height; }
     void set_position(const Vec3f& position) { this->position = position; }
+    void set_rotation(const Vec3f& rotation) { this->rotation = rotation; }
     void set_aspect_ratio(float aspect_ratio);
 
     Vec3f get_forward() const;
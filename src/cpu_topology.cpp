@@ -0,0 +1,184 @@
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// from linux/mempolicy.h, which isn't always installed
+constexpr int MPOL_PREFERRED_MODE = 1;
+#endif
+
+// highest node id looked for under /sys/devices/system/node
+constexpr uint32_t MAX_NUMA_NODES = 64;
+
+static bool read_sysfs_line(const std::string& path, std::string* out_line) {
+    std::ifstream in(path);
+    return (bool)std::getline(in, *out_line);
+}
+
+bool CpuTopology::parse_cpu_list(const char* text, std::vector<uint32_t>* out_cpus) {
+    std::vector<uint32_t> cpus;
+    const char* c = text;
+
+    while (*c != '\0' && *c != '\n') {
+        char* end;
+        unsigned long first = strtoul(c, &end, 10);
+        if (end == c) return false;
+        unsigned long last = first;
+        c = end;
+
+        if (*c == '-') {
+            c++;
+            last = strtoul(c, &end, 10);
+            if (end == c || last < first) return false;
+            c = end;
+        }
+
+        for (unsigned long cpu = first; cpu <= last; cpu++) {
+            cpus.push_back((uint32_t)cpu);
+        }
+
+        if (*c == ',') {
+            c++;
+        } else if (*c != '\0' && *c != '\n') {
+            return false;
+        }
+    }
+
+    if (cpus.empty()) return false;
+
+    *out_cpus = cpus;
+    return true;
+}
+
+std::vector<CpuTopology::LogicalCpu> CpuTopology::get_logical_cpus() {
+    std::vector<LogicalCpu> cpus;
+
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (uint32_t id = 0; id < CPU_SETSIZE; id++) {
+            if (!CPU_ISSET(id, &allowed)) continue;
+
+            // missing topology files (some containers) make every
+            //   cpu its own core on package 0
+            std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+            std::string line;
+            LogicalCpu cpu = {id, id, 0, -1};
+            if (read_sysfs_line(topology + "core_id", &line)) cpu.core_id = (uint32_t)strtoul(line.c_str(), nullptr, 10);
+            if (read_sysfs_line(topology + "physical_package_id", &line)) cpu.package_id = (uint32_t)strtoul(line.c_str(), nullptr, 10);
+            cpus.push_back(cpu);
+        }
+
+        for (uint32_t node = 0; node < MAX_NUMA_NODES; node++) {
+            std::string line;
+            std::vector<uint32_t> node_cpus;
+            if (!read_sysfs_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", &line)) continue;
+            if (!parse_cpu_list(line.c_str(), &node_cpus)) continue;
+
+            for (LogicalCpu& cpu : cpus) {
+                if (std::find(node_cpus.begin(), node_cpus.end(), cpu.id) != node_cpus.end()) {
+                    cpu.numa_node = (int32_t)node;
+                }
+            }
+        }
+    }
+#endif
+
+    if (cpus.empty()) {
+        for (uint32_t id = 0; id < std::max(1u, std::thread::hardware_concurrency()); id++) {
+            cpus.push_back({id, id, 0, -1});
+        }
+    }
+
+    std::sort(cpus.begin(), cpus.end(), [](const LogicalCpu& a, const LogicalCpu& b) {
+        if (a.numa_node != b.numa_node) return a.numa_node < b.numa_node;
+        if (a.package_id != b.package_id) return a.package_id < b.package_id;
+        if (a.core_id != b.core_id) return a.core_id < b.core_id;
+        return a.id < b.id;
+    });
+
+    return cpus;
+}
+
+bool CpuTopology::select_cpus(const ThreadPlacement& placement, std::vector<uint32_t>* out_cpus, std::string* out_error) {
+    std::vector<uint32_t> selected;
+    const LogicalCpu* last_core = nullptr;
+
+    for (const LogicalCpu& cpu : get_logical_cpus()) {
+        if (!placement.cpus.empty() && std::find(placement.cpus.begin(), placement.cpus.end(), cpu.id) == placement.cpus.end()) continue;
+        if (placement.numa_node >= 0 && cpu.numa_node != placement.numa_node) continue;
+
+        // siblings are sorted next to each other, only keep the first
+        bool same_core = last_core != nullptr && last_core->package_id == cpu.package_id && last_core->core_id == cpu.core_id;
+        last_core = &cpu;
+        if (placement.policy == ThreadPlacementPolicy::Cores && same_core) continue;
+
+        selected.push_back(cpu.id);
+    }
+
+    if (selected.empty()) {
+        *out_error = placement.numa_node >= 0
+            ? "numa node " + std::to_string(placement.numa_node) + " has none of the cpus this process may run on"
+            : "none of the listed cpus are ones this process may run on";
+        return false;
+    }
+
+    *out_cpus = selected;
+    return true;
+}
+
+bool CpuTopology::PinCurrentThread(const std::vector<uint32_t>& cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (uint32_t cpu : cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+bool CpuTopology::PreferNode(int32_t node) {
+#ifdef __linux__
+    if (node < 0 || node >= (int32_t)MAX_NUMA_NODES) return false;
+
+    unsigned long mask = 1ul << node;
+    return syscall(SYS_set_mempolicy, MPOL_PREFERRED_MODE, &mask, (unsigned long)MAX_NUMA_NODES + 1) == 0;
+#else
+    return false;
+#endif
+}
+
+const char* CpuTopology::policy_name(ThreadPlacementPolicy policy) {
+    switch (policy) {
+        case ThreadPlacementPolicy::Unpinned: return "off";
+        case ThreadPlacementPolicy::Cores: return "cores";
+        case ThreadPlacementPolicy::SmtThreads: return "smt";
+    }
+
+    return "unknown";
+}
+
+bool CpuTopology::parse_policy(const char* name, ThreadPlacementPolicy* out_policy) {
+    static const ThreadPlacementPolicy policies[] = {ThreadPlacementPolicy::Unpinned, ThreadPlacementPolicy::Cores, ThreadPlacementPolicy::SmtThreads};
+    for (ThreadPlacementPolicy policy : policies) {
+        if (strcmp(name, policy_name(policy)) == 0) {
+            *out_policy = policy;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+enum class ThreadPlacementPolicy {
+    // threads float wherever the os puts them
+    Unpinned,
+    // one thread pinned to each physical core, SMT siblings left idle
+    Cores,
+    // one thread pinned to each hardware thread, siblings filled together
+    SmtThreads
+};
+
+// where a ThreadPool's workers run
+struct ThreadPlacement {
+    ThreadPlacementPolicy policy = ThreadPlacementPolicy::Unpinned;
+    // 0 is one per selected cpu, or std::thread::hardware_concurrency
+    //   when unpinned. more threads than cpus share them round robin
+    uint32_t thread_count = 0;
+    // only these logical cpus, empty is every one the process may use
+    std::vector<uint32_t> cpus;
+    // only this NUMA node's cpus, and workers prefer its memory. -1 is any
+    int32_t numa_node = -1;
+};
+
+// what linux reports about the machine under /sys/devices/system, elsewhere
+//   every cpu looks like its own core on one node and pinning does nothing
+namespace CpuTopology {
+    struct LogicalCpu {
+        uint32_t id;
+        uint32_t core_id;
+        uint32_t package_id;
+        // -1 where there's no NUMA information
+        int32_t numa_node;
+    };
+
+    // cpus this process is allowed to run on, sorted by node, package,
+    //   core and then id so siblings and neighbours are next to each other
+    std::vector<LogicalCpu> get_logical_cpus();
+
+    // the cpus a pool with this placement uses, in the order threads are
+    //   given them. false if the filters leave none
+    bool select_cpus(const ThreadPlacement& placement, std::vector<uint32_t>* out_cpus, std::string* out_error);
+
+    // restricts the calling thread to cpus, returns false where that
+    //   isn't supported or the kernel refuses
+    bool PinCurrentThread(const std::vector<uint32_t>& cpus);
+
+    // makes memory the calling thread touches first come from node when it
+    //   can, set_mempolicy directly so there's no libnuma dependency
+    bool PreferNode(int32_t node);
+
+    // linux's "0-3,8,10-11" format
+    bool parse_cpu_list(const char* text, std::vector<uint32_t>* out_cpus);
+
+    const char* policy_name(ThreadPlacementPolicy policy);
+    bool parse_policy(const char* name, ThreadPlacementPolicy* out_policy);
+};
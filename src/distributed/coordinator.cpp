@@ -0,0 +1,336 @@
+#include "coordinator.h"
+
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include "protocol.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#define RTRT_HAS_POLL
+#endif
+
+// bigger than the renderer's own tiles so each message carries enough
+//   work to hide the round trip
+constexpr uint32_t DISTRIBUTED_TILE_SIZE = 64;
+// tiles queued on each worker, so the next one is already waiting
+//   when it sends a result back
+constexpr uint32_t TILES_IN_FLIGHT = 2;
+// a tile taking this many times the average is worth copying to an idle
+//   worker once nothing else is left, and never sooner than the minimum
+constexpr double STRAGGLER_FACTOR = 3.0;
+constexpr double STRAGGLER_MIN_S = 0.25;
+constexpr uint32_t MAX_TILE_COPIES = 2;
+constexpr int POLL_INTERVAL_MS = 50;
+// once a message has started arriving the rest should be right behind it
+constexpr double MESSAGE_RECEIVE_TIMEOUT_S = 5.0;
+constexpr uint32_t FRAME_ID = 1;
+
+namespace Distributed {
+    using Clock = std::chrono::steady_clock;
+
+    struct TileState {
+        TileMessage message;
+        bool done;
+        // workers currently holding a copy of it
+        uint32_t copies;
+    };
+
+    struct Assignment {
+        uint32_t tile_index;
+        Clock::time_point sent_at;
+    };
+
+    struct WorkerState {
+        Socket socket;
+        bool has_frame;
+        std::vector<Assignment> in_flight;
+        Clock::time_point last_heard;
+    };
+
+    static double seconds_since(Clock::time_point time, Clock::time_point now) {
+        return std::chrono::duration<double>(now - time).count();
+    }
+
+#ifdef RTRT_HAS_POLL
+
+    // the coordinator's side of one frame
+    class Coordinator {
+       private:
+        const FrameSettings& settings;
+        AccumulationBuffer* image;
+        CoordinatorReport* report;
+        std::vector<TileState> tiles;
+        std::deque<uint32_t> pending;
+        std::vector<WorkerState> workers;
+        uint32_t tiles_done;
+        double total_tile_s;
+        std::vector<uint8_t> payload;
+
+        void CreateTiles() {
+            for (uint32_t y = 0; y < settings.height; y += DISTRIBUTED_TILE_SIZE) {
+                for (uint32_t x = 0; x < settings.width; x += DISTRIBUTED_TILE_SIZE) {
+                    TileState tile;
+                    tile.message = {
+                        FRAME_ID,
+                        (uint32_t)tiles.size(),
+                        x,
+                        y,
+                        std::min(DISTRIBUTED_TILE_SIZE, settings.width - x),
+                        std::min(DISTRIBUTED_TILE_SIZE, settings.height - y)
+                    };
+                    tile.done = false;
+                    tile.copies = 0;
+
+                    pending.push_back(tile.message.tile_index);
+                    tiles.push_back(tile);
+                }
+            }
+        }
+
+        // hands a dead worker's unfinished tiles back out, ahead of
+        //   everything else since the rest of the frame is waiting on them
+        void DropWorker(uint32_t worker_index) {
+            WorkerState& worker = workers[worker_index];
+            for (const Assignment& assignment : worker.in_flight) {
+                TileState& tile = tiles[assignment.tile_index];
+                tile.copies--;
+                if (!tile.done && tile.copies == 0) {
+                    pending.push_front(assignment.tile_index);
+                    report->tiles_reassigned++;
+                }
+            }
+
+            worker.in_flight.clear();
+            worker.socket.Close();
+            report->workers_lost++;
+        }
+
+        bool SendFrame(WorkerState* worker) {
+            FrameMessage message;
+            memset((void*)&message, 0, sizeof(message));
+            message.frame_id = FRAME_ID;
+            message.width = settings.width;
+            message.height = settings.height;
+            message.samples_per_pixel = settings.samples_per_pixel;
+            message.sampler_type = (uint32_t)settings.sampler_type;
+            message.render_preset = (uint32_t)settings.render_preset;
+            message.camera = describe_camera(settings.camera);
+            message.scene_text_size = (uint32_t)settings.scene_text.size();
+
+            return SendMessage(&worker->socket, MessageType::Frame, &message, sizeof(message), settings.scene_text.data(), settings.scene_text.size());
+        }
+
+        bool HandleMessage(WorkerState* worker, MessageType type) {
+            if (type == MessageType::Hello) {
+                HelloMessage hello;
+                if (worker->has_frame || payload.size() != sizeof(hello)) return false;
+                memcpy(&hello, payload.data(), sizeof(hello));
+                if (!IsCompatible(hello)) return false;
+
+                worker->has_frame = SendFrame(worker);
+                return worker->has_frame;
+            }
+
+            TileMessage result;
+            if (type != MessageType::TileResult || payload.size() < sizeof(result)) return false;
+            memcpy(&result, payload.data(), sizeof(result));
+
+            auto assignment = std::find_if(worker->in_flight.begin(), worker->in_flight.end(), [&result](const Assignment& a) {
+                return a.tile_index == result.tile_index;
+            });
+            if (assignment == worker->in_flight.end()) return false;
+
+            TileState& tile = tiles[result.tile_index];
+            size_t pixel_count = (size_t)tile.message.width * tile.message.height;
+            if (payload.size() != sizeof(result) + pixel_count * 3 * sizeof(float)) return false;
+
+            total_tile_s += seconds_since(assignment->sent_at, Clock::now());
+            worker->in_flight.erase(assignment);
+            tile.copies--;
+
+            // a copy that lost the race, its pixels are already in
+            if (tile.done) return true;
+
+            const float* sums = (const float*)(payload.data() + sizeof(result));
+            for (uint32_t y = 0; y < tile.message.height; y++) {
+                for (uint32_t x = 0; x < tile.message.width; x++) {
+                    const float* sum = sums + ((size_t)y * tile.message.width + x) * 3;
+                    uint32_t pixel_index = (tile.message.y + y) * settings.width + tile.message.x + x;
+                    image->AddSamples(pixel_index, Vec3f(sum[0], sum[1], sum[2]), settings.samples_per_pixel);
+                }
+            }
+
+            tile.done = true;
+            tiles_done++;
+            return true;
+        }
+
+        // the next pending tile, or once those run out a copy of the
+        //   slowest outstanding tile held by some other worker
+        bool PickTile(uint32_t worker_index, Clock::time_point now, uint32_t* out_tile_index) {
+            while (!pending.empty()) {
+                uint32_t tile_index = pending.front();
+                pending.pop_front();
+                if (!tiles[tile_index].done) {
+                    *out_tile_index = tile_index;
+                    return true;
+                }
+            }
+
+            if (tiles_done == 0) return false;
+            double average_s = total_tile_s / tiles_done;
+            double straggler_s = std::max(STRAGGLER_MIN_S, average_s * STRAGGLER_FACTOR);
+
+            double slowest_s = straggler_s;
+            bool found = false;
+            for (uint32_t i = 0; i < workers.size(); i++) {
+                if (i == worker_index) continue;
+
+                for (const Assignment& assignment : workers[i].in_flight) {
+                    const TileState& tile = tiles[assignment.tile_index];
+                    double waited_s = seconds_since(assignment.sent_at, now);
+                    if (tile.done || tile.copies >= MAX_TILE_COPIES || waited_s < slowest_s) continue;
+
+                    slowest_s = waited_s;
+                    *out_tile_index = assignment.tile_index;
+                    found = true;
+                }
+            }
+
+            if (found) {
+                report->tiles_duplicated++;
+            }
+            return found;
+        }
+
+        void AssignTiles(Clock::time_point now) {
+            for (uint32_t i = 0; i < workers.size(); i++) {
+                WorkerState& worker = workers[i];
+                while (worker.socket.is_open() && worker.has_frame && worker.in_flight.size() < TILES_IN_FLIGHT) {
+                    uint32_t tile_index;
+                    if (!PickTile(i, now, &tile_index)) break;
+
+                    // counted before sending so a failed send puts it back
+                    tiles[tile_index].copies++;
+                    worker.in_flight.push_back({tile_index, now});
+                    if (worker.in_flight.size() == 1) {
+                        worker.last_heard = now;
+                    }
+
+                    if (!SendMessage(&worker.socket, MessageType::Tile, &tiles[tile_index].message, sizeof(TileMessage))) {
+                        DropWorker(i);
+                    }
+                }
+            }
+        }
+
+        void DropTimedOutWorkers(Clock::time_point now) {
+            for (uint32_t i = 0; i < workers.size(); i++) {
+                WorkerState& worker = workers[i];
+                if (!worker.socket.is_open() || worker.in_flight.empty()) continue;
+
+                if (seconds_since(worker.last_heard, now) > settings.worker_timeout_s) {
+                    DropWorker(i);
+                }
+            }
+        }
+
+       public:
+        Coordinator(const FrameSettings& settings, AccumulationBuffer* image, CoordinatorReport* report)
+          : settings(settings),
+            image(image),
+            report(report),
+            tiles_done(0),
+            total_tile_s(0.0) {
+            CreateTiles();
+            report->tile_count = (uint32_t)tiles.size();
+        }
+
+        bool Run(Listener* listener) {
+            std::vector<pollfd> poll_fds;
+            std::vector<uint32_t> poll_workers;
+
+            while (tiles_done < tiles.size()) {
+                poll_fds.clear();
+                poll_workers.clear();
+                poll_fds.push_back({listener->get_fd(), POLLIN, 0});
+                for (uint32_t i = 0; i < workers.size(); i++) {
+                    if (!workers[i].socket.is_open()) continue;
+
+                    poll_fds.push_back({workers[i].socket.get_fd(), POLLIN, 0});
+                    poll_workers.push_back(i);
+                }
+
+                if (poll(poll_fds.data(), poll_fds.size(), POLL_INTERVAL_MS) < 0 && errno != EINTR) {
+                    return false;
+                }
+
+                Clock::time_point now = Clock::now();
+                for (uint32_t i = 0; i < poll_workers.size(); i++) {
+                    if (poll_fds[i + 1].revents == 0) continue;
+
+                    WorkerState& worker = workers[poll_workers[i]];
+                    MessageType type;
+                    if (!ReceiveMessage(&worker.socket, &type, &payload) || !HandleMessage(&worker, type)) {
+                        DropWorker(poll_workers[i]);
+                        continue;
+                    }
+                    worker.last_heard = now;
+                }
+
+                // accepted after reading so indices above stay valid
+                if (poll_fds[0].revents & POLLIN) {
+                    WorkerState worker;
+                    if (listener->Accept(&worker.socket)) {
+                        worker.socket.set_receive_timeout(MESSAGE_RECEIVE_TIMEOUT_S);
+                        worker.has_frame = false;
+                        worker.last_heard = now;
+                        workers.push_back(std::move(worker));
+                        report->workers_connected++;
+                    }
+                }
+
+                DropTimedOutWorkers(now);
+                AssignTiles(now);
+            }
+
+            // workers still busy with copies of finished tiles just have
+            //   those results dropped when the connection closes
+            for (WorkerState& worker : workers) {
+                if (worker.socket.is_open()) {
+                    SendMessage(&worker.socket, MessageType::Finished, nullptr, 0);
+                }
+            }
+
+            return true;
+        }
+    };
+
+#endif
+
+    bool RunCoordinator(const char* address, const FrameSettings& settings, AccumulationBuffer* out_image, CoordinatorReport* out_report, std::string* out_error) {
+        memset(out_report, 0, sizeof(*out_report));
+
+#ifdef RTRT_HAS_POLL
+        Listener listener;
+        if (!listener.Open(address, out_error)) return false;
+
+        auto start = Clock::now();
+        Coordinator coordinator(settings, out_image, out_report);
+        if (!coordinator.Run(&listener)) {
+            *out_error = "waiting on workers failed";
+            return false;
+        }
+        out_report->seconds = seconds_since(start, Clock::now());
+
+        return true;
+#else
+        *out_error = "distributed rendering isn't supported on this platform";
+        return false;
+#endif
+    }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "../camera.h"
+#include "../accumulation_buffer.h"
+#include "../samplers/sampler.h"
+#include "../render_kernel.h"
+
+namespace Distributed {
+    struct FrameSettings {
+        uint32_t width;
+        uint32_t height;
+        uint32_t samples_per_pixel;
+        SamplerType sampler_type;
+        RenderPreset render_preset;
+        Camera camera;
+        // scene file text sent to every worker, empty for the default scene
+        std::string scene_text;
+        // a worker that hasn't answered for this long with tiles
+        //   outstanding is treated as dead and its tiles handed out again
+        double worker_timeout_s;
+    };
+
+    struct CoordinatorReport {
+        uint32_t workers_connected;
+        uint32_t workers_lost;
+        uint32_t tile_count;
+        // tiles sent out again after their worker died or timed out
+        uint32_t tiles_reassigned;
+        // copies of slow tiles sent to idle workers, the first result wins
+        uint32_t tiles_duplicated;
+        double seconds;
+    };
+
+    // listens on address, splits the frame into tiles and hands them out
+    //   to however many workers connect (they can join at any point),
+    //   adding each finished tile into out_image. workers that die or fall
+    //   far behind have their tiles given to someone else. every pixel's
+    //   samples are fixed by its position, so the image comes out the same
+    //   no matter which worker rendered what
+    bool RunCoordinator(const char* address, const FrameSettings& settings, AccumulationBuffer* out_image, CoordinatorReport* out_report, std::string* out_error);
+};
@@ -0,0 +1,54 @@
+#include "protocol.h"
+
+#include <cstring>
+
+// bump whenever any message layout changes
+constexpr uint32_t PROTOCOL_VERSION = 2;
+constexpr uint32_t MESSAGE_MAGIC = 0x52545254;  // "RTRT"
+constexpr uint32_t PROTOCOL_BYTE_ORDER = 0x01020304;
+// nothing legitimate comes anywhere near this, a bigger size means
+//   the stream is out of sync or the peer isn't one of ours
+constexpr uint64_t MAX_MESSAGE_SIZE = 1ull << 30;
+
+namespace Distributed {
+    HelloMessage create_hello(uint32_t thread_count) {
+        return {PROTOCOL_VERSION, PROTOCOL_BYTE_ORDER, thread_count};
+    }
+
+    bool IsCompatible(const HelloMessage& hello) {
+        return hello.version == PROTOCOL_VERSION && hello.byte_order == PROTOCOL_BYTE_ORDER;
+    }
+
+    CameraDesc describe_camera(const Camera& camera) {
+        return {
+            camera.get_position(),
+            camera.get_rotation(),
+            camera.get_aspect_ratio(),
+            camera.get_focal_length(),
+            camera.get_viewport_height()
+        };
+    }
+
+    Camera create_camera(const CameraDesc& desc) {
+        Camera camera(desc.position, desc.aspect_ratio, desc.focal_length, desc.viewport_height);
+        camera.set_rotation(desc.rotation);
+        return camera;
+    }
+
+    bool SendMessage(Socket* socket, MessageType type, const void* body, size_t body_size, const void* tail, size_t tail_size) {
+        MessageHeader header = {MESSAGE_MAGIC, (uint32_t)type, body_size + tail_size};
+        return socket->SendAll(&header, sizeof(header)) &&
+               socket->SendAll(body, body_size) &&
+               socket->SendAll(tail, tail_size);
+    }
+
+    bool ReceiveMessage(Socket* socket, MessageType* out_type, std::vector<uint8_t>* out_payload) {
+        MessageHeader header;
+        if (!socket->ReceiveAll(&header, sizeof(header))) return false;
+        if (header.magic != MESSAGE_MAGIC || header.size > MAX_MESSAGE_SIZE) return false;
+
+        *out_type = (MessageType)header.type;
+        out_payload->resize(header.size);
+        return socket->ReceiveAll(out_payload->data(), header.size);
+    }
+};
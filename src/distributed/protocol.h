@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "socket.h"
+#include "../camera.h"
+
+// messages between a render coordinator and its workers. every message
+//   is a MessageHeader followed by a fixed size body and, for some types,
+//   a variable sized tail. all plain data in host byte order, hello
+//   messages carry a byte order mark so mismatched machines refuse early
+namespace Distributed {
+    enum class MessageType : uint32_t {
+        // worker -> coordinator when it connects
+        Hello,
+        // coordinator -> worker, FrameMessage + scene file text
+        Frame,
+        // coordinator -> worker, TileMessage
+        Tile,
+        // worker -> coordinator, TileMessage + rgb float sums per pixel
+        TileResult,
+        // coordinator -> worker, nothing left to render
+        Finished
+    };
+
+    struct MessageHeader {
+        uint32_t magic;
+        uint32_t type;
+        uint64_t size;
+    };
+
+    struct HelloMessage {
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t thread_count;
+    };
+
+    // enough to rebuild the exact same camera on the other side
+    struct CameraDesc {
+        Vec3f position;
+        Vec3f rotation;
+        float aspect_ratio;
+        float focal_length;
+        float viewport_height;
+    };
+
+    struct FrameMessage {
+        uint32_t frame_id;
+        uint32_t width;
+        uint32_t height;
+        uint32_t samples_per_pixel;
+        uint32_t sampler_type;
+        uint32_t render_preset;
+        CameraDesc camera;
+        // text of the scene file, empty for the built in default scene
+        uint32_t scene_text_size;
+    };
+
+    struct TileMessage {
+        uint32_t frame_id;
+        uint32_t tile_index;
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    HelloMessage create_hello(uint32_t thread_count);
+    bool IsCompatible(const HelloMessage& hello);
+
+    CameraDesc describe_camera(const Camera& camera);
+    Camera create_camera(const CameraDesc& desc);
+
+    bool SendMessage(Socket* socket, MessageType type, const void* body, size_t body_size, const void* tail = nullptr, size_t tail_size = 0);
+
+    // reads one whole message into out_payload (body then tail)
+    bool ReceiveMessage(Socket* socket, MessageType* out_type, std::vector<uint8_t>* out_payload);
+};
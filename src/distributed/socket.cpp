@@ -0,0 +1,277 @@
+#include "socket.h"
+
+#include <cstring>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#define RTRT_HAS_SOCKETS
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+constexpr const char* UNIX_PREFIX = "unix:";
+constexpr int LISTEN_BACKLOG = 64;
+
+#ifdef RTRT_HAS_SOCKETS
+
+// splits "host:port", the host can't be empty
+static bool split_host_port(const char* address, std::string* out_host, std::string* out_port) {
+    const char* colon = strrchr(address, ':');
+    if (colon == nullptr || colon == address || colon[1] == '\0') return false;
+
+    *out_host = std::string(address, colon - address);
+    *out_port = colon + 1;
+    return true;
+}
+
+static bool make_unix_address(const char* path, sockaddr_un* out_address, std::string* out_error) {
+    memset(out_address, 0, sizeof(*out_address));
+    out_address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(out_address->sun_path)) {
+        *out_error = std::string("socket path \"") + path + "\" is too long";
+        return false;
+    }
+
+    strcpy(out_address->sun_path, path);
+    return true;
+}
+
+// calls try_address on every resolved tcp address until one works
+template <typename F>
+static int for_each_tcp_address(const char* address, bool passive, std::string* out_error, F try_address) {
+    std::string host;
+    std::string port;
+    if (!split_host_port(address, &host, &port)) {
+        *out_error = std::string("expected unix:path or host:port, got \"") + address + "\"";
+        return -1;
+    }
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+    addrinfo* results = nullptr;
+    int result = getaddrinfo(host.c_str(), port.c_str(), &hints, &results);
+    if (result != 0) {
+        *out_error = "couldn't resolve \"" + host + "\": " + gai_strerror(result);
+        return -1;
+    }
+
+    int fd = -1;
+    for (addrinfo* info = results; info != nullptr && fd < 0; info = info->ai_next) {
+        fd = try_address(info);
+    }
+    freeaddrinfo(results);
+
+    if (fd < 0) {
+        *out_error = std::string("couldn't use \"") + address + "\": " + strerror(errno);
+    }
+    return fd;
+}
+
+#endif
+
+Socket::Socket() : fd(-1) { }
+
+Socket::Socket(int fd) : fd(fd) { }
+
+Socket::~Socket() {
+    Close();
+}
+
+Socket::Socket(Socket&& other) : fd(other.fd) {
+    other.fd = -1;
+}
+
+Socket& Socket::operator=(Socket&& other) {
+    if (this != &other) {
+        Close();
+        fd = other.fd;
+        other.fd = -1;
+    }
+
+    return *this;
+}
+
+bool Socket::Connect(const char* address, std::string* out_error) {
+    Close();
+
+#ifdef RTRT_HAS_SOCKETS
+    if (strncmp(address, UNIX_PREFIX, strlen(UNIX_PREFIX)) == 0) {
+        sockaddr_un unix_address;
+        if (!make_unix_address(address + strlen(UNIX_PREFIX), &unix_address, out_error)) return false;
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (const sockaddr*)&unix_address, sizeof(unix_address)) != 0) {
+            *out_error = std::string("couldn't connect to \"") + address + "\": " + strerror(errno);
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    fd = for_each_tcp_address(address, false, out_error, [](const addrinfo* info) {
+        int fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (fd < 0) return -1;
+        if (connect(fd, info->ai_addr, info->ai_addrlen) != 0) {
+            close(fd);
+            return -1;
+        }
+
+        // messages are written whole, no point holding back the tail
+        int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        return fd;
+    });
+
+    return fd >= 0;
+#else
+    *out_error = "sockets aren't supported on this platform";
+    return false;
+#endif
+}
+
+void Socket::Close() {
+#ifdef RTRT_HAS_SOCKETS
+    if (fd >= 0) {
+        close(fd);
+    }
+#endif
+    fd = -1;
+}
+
+bool Socket::SendAll(const void* data, size_t size) {
+#ifdef RTRT_HAS_SOCKETS
+    const uint8_t* bytes = (const uint8_t*)data;
+    while (size > 0) {
+        // no SIGPIPE when the other end is gone, that's just a failed send
+        ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+
+        bytes += sent;
+        size -= (size_t)sent;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Socket::ReceiveAll(void* data, size_t size) {
+#ifdef RTRT_HAS_SOCKETS
+    uint8_t* bytes = (uint8_t*)data;
+    while (size > 0) {
+        ssize_t received = recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+
+        bytes += received;
+        size -= (size_t)received;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Socket::set_receive_timeout(double seconds) {
+#ifdef RTRT_HAS_SOCKETS
+    timeval timeout;
+    timeout.tv_sec = (time_t)seconds;
+    timeout.tv_usec = (suseconds_t)((seconds - (double)timeout.tv_sec) * 1e6);
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+}
+
+Listener::Listener() : fd(-1) { }
+
+Listener::~Listener() {
+    Close();
+}
+
+bool Listener::Open(const char* address, std::string* out_error) {
+    Close();
+
+#ifdef RTRT_HAS_SOCKETS
+    if (strncmp(address, UNIX_PREFIX, strlen(UNIX_PREFIX)) == 0) {
+        const char* path = address + strlen(UNIX_PREFIX);
+        sockaddr_un unix_address;
+        if (!make_unix_address(path, &unix_address, out_error)) return false;
+
+        // a socket file left over from a killed run would make bind fail
+        unlink(path);
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 ||
+            bind(fd, (const sockaddr*)&unix_address, sizeof(unix_address)) != 0 ||
+            listen(fd, LISTEN_BACKLOG) != 0) {
+            *out_error = std::string("couldn't listen on \"") + address + "\": " + strerror(errno);
+            Close();
+            return false;
+        }
+
+        unix_path = path;
+        return true;
+    }
+
+    fd = for_each_tcp_address(address, true, out_error, [](const addrinfo* info) {
+        int fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (fd < 0) return -1;
+
+        int enable = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        if (bind(fd, info->ai_addr, info->ai_addrlen) != 0 || listen(fd, LISTEN_BACKLOG) != 0) {
+            close(fd);
+            return -1;
+        }
+
+        return fd;
+    });
+
+    return fd >= 0;
+#else
+    *out_error = "sockets aren't supported on this platform";
+    return false;
+#endif
+}
+
+void Listener::Close() {
+#ifdef RTRT_HAS_SOCKETS
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!unix_path.empty()) {
+        unlink(unix_path.c_str());
+    }
+#endif
+    fd = -1;
+    unix_path.clear();
+}
+
+bool Listener::Accept(Socket* out_socket) {
+#ifdef RTRT_HAS_SOCKETS
+    int client = accept(fd, nullptr, nullptr);
+    if (client < 0) return false;
+
+    int enable = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    *out_socket = Socket(client);
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// addresses are either "unix:/path/to/socket" or "host:port" for tcp
+
+// a connected stream socket, closed when it goes out of scope
+class Socket {
+   private:
+    int fd;
+
+   public:
+    Socket();
+    explicit Socket(int fd);
+    ~Socket();
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+    Socket(Socket&& other);
+    Socket& operator=(Socket&& other);
+
+    bool Connect(const char* address, std::string* out_error);
+    void Close();
+
+    // block until every byte has gone out or come in, false if the
+    //   other end went away, errored or the receive timeout ran out
+    bool SendAll(const void* data, size_t size);
+    bool ReceiveAll(void* data, size_t size);
+
+    // 0 waits forever
+    void set_receive_timeout(double seconds);
+    bool is_open() const { return fd >= 0; }
+    int get_fd() const { return fd; }
+};
+
+class Listener {
+   private:
+    int fd;
+    // unix sockets leave a file behind that has to be removed
+    std::string unix_path;
+
+   public:
+    Listener();
+    ~Listener();
+    Listener(const Listener&) = delete;
+    Listener& operator=(const Listener&) = delete;
+
+    bool Open(const char* address, std::string* out_error);
+    void Close();
+
+    // only call once the fd polls readable, otherwise blocks
+    bool Accept(Socket* out_socket);
+
+    int get_fd() const { return fd; }
+};
@@ -0,0 +1,131 @@
+#include "worker.h"
+
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include "protocol.h"
+#include "../renderer.h"
+#include "../scenes.h"
+#include "../scene_file/scene_parser.h"
+#include "../scene_file/scene_loader.h"
+
+constexpr double CONNECT_RETRY_S = 10.0;
+constexpr uint32_t CONNECT_RETRY_INTERVAL_MS = 100;
+// workers render at full res only, low res never gets allocated
+constexpr float WORKER_LOW_RES_SCALE = 1.0f;
+
+namespace Distributed {
+    // everything a worker needs to render tiles of one frame
+    struct WorkerFrame {
+        uint32_t frame_id;
+        CompiledScene scene;
+        std::unique_ptr<Camera> camera;
+        std::unique_ptr<Renderer> renderer;
+    };
+
+    static bool load_frame(const std::vector<uint8_t>& payload, const ThreadPlacement& placement, WorkerFrame* out_frame, std::string* out_error) {
+        FrameMessage message;
+        if (payload.size() < sizeof(message)) {
+            *out_error = "frame message is truncated";
+            return false;
+        }
+        memcpy(&message, payload.data(), sizeof(message));
+        if (payload.size() != sizeof(message) + message.scene_text_size) {
+            *out_error = "frame message is the wrong size";
+            return false;
+        }
+
+        // indexes the renderer's kernel table, so never trust it
+        if (message.render_preset >= RenderKernel::PRESET_COUNT) {
+            *out_error = "frame message has an unknown render preset";
+            return false;
+        }
+
+        if (message.scene_text_size == 0) {
+            out_frame->scene = CompiledScene::Compile(Scenes::create_default());
+        } else {
+            std::string_view text((const char*)payload.data() + sizeof(message), message.scene_text_size);
+            SceneData data;
+            if (!SceneFile::Parse(text, "<coordinator>", &data, out_error)) return false;
+            out_frame->scene = SceneFile::Compile(data.get_view());
+        }
+
+        out_frame->frame_id = message.frame_id;
+        out_frame->camera = std::make_unique<Camera>(create_camera(message.camera));
+        out_frame->renderer = std::make_unique<Renderer>(message.width, message.height, WORKER_LOW_RES_SCALE, placement);
+        out_frame->renderer->set_sampler_type((SamplerType)message.sampler_type);
+        out_frame->renderer->set_render_preset((RenderPreset)message.render_preset);
+        out_frame->renderer->set_samples_per_pixel(message.samples_per_pixel);
+        return true;
+    }
+
+    static bool connect_with_retry(const char* address, Socket* out_socket, std::string* out_error) {
+        auto start = std::chrono::steady_clock::now();
+        while (!out_socket->Connect(address, out_error)) {
+            double waited = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (waited > CONNECT_RETRY_S) return false;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(CONNECT_RETRY_INTERVAL_MS));
+        }
+
+        return true;
+    }
+
+    bool RunWorker(const char* address, const ThreadPlacement& placement, std::string* out_error) {
+        Socket socket;
+        if (!connect_with_retry(address, &socket, out_error)) return false;
+
+        HelloMessage hello = create_hello(std::thread::hardware_concurrency());
+        if (!SendMessage(&socket, MessageType::Hello, &hello, sizeof(hello))) {
+            *out_error = "lost the coordinator while saying hello";
+            return false;
+        }
+
+        WorkerFrame frame;
+        std::vector<uint8_t> payload;
+        std::vector<float> sums;
+        uint32_t tiles_rendered = 0;
+        while (true) {
+            MessageType type;
+            if (!ReceiveMessage(&socket, &type, &payload)) {
+                *out_error = "lost the coordinator";
+                return false;
+            }
+
+            if (type == MessageType::Finished) break;
+
+            if (type == MessageType::Frame) {
+                if (!load_frame(payload, placement, &frame, out_error)) return false;
+                std::cout << "worker: got frame " << frame.frame_id << ", "
+                          << frame.scene.get_sphere_count() << " spheres\n";
+                continue;
+            }
+
+            if (type != MessageType::Tile || payload.size() != sizeof(TileMessage) || frame.renderer == nullptr) {
+                *out_error = "unexpected message from the coordinator";
+                return false;
+            }
+
+            TileMessage tile;
+            memcpy(&tile, payload.data(), sizeof(tile));
+            if (tile.frame_id != frame.frame_id) {
+                *out_error = "tile is for a frame this worker doesn't have";
+                return false;
+            }
+
+            sums.resize((size_t)tile.width * tile.height * 3);
+            frame.renderer->RenderRegion(tile.x, tile.y, tile.width, tile.height, *frame.camera, frame.scene, sums.data());
+
+            if (!SendMessage(&socket, MessageType::TileResult, &tile, sizeof(tile), sums.data(), sums.size() * sizeof(float))) {
+                *out_error = "lost the coordinator while sending a tile";
+                return false;
+            }
+            tiles_rendered++;
+        }
+
+        std::cout << "worker: rendered " << tiles_rendered << " tiles\n";
+        return true;
+    }
+};
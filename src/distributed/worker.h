@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+#include "../cpu_topology.h"
+
+namespace Distributed {
+    // connects to a coordinator (retrying for a while so workers can be
+    //   started first) and renders the tiles it's sent with a local
+    //   Renderer until it's told to stop or the connection drops.
+    //   placement is where its render threads run
+    bool RunWorker(const char* address, const ThreadPlacement& placement, std::string* out_error);
+};
@@ -0,0 +1,62 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+
+FrameArena::FrameArena(size_t initial_size)
+  : block_index(0),
+    offset(0),
+    used(0),
+    high_water(0) {
+    AddBlock(initial_size);
+}
+
+void FrameArena::AddBlock(size_t min_size) {
+    // at least double so a frame that's outgrown the arena
+    //   doesn't keep adding small blocks
+    size_t size = std::max(min_size, blocks.empty() ? 0 : blocks.back().size * 2);
+    blocks.push_back({std::make_unique<unsigned char[]>(size), size});
+}
+
+void* FrameArena::Allocate(size_t bytes, size_t alignment) {
+    while (true) {
+        Block& block = blocks[block_index];
+        uintptr_t base = (uintptr_t)block.data.get();
+        size_t start = ((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+
+        if (start + bytes <= block.size) {
+            used += start + bytes - offset;
+            high_water = std::max(high_water, used);
+            offset = start + bytes;
+            return block.data.get() + start;
+        }
+
+        // the rest of this block is wasted, it's only until the next Reset
+        used += block.size - offset;
+        block_index++;
+        offset = 0;
+        if (block_index == blocks.size()) {
+            AddBlock(bytes + alignment);
+        }
+    }
+}
+
+void FrameArena::Reset() {
+    if (blocks.size() > 1) {
+        size_t size = get_capacity();
+        blocks.clear();
+        AddBlock(size);
+    }
+
+    block_index = 0;
+    offset = 0;
+    used = 0;
+}
+
+size_t FrameArena::get_capacity() const {
+    size_t capacity = 0;
+    for (const Block& block : blocks) {
+        capacity += block.size;
+    }
+
+    return capacity;
+}
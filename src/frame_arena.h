@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+// bump allocator for scratch memory that only lives until the end of a
+//   frame. nothing is freed on its own, Reset hands everything back at
+//   once. one per thread so allocating never takes a lock
+class FrameArena {
+   private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    // always at least one, extra ones only appear when a frame
+    //   needs more than the first holds
+    std::vector<Block> blocks;
+    size_t block_index;
+    size_t offset;
+    // most bytes handed out since the last Reset, and the most ever
+    size_t used;
+    size_t high_water;
+
+    void AddBlock(size_t min_size);
+
+   public:
+    FrameArena(size_t initial_size);
+
+    // bytes aligned to alignment (a power of two), valid until Reset
+    void* Allocate(size_t bytes, size_t alignment);
+
+    template <typename T>
+    T* AllocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena memory is never destructed");
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // frees everything allocated since the last Reset. if that didn't fit in
+    //   one block the blocks are merged into one big enough for all of it,
+    //   so a frame that keeps asking for the same amount stops allocating
+    void Reset();
+
+    size_t get_capacity() const;
+    size_t get_high_water() const { return high_water; }
+};
@@ -0,0 +1,84 @@
+#include "frame_pipeline.h"
+
+#include <algorithm>
+#include <cstring>
+
+FramePipeline::FramePipeline(Renderer* renderer, uint32_t width, uint32_t height, uint32_t depth, PresentFunc present, uint8_t* display)
+  : renderer(renderer),
+    frame_size((size_t)width * height * 4),
+    frames(std::max(depth, 1u)),
+    next_frame(0),
+    in_flight(0),
+    open(true),
+    present(present) {
+    for (Frame& frame : frames) {
+        if (frames.size() == 1 && display != nullptr) {
+            // tiles nobody has rendered yet show up black, like fresh storage
+            memset(display, 0, frame_size);
+            frame.pixels = display;
+        } else {
+            frame.storage.resize(frame_size);
+            frame.pixels = frame.storage.data();
+        }
+        frame.output_version = 0;
+    }
+}
+
+FramePipeline::~FramePipeline() {
+    Drain();
+}
+
+Task FramePipeline::RenderStage(Frame* frame, const CompiledScene* scene) {
+    co_await render_thread.Schedule();
+
+    renderer->RenderFrame(frame->pixels, *frame->camera, *scene);
+
+    // frames render in order, the one before this is complete
+    //   up to the version before this one's
+    size_t index = frame - frames.data();
+    const Frame& previous = frames[(index + frames.size() - 1) % frames.size()];
+    if (&previous != frame) {
+        renderer->CopyOutputTiles(frame->output_version, previous.pixels, frame->pixels);
+    }
+    frame->output_version = renderer->get_output_version();
+}
+
+Task FramePipeline::RunFrame(Frame* frame, const CompiledScene* scene) {
+    frame->render = RenderStage(frame, scene);
+    co_await frame->render;
+
+    co_await caller_queue.Schedule();
+
+    // frames that finish after the window closed are dropped
+    if (open) {
+        open = present(frame->pixels);
+    }
+    in_flight--;
+}
+
+bool FramePipeline::IsRendererIdle() const {
+    // frames render in submission order, so the last one is enough
+    const Frame& last = frames[(next_frame + frames.size() - 1) % frames.size()];
+    return last.render.is_done();
+}
+
+bool FramePipeline::BeginFrame() {
+    caller_queue.RunUntil([this] {
+        return !open || (IsRendererIdle() && in_flight < frames.size());
+    });
+
+    return open;
+}
+
+void FramePipeline::Submit(const Camera& camera, const CompiledScene& scene) {
+    Frame& frame = frames[next_frame];
+    next_frame = (next_frame + 1) % frames.size();
+    in_flight++;
+
+    frame.camera.emplace(camera);
+    frame.task = RunFrame(&frame, &scene);
+}
+
+void FramePipeline::Drain() {
+    caller_queue.RunUntil([this] { return in_flight == 0; });
+}
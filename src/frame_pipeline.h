@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <functional>
+#include <optional>
+#include "task.h"
+#include "renderer.h"
+#include "camera.h"
+#include "objects/compiled_scene.h"
+
+// runs frames as coroutines in stages: the caller's update (input, camera,
+//   scene edits) on its own thread, rendering and resolving on a render
+//   thread that fans out over the renderer's pool, then presenting back on
+//   the caller's thread. with a depth above 1 the present of one frame
+//   (and its vsync wait) overlaps rendering the next, at the cost of each
+//   frame showing up depth - 1 frames later. frames render straight into
+//   the buffer they're presented from
+class FramePipeline {
+   public:
+    // shows a finished frame, false when the window's been closed
+    typedef std::function<bool(const uint8_t* pixels)> PresentFunc;
+
+   private:
+    struct Frame {
+        // what the frame renders into and is presented from, storage
+        //   unless it's the caller's display
+        uint8_t* pixels;
+        std::vector<uint8_t> storage;
+        // Renderer::get_output_version pixels are complete as of
+        uint64_t output_version;
+        // the camera has no default, empty until the first submit
+        std::optional<Camera> camera;
+        Task render;
+        Task task;
+    };
+
+    Renderer* renderer;
+    size_t frame_size;
+    // full res frames only redraw dirty tiles on top of the last one,
+    //   so after rendering into its buffer a frame copies over whatever
+    //   the frames since that buffer's last use wrote
+    std::vector<Frame> frames;
+    uint32_t next_frame;
+    uint32_t in_flight;
+    bool open;
+    PresentFunc present;
+    TaskQueue caller_queue;
+    TaskThread render_thread;
+
+    Task RunFrame(Frame* frame, const CompiledScene* scene);
+    Task RenderStage(Frame* frame, const CompiledScene* scene);
+    bool IsRendererIdle() const;
+
+   public:
+    // depth is how many frames can be in flight, 1 renders and presents in
+    //   turn. with depth 1 and a display (e.g. a window's own pixels) frames
+    //   render right into it and present is handed display back, nothing
+    //   gets copied. otherwise every frame has a buffer of its own
+    FramePipeline(Renderer* renderer, uint32_t width, uint32_t height, uint32_t depth, PresentFunc present, uint8_t* display = nullptr);
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    // presents finished frames until the renderer is idle and there's room
+    //   for another frame, after that the renderer and scene can be edited
+    //   until Submit. false once present has returned false
+    bool BeginFrame();
+
+    // queues a frame of scene from camera, scene has to stay
+    //   untouched until the next BeginFrame returns
+    void Submit(const Camera& camera, const CompiledScene& scene);
+
+    // presents everything still in flight
+    void Drain();
+
+    // the last submitted frame's buffer, e.g. for Renderer::ResolveFrame
+    //   between frames. the next frame renders on top of it
+    uint8_t* get_target() { return frames[(next_frame + frames.size() - 1) % frames.size()].pixels; }
+    uint32_t get_depth() const { return (uint32_t)frames.size(); }
+};
@@ -0,0 +1,64 @@
+#include "image_writer.h"
+
+PpmBandWriter::PpmBandWriter()
+  : width(0),
+    height(0),
+    rows_written(0) { }
+
+bool PpmBandWriter::Open(const char* path, uint32_t width, uint32_t height, std::string* out_error) {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        *out_error = std::string("couldn't open \"") + path + "\" for writing";
+        return false;
+    }
+
+    this->width = width;
+    this->height = height;
+    rows_written = 0;
+    row.resize((size_t)width * 3);
+
+    out << "P6\n" << width << " " << height << "\n255\n";
+    return true;
+}
+
+bool PpmBandWriter::WriteRows(const uint8_t* rgba, uint32_t rows, std::string* out_error) {
+    if (rows_written + rows > height) {
+        *out_error = "wrote more rows than the image has";
+        return false;
+    }
+
+    for (uint32_t y = 0; y < rows; y++) {
+        const uint8_t* src = rgba + (size_t)y * width * 4;
+        for (uint32_t x = 0; x < width; x++) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+
+        out.write((const char*)row.data(), row.size());
+    }
+
+    rows_written += rows;
+    if (!out) {
+        *out_error = "couldn't write image rows";
+        return false;
+    }
+
+    return true;
+}
+
+bool PpmBandWriter::Close(std::string* out_error) {
+    out.close();
+
+    if (rows_written != height) {
+        *out_error = "image is missing rows";
+        return false;
+    }
+
+    if (out.fail()) {
+        *out_error = "couldn't finish writing the image";
+        return false;
+    }
+
+    return true;
+}
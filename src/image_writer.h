@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+
+// writes a binary PPM a band of rows at a time, the header goes out up
+//   front so only the band being written is ever held in memory
+class PpmBandWriter {
+   private:
+    std::ofstream out;
+    uint32_t width;
+    uint32_t height;
+    uint32_t rows_written;
+    // one RGB row, PPM has no alpha
+    std::vector<uint8_t> row;
+
+   public:
+    PpmBandWriter();
+
+    bool Open(const char* path, uint32_t width, uint32_t height, std::string* out_error);
+
+    // rgba is rows * width tightly packed RGBA pixels
+    bool WriteRows(const uint8_t* rgba, uint32_t rows, std::string* out_error);
+
+    // fails if fewer rows than the header promised were written
+    bool Close(std::string* out_error);
+};
@@ -0,0 +1,56 @@
+#include "interleave.h"
+
+#include <cstring>
+
+uint32_t Interleave::get_phase_count(InterleaveMode mode) {
+    switch (mode) {
+        case InterleaveMode::Off: return 1;
+        case InterleaveMode::Checkerboard: return 2;
+        case InterleaveMode::Quad: return 4;
+    }
+
+    return 1;
+}
+
+bool Interleave::get_row_pattern(InterleaveMode mode, uint32_t phase, uint32_t y, uint32_t* out_x_first, uint32_t* out_x_step) {
+    switch (mode) {
+        case InterleaveMode::Off:
+            *out_x_first = 0;
+            *out_x_step = 1;
+            return true;
+        case InterleaveMode::Checkerboard:
+            *out_x_first = (y + phase) & 1;
+            *out_x_step = 2;
+            return true;
+        case InterleaveMode::Quad: {
+            uint32_t slot = QUAD_ORDER[phase & 3];
+            *out_x_first = slot & 1;
+            *out_x_step = 2;
+            return (slot >> 1) == (y & 1);
+        }
+    }
+
+    return false;
+}
+
+const char* Interleave::mode_name(InterleaveMode mode) {
+    switch (mode) {
+        case InterleaveMode::Off: return "off";
+        case InterleaveMode::Checkerboard: return "checkerboard";
+        case InterleaveMode::Quad: return "quad";
+    }
+
+    return "unknown";
+}
+
+bool Interleave::parse_mode(const char* name, InterleaveMode* out_mode) {
+    static const InterleaveMode modes[] = {InterleaveMode::Off, InterleaveMode::Checkerboard, InterleaveMode::Quad};
+    for (InterleaveMode mode : modes) {
+        if (strcmp(name, mode_name(mode)) == 0) {
+            *out_mode = mode;
+            return true;
+        }
+    }
+
+    return false;
+}
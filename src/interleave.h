@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+// how frames rendered while moving are split up when they're interleaved
+//   instead of dropped to low res. each frame shades one phase's pixels at
+//   full res and fills in the rest from the frame before and the pixels
+//   around them
+enum class InterleaveMode {
+    // moving frames drop to low res instead
+    Off,
+    // alternating halves, like the black and white squares of a checkerboard
+    Checkerboard,
+    // one pixel of every 2x2 quad per frame, rotating through all four
+    Quad
+};
+
+namespace Interleave {
+    // which pixel of a 2x2 quad (x + 2 * y) each Quad phase shades, the
+    //   diagonal pairs first so every two frames cover a checkerboard
+    constexpr uint32_t QUAD_ORDER[4] = {0, 3, 1, 2};
+
+    // frames it takes for every pixel to be shaded once
+    uint32_t get_phase_count(InterleaveMode mode);
+
+    // whether pixel x, y is shaded on the given phase
+    inline bool is_shaded(InterleaveMode mode, uint32_t phase, uint32_t x, uint32_t y) {
+        switch (mode) {
+            case InterleaveMode::Off:
+                return true;
+            case InterleaveMode::Checkerboard:
+                return ((x + y + phase) & 1) == 0;
+            case InterleaveMode::Quad:
+                return (x & 1) + (y & 1) * 2 == QUAD_ORDER[phase & 3];
+        }
+
+        return true;
+    }
+
+    // first pixel of row y that's shaded on the given phase and how far
+    //   apart they are along the row, returns false if there aren't any
+    bool get_row_pattern(InterleaveMode mode, uint32_t phase, uint32_t y, uint32_t* out_x_first, uint32_t* out_x_step);
+
+    const char* mode_name(InterleaveMode mode);
+    bool parse_mode(const char* name, InterleaveMode* out_mode);
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// a void(uint32_t thread_index) callable stored inline instead of on the
+//   heap like std::function does for anything bigger than two pointers.
+//   captures have to fit in CAPACITY bytes, which is checked at compile time
+class Job {
+   public:
+    static constexpr size_t CAPACITY = 64;
+
+   private:
+    // what to do with whatever's in storage, one set per callable type
+    struct Operations {
+        void (*invoke)(void* storage, uint32_t thread_index);
+        void (*move)(void* from, void* to);
+        void (*destroy)(void* storage);
+    };
+
+    template <typename F>
+    static constexpr Operations operations_for = {
+        [](void* storage, uint32_t thread_index) { (*static_cast<F*>(storage))(thread_index); },
+        [](void* from, void* to) { new (to) F(std::move(*static_cast<F*>(from))); },
+        [](void* storage) { static_cast<F*>(storage)->~F(); }
+    };
+
+    alignas(std::max_align_t) unsigned char storage[CAPACITY];
+    const Operations* operations;
+
+    void Reset() {
+        if (operations != nullptr) {
+            operations->destroy(storage);
+            operations = nullptr;
+        }
+    }
+
+   public:
+    Job() : operations(nullptr) { }
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Job>>>
+    Job(F&& func) {
+        using Stored = std::decay_t<F>;
+        static_assert(sizeof(Stored) <= CAPACITY, "job captures don't fit in Job::CAPACITY, capture a pointer to them instead");
+        static_assert(alignof(Stored) <= alignof(std::max_align_t), "job captures are over-aligned");
+
+        new (storage) Stored(std::forward<F>(func));
+        operations = &operations_for<Stored>;
+    }
+
+    Job(Job&& other) : operations(other.operations) {
+        if (operations != nullptr) {
+            operations->move(other.storage, storage);
+            other.Reset();
+        }
+    }
+
+    Job& operator=(Job&& other) {
+        if (this != &other) {
+            Reset();
+            operations = other.operations;
+            if (operations != nullptr) {
+                operations->move(other.storage, storage);
+                other.Reset();
+            }
+        }
+
+        return *this;
+    }
+
+    Job(const Job&) = delete;
+    Job& operator=(const Job&) = delete;
+
+    ~Job() { Reset(); }
+
+    void operator()(uint32_t thread_index) { operations->invoke(storage, thread_index); }
+    explicit operator bool() const { return operations != nullptr; }
+};
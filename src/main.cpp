@@ -4,21 +4,104 @@
 #include "vec3.h"
 #include "camera.h"
 #include "ray.h"
-#include "objects/sphere.h"
-#include "objects/hittable_list.h"
 #include "renderer.h"
-#include "materials/metal.h"
-#include "materials/lambertian.h"
-#include <memory>
+#include "scenes.h"
+#include "benchmark.h"
+#include "profiler.h"
+#include "ray_stats.h"
+#include "samplers/hash.h"
+#include "scene_file/scene_loader.h"
+#include "image_writer.h"
+#include "distributed/coordinator.h"
+#include "distributed/worker.h"
+#include "allocation_counter.h"
+#include "frame_pipeline.h"
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
 
 constexpr uint32_t WIDTH = 800;
 constexpr uint32_t HEIGHT = 600;
 constexpr float CAM_SPEED = 3.0f;
 constexpr float CAM_LOOK_SPEED = 0.01f;
+constexpr float LOW_RES_SCALE = 0.1f;
+// enough frames for the default scene's first full res pass to
+//   finish inside the default frame budget
+constexpr uint32_t DEFAULT_HEADLESS_FRAMES = HEIGHT / 4;
+constexpr double TITLE_UPDATE_INTERVAL = 0.5;
+constexpr const char* APP_NAME = "!! rtrt_cpu !!";
+constexpr float ANIMATE_BOB_HEIGHT = 0.5f;
+constexpr float ANIMATE_BOB_SPEED = 2.0f;
+// rows per streamed band of an offline render
+constexpr uint32_t OFFLINE_BAND_HEIGHT = 16;
+constexpr uint32_t OFFLINE_PROGRESS_STEPS = 10;
+// samples added per pass of a progressive render when --spp isn't given
+constexpr uint32_t DEFAULT_SAMPLES_PER_PASS = 4;
+constexpr double DEFAULT_WORKER_TIMEOUT_S = 30.0;
+constexpr uint32_t TONE_MAP_COUNT = 3;
+// frames in flight, 2 presents one while rendering the next
+constexpr uint32_t DEFAULT_PIPELINE_DEPTH = 2;
+constexpr uint32_t SHADING_RATE_SOURCE_COUNT = 4;
+constexpr uint32_t INTERLEAVE_MODE_COUNT = 3;
+// the centre sphere's material in the default scene
+constexpr uint32_t EDIT_MATERIAL_INDEX = 1;
+
+struct Options {
+    bool bench = false;
+    const char* bench_name = nullptr;
+    bool headless = false;
+    bool low_res = false;
+    UpscaleFilter upscale_filter = UpscaleFilter::EdgeAware;
+    ShadingRateSource shading_rate_source = ShadingRateSource::Off;
+    InterleaveMode interleave_mode = InterleaveMode::Off;
+    RenderPreset render_preset = RenderPreset::Final;
+    uint32_t frames = DEFAULT_HEADLESS_FRAMES;
+    // 0 keeps the renderer's default
+    double frame_budget_ms = 0.0;
+    uint32_t pipeline_depth = DEFAULT_PIPELINE_DEPTH;
+    const char* trace_path = nullptr;
+    bool stats_title = false;
+    bool animate = false;
+    const char* scene_path = nullptr;
+    const char* output_path = nullptr;
+    uint32_t output_width = WIDTH;
+    uint32_t output_height = HEIGHT;
+    // 0 keeps the renderer's default
+    uint32_t samples_per_pixel = 0;
+    // progressive offline render with this many passes, 0 streams bands
+    uint32_t passes = 0;
+    const char* checkpoint_path = nullptr;
+    uint32_t checkpoint_every = 1;
+    // distributed rendering, see distributed/coordinator.h
+    const char* coordinator_address = nullptr;
+    const char* worker_address = nullptr;
+    double worker_timeout_s = DEFAULT_WORKER_TIMEOUT_S;
+    ResolveSettings resolve;
+    // render threads, see cpu_topology.h
+    ThreadPlacement placement;
+};
 
 // TODO: next is dialectrics (chapter 11)
 //   https://raytracing.github.io/books/RayTracingInOneWeekend.html#dielectrics
 
+// 'p' cycles the render presets, see render_kernel.h
+static void update_render_preset(Renderer* renderer) {
+    if (Thirteen::GetKey('p') && !Thirteen::GetKeyLastFrame('p')) {
+        RenderPreset preset = (RenderPreset)(((uint32_t)renderer->get_render_preset() + 1) % RenderKernel::PRESET_COUNT);
+        renderer->set_render_preset(preset);
+        std::cout << "render preset: " << RenderKernel::preset_name(preset) << "\n";
+    }
+}
+
 // returns whether or not something has moved this frame
 static bool update_camera(Camera& camera) {
     bool something_moved = false;
@@ -71,41 +154,725 @@ static bool update_camera(Camera& camera) {
     return something_moved;
 }
 
-int main() {
+// bobs every sphere but the ground up and down, the scene's
+//   hierarchy is refit (or rebuilt) before the frame is traced
+static void animate_scene(CompiledScene* scene, const std::vector<Vec3f>& base_centers, double time, ThreadPool* pool) {
+    for (uint32_t i = 1; i < base_centers.size(); i++) {
+        float offset = std::sin((float)time * ANIMATE_BOB_SPEED + i) * ANIMATE_BOB_HEIGHT;
+        scene->SetSphereCenter(i, base_centers[i] + Vec3f(0, offset, 0));
+    }
+
+    scene->Update(pool);
+}
+
+// look-dev style edit, gives the centre sphere a new colour and
+//   only re-renders the tiles that saw its material
+static void recolor_material(CompiledScene* scene, Renderer* renderer, uint32_t edit_index) {
+    MaterialRecord record = scene->get_materials().get_record(EDIT_MATERIAL_INDEX);
+    record.albedo = Vec3f(
+        Hash::to_unit_float(Hash::mix(edit_index * 3 + 0)),
+        Hash::to_unit_float(Hash::mix(edit_index * 3 + 1)),
+        Hash::to_unit_float(Hash::mix(edit_index * 3 + 2))
+    );
+
+    scene->SetMaterial(EDIT_MATERIAL_INDEX, record);
+    renderer->InvalidateMaterial(EDIT_MATERIAL_INDEX);
+}
+
+// 't' cycles the tone map and '[' / ']' halve and double exposure,
+//   returns whether anything changed. these only touch the resolve
+//   so finished pixels are re-resolved rather than re-rendered
+static bool update_resolve_settings(Renderer* renderer) {
+    ResolveSettings settings = renderer->get_resolve_settings();
+    bool changed = false;
+
+    if (Thirteen::GetKey('t') && !Thirteen::GetKeyLastFrame('t')) {
+        settings.tone_map = (ToneMap)(((uint32_t)settings.tone_map + 1) % TONE_MAP_COUNT);
+        std::cout << "tone map: " << Resolve::tone_map_name(settings.tone_map) << "\n";
+        changed = true;
+    }
+    if (Thirteen::GetKey('[') && !Thirteen::GetKeyLastFrame('[')) {
+        settings.exposure *= 0.5f;
+        changed = true;
+    }
+    if (Thirteen::GetKey(']') && !Thirteen::GetKeyLastFrame(']')) {
+        settings.exposure *= 2.0f;
+        changed = true;
+    }
+
+    renderer->set_resolve_settings(settings);
+    return changed;
+}
+
+// 'v' cycles where the variable shading rates come from,
+//   and the fovea follows the mouse
+static void update_shading_rates(Renderer* renderer) {
+    if (Thirteen::GetKey('v') && !Thirteen::GetKeyLastFrame('v')) {
+        ShadingRateSource source = (ShadingRateSource)(((uint32_t)renderer->get_shading_rate_source() + 1) % SHADING_RATE_SOURCE_COUNT);
+        renderer->set_shading_rate_source(source);
+        std::cout << "variable rate shading: " << ShadingRate::source_name(source) << "\n";
+    }
+
+    int mouse_x = 0;
+    int mouse_y = 0;
+    Thirteen::GetMousePosition(mouse_x, mouse_y);
+    renderer->set_focus((float)mouse_x, (float)mouse_y);
+}
+
+// 'i' cycles between dropping to low res while moving and
+//   the interleaved modes
+static void update_interleave_mode(Renderer* renderer) {
+    if (Thirteen::GetKey('i') && !Thirteen::GetKeyLastFrame('i')) {
+        InterleaveMode mode = (InterleaveMode)(((uint32_t)renderer->get_interleave_mode() + 1) % INTERLEAVE_MODE_COUNT);
+        renderer->set_interleave_mode(mode);
+        std::cout << "interleaved rendering while moving: " << Interleave::mode_name(mode) << "\n";
+    }
+}
+
+static bool parse_options(int argc, char** argv, Options* out_options) {
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(argv[i], "--bench") == 0) {
+            out_options->bench = true;
+            if (has_value && argv[i + 1][0] != '-') {
+                out_options->bench_name = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            out_options->headless = true;
+        } else if (strcmp(argv[i], "--low-res") == 0) {
+            out_options->low_res = true;
+        } else if (strcmp(argv[i], "--upscale") == 0 && has_value) {
+            if (!Upscaler::parse_filter(argv[++i], &out_options->upscale_filter)) {
+                std::cerr << "expected --upscale nearest, bilinear or edge_aware, got \"" << argv[i] << "\"\n";
+                return false;
+            }
+        } else if (strcmp(argv[i], "--vrs") == 0 && has_value) {
+            if (!ShadingRate::parse_source(argv[++i], &out_options->shading_rate_source)) {
+                std::cerr << "expected --vrs off, center, cursor or variance, got \"" << argv[i] << "\"\n";
+                return false;
+            }
+        } else if (strcmp(argv[i], "--interleave") == 0 && has_value) {
+            if (!Interleave::parse_mode(argv[++i], &out_options->interleave_mode)) {
+                std::cerr << "expected --interleave off, checkerboard or quad, got \"" << argv[i] << "\"\n";
+                return false;
+            }
+        } else if (strcmp(argv[i], "--preset") == 0 && has_value) {
+            if (!RenderKernel::parse_preset(argv[++i], &out_options->render_preset)) {
+                std::cerr << "expected --preset final, interactive or preview, got \"" << argv[i] << "\"\n";
+                return false;
+            }
+        } else if (strcmp(argv[i], "--frames") == 0 && has_value) {
+            out_options->frames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--pipeline-depth") == 0 && has_value) {
+            out_options->pipeline_depth = std::max(1u, (uint32_t)strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--frame-budget") == 0 && has_value) {
+            out_options->frame_budget_ms = strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--trace") == 0 && has_value) {
+            out_options->trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--stats-title") == 0) {
+            out_options->stats_title = true;
+        } else if (strcmp(argv[i], "--animate") == 0) {
+            out_options->animate = true;
+        } else if (strcmp(argv[i], "--scene") == 0 && has_value) {
+            out_options->scene_path = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && has_value) {
+            out_options->output_path = argv[++i];
+        } else if (strcmp(argv[i], "--size") == 0 && has_value) {
+            unsigned width = 0;
+            unsigned height = 0;
+            if (sscanf(argv[++i], "%ux%u", &width, &height) != 2 || width == 0 || height == 0) {
+                std::cerr << "expected --size WIDTHxHEIGHT, got \"" << argv[i] << "\"\n";
+                return false;
+            }
+            out_options->output_width = width;
+            out_options->output_height = height;
+        } else if (strcmp(argv[i], "--spp") == 0 && has_value) {
+            out_options->samples_per_pixel = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--passes") == 0 && has_value) {
+            out_options->passes = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && has_value) {
+            out_options->checkpoint_path = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-every") == 0 && has_value) {
+            out_options->checkpoint_every = std::max(1u, (uint32_t)strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--coordinator") == 0 && has_value) {
+            out_options->coordinator_address = argv[++i];
+        } else if (strcmp(argv[i], "--worker") == 0 && has_value) {
+            out_options->worker_address = argv[++i];
+        } else if (strcmp(argv[i], "--exposure") == 0 && has_value) {
+            out_options->resolve.exposure = strtof(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--tonemap") == 0 && has_value) {
+            if (!Resolve::parse_tone_map(argv[++i], &out_options->resolve.tone_map)) {
+                std::cerr << "expected --tonemap clamp, reinhard or aces, got \"" << argv[i] << "\"\n";
+                return false;
+            }
+        } else if (strcmp(argv[i], "--dither") == 0) {
+            out_options->resolve.dither = true;
+        } else if (strcmp(argv[i], "--worker-timeout") == 0 && has_value) {
+            out_options->worker_timeout_s = strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+            out_options->placement.thread_count = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--pin") == 0 && has_value) {
+            if (!CpuTopology::parse_policy(argv[++i], &out_options->placement.policy)) {
+                std::cerr << "expected --pin off, cores or smt, got \"" << argv[i] << "\"\n";
+                return false;
+            }
+        } else if (strcmp(argv[i], "--cpus") == 0 && has_value) {
+            if (!CpuTopology::parse_cpu_list(argv[++i], &out_options->placement.cpus)) {
+                std::cerr << "expected --cpus as a list like 0-3,8, got \"" << argv[i] << "\"\n";
+                return false;
+            }
+        } else if (strcmp(argv[i], "--numa-node") == 0 && has_value) {
+            out_options->placement.numa_node = (int32_t)strtol(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "unknown option \"" << argv[i] << "\"\n";
+            std::cerr << "usage: build [--bench [name]] [--headless] [--low-res] [--upscale nearest|bilinear|edge_aware] [--vrs off|center|cursor|variance] [--interleave off|checkerboard|quad] [--frames N] [--frame-budget ms] [--pipeline-depth N] [--trace file.json] [--stats-title] [--animate] [--scene file.scene]\n"
+                      << "       (any render also takes [--exposure E] [--tonemap clamp|reinhard|aces] [--dither] [--preset final|interactive|preview])\n"
+                      << "       (and [--threads N] [--pin off|cores|smt] [--cpus 0-3,8] [--numa-node N])\n"
+                      << "       build --output file.ppm [--size WxH] [--spp N] [--scene file.scene]\n"
+                      << "       build --output file.ppm --passes N [--spp per pass] [--checkpoint file] [--checkpoint-every K] [--size WxH] [--scene file.scene]\n"
+                      << "       build --coordinator unix:path|host:port --output file.ppm [--size WxH] [--spp N] [--scene file.scene] [--worker-timeout seconds]\n"
+                      << "       build --worker unix:path|host:port\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// peak resident memory of the whole process, 0 where it isn't known
+static uint64_t get_peak_memory_bytes() {
+#ifdef __linux__
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        // linux reports kilobytes
+        return (uint64_t)usage.ru_maxrss * 1024;
+    }
+#endif
+
+    return 0;
+}
+
+// loads --scene when given, otherwise the built in default scene
+static bool load_scene(const Options& options, CompiledScene* out_scene, Camera* out_camera) {
+    if (options.scene_path == nullptr) {
+        *out_scene = CompiledScene::Compile(Scenes::create_default());
+        return true;
+    }
+
+    SceneFile::LoadedScene loaded;
+    SceneFile::LoadReport report;
+    std::string error;
+    if (!SceneFile::Load(options.scene_path, &loaded, &report, &error)) {
+        std::cerr << error << "\n";
+        return false;
+    }
+
+    if (report.from_cache) {
+        std::cout << "loaded " << options.scene_path << " from its cache in " << report.cache_load_ms << " ms\n";
+    } else {
+        std::cout << "parsed " << options.scene_path << " in " << report.parse_ms << " ms";
+        if (report.cache_message.empty()) {
+            std::cout << ", wrote its cache in " << report.cache_write_ms << " ms\n";
+        } else {
+            std::cout << "\n";
+        }
+    }
+
+    if (!report.cache_message.empty()) {
+        std::cout << "  (cache not used: " << report.cache_message << ")\n";
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    *out_scene = SceneFile::Compile(loaded.view);
+    *out_camera = SceneFile::create_camera(loaded.view, (float)WIDTH / HEIGHT);
+    double compile_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "compiled in " << compile_ms << " ms: "
+              << loaded.view.materials.size() << " materials, "
+              << loaded.view.world_spheres.size() << " spheres, "
+              << loaded.view.assets.size() << " assets ("
+              << loaded.view.asset_spheres.size() << " spheres), "
+              << loaded.view.instances.size() << " instances, "
+              << loaded.view.get_byte_size() / 1024.0 << " KB of scene data\n";
+    return true;
+}
+
+static void write_trace(const Options& options) {
+    if (options.trace_path == nullptr) return;
+
+    if (!Profiler::is_enabled()) {
+        std::cerr << "profiling isn't compiled in, rebuild with \"make clean && make PROFILE=1\"\n";
+        return;
+    }
+
+    if (Profiler::WriteChromeTrace(options.trace_path)) {
+        std::cout << "wrote trace to " << options.trace_path << "\n";
+    }
+}
+
+// renders frames exactly like the window loop does but into
+//   a plain buffer, for profiling on machines without a display
+static int run_headless(const Options& options) {
+    std::vector<uint8_t> pixels(WIDTH * HEIGHT * 4);
+
+    Camera camera = Scenes::create_default_camera((float)WIDTH / HEIGHT);
+    CompiledScene scene;
+    if (!load_scene(options, &scene, &camera)) {
+        return 1;
+    }
+
+    Renderer renderer(WIDTH, HEIGHT, LOW_RES_SCALE, options.placement);
+    renderer.set_resolve_settings(options.resolve);
+    renderer.set_upscale_filter(options.upscale_filter);
+    renderer.set_shading_rate_source(options.shading_rate_source);
+    renderer.set_interleave_mode(options.interleave_mode);
+    renderer.set_render_preset(options.render_preset);
+    renderer.set_low_res(options.low_res);
+    if (options.frame_budget_ms > 0.0) {
+        renderer.set_frame_budget_ms(options.frame_budget_ms);
+    }
+
+    // presenting is just copying the frame out, when it wasn't rendered there already
+    FramePipeline pipeline(&renderer, WIDTH, HEIGHT, options.pipeline_depth, [&pixels](const uint8_t* frame_pixels) {
+        if (frame_pixels != pixels.data()) {
+            memcpy(pixels.data(), frame_pixels, pixels.size());
+        }
+        return true;
+    }, pixels.data());
+
+    // the slowest frame shows how well the full res scheduler keeps to its budget
+    double slowest_frame_ms = 0.0;
+    // the first frames create the renderer's buffers and the pipeline's
+    //   coroutines, every one after that should be allocation free
+    uint64_t steady_allocations = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < options.frames; i++) {
+        auto frame_start = std::chrono::steady_clock::now();
+        uint64_t allocations_before = AllocationCounter::get_count();
+        pipeline.BeginFrame();
+        pipeline.Submit(camera, scene);
+        if (i > pipeline.get_depth()) {
+            steady_allocations += AllocationCounter::get_count() - allocations_before;
+        }
+        slowest_frame_ms = std::max(slowest_frame_ms, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count());
+    }
+    pipeline.Drain();
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const char* mode = " full res";
+    if (options.low_res) {
+        mode = options.interleave_mode == InterleaveMode::Off ? " low res" : " interleaved";
+    }
+
+    std::cout << "rendered " << options.frames << mode
+              << " frames in " << elapsed_ms << " ms ("
+              << elapsed_ms / std::max(1u, options.frames) << " ms/frame, slowest "
+              << slowest_frame_ms << " ms)\n";
+    if (!options.low_res) {
+        std::cout << "frame budget: " << renderer.get_frame_budget_ms() << " ms\n";
+    }
+    std::cout << "heap allocations after the first " << pipeline.get_depth() + 1 << " frames: " << steady_allocations << "\n";
+
+    if (Profiler::is_enabled()) {
+        Profiler::PrintSummary(std::cout);
+    }
+
+    if (RayStats::is_enabled()) {
+        std::cout << "=== ray stats (all frames) ===\n";
+        RayStats::Print(std::cout, RayStats::get_total());
+    }
+
+    uint64_t peak_memory = get_peak_memory_bytes();
+    if (peak_memory > 0) {
+        std::cout << "peak memory: " << peak_memory / (1024.0 * 1024.0) << " MB\n";
+    }
+
+    write_trace(options);
+    return 0;
+}
+
+// offline render of any size streamed to disk a band at a time, memory
+//   use stays the same no matter how big the image is
+static int run_offline(const Options& options) {
+    uint32_t width = options.output_width;
+    uint32_t height = options.output_height;
+
+    Camera camera = Scenes::create_default_camera((float)width / height);
+    CompiledScene scene;
+    if (!load_scene(options, &scene, &camera)) {
+        return 1;
+    }
+    camera.set_aspect_ratio((float)width / height);
+
+    Renderer renderer(width, height, LOW_RES_SCALE, options.placement);
+    renderer.set_resolve_settings(options.resolve);
+    renderer.set_render_preset(options.render_preset);
+    if (options.samples_per_pixel > 0) {
+        renderer.set_samples_per_pixel(options.samples_per_pixel);
+    }
+
+    PpmBandWriter writer;
+    std::string error;
+    if (!writer.Open(options.output_path, width, height, &error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    std::cout << "rendering " << width << "x" << height << " at " << renderer.get_samples_per_pixel()
+              << "spp to " << options.output_path << "\n";
+
+    uint32_t next_progress = 1;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = renderer.RenderBands(
+        camera,
+        scene,
+        OFFLINE_BAND_HEIGHT,
+        [&](const uint8_t* pixels, uint32_t y_start, uint32_t rows) {
+            if (!writer.WriteRows(pixels, rows, &error)) return false;
+
+            // progress in tenths, nothing per band since there can be thousands
+            uint32_t done = y_start + rows;
+            while (next_progress <= OFFLINE_PROGRESS_STEPS && (uint64_t)done * OFFLINE_PROGRESS_STEPS >= (uint64_t)next_progress * height) {
+                std::cout << "  " << next_progress * 100 / OFFLINE_PROGRESS_STEPS << "%\n";
+                next_progress++;
+            }
+            return true;
+        }
+    );
+
+    if (!ok || !writer.Close(&error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "rendered in " << elapsed_s << " s ("
+              << (double)width * height / elapsed_s / 1e6 << " Mpixels/s)\n";
+
+    uint64_t peak_memory = get_peak_memory_bytes();
+    if (peak_memory > 0) {
+        std::cout << "peak memory: " << peak_memory / (1024.0 * 1024.0) << " MB\n";
+    }
+
+    return 0;
+}
+
+// everything that changes what a pixel's samples come out as, a
+//   checkpoint only resumes a render with the same key
+static uint64_t get_checkpoint_key(const Options& options, const Camera& camera, const CompiledScene& scene) {
+    struct {
+        Vec3f position;
+        Vec3f forward;
+        float focal_length;
+        float viewport_height;
+        uint32_t sphere_count;
+        uint32_t instance_count;
+        RenderPreset render_preset;
+    } key;
+    memset((void*)&key, 0, sizeof(key));
+    key.position = camera.get_position();
+    key.forward = camera.get_forward();
+    key.focal_length = camera.get_focal_length();
+    key.viewport_height = camera.get_viewport_height();
+    key.sphere_count = scene.get_sphere_count();
+    key.instance_count = scene.get_instance_count();
+    key.render_preset = options.render_preset;
+
+    const char* scene_name = options.scene_path != nullptr ? options.scene_path : "";
+    return Hash::fnv1a(scene_name, strlen(scene_name), Hash::fnv1a(&key, sizeof(key)));
+}
+
+// offline render built up over passes of a few samples each, with the
+//   running sums checkpointed to disk so a killed render picks up where
+//   it left off and still writes the exact image an unbroken run would
+static int run_progressive(const Options& options) {
+    uint32_t width = options.output_width;
+    uint32_t height = options.output_height;
+    uint32_t samples_per_pass = options.samples_per_pixel > 0 ? options.samples_per_pixel : DEFAULT_SAMPLES_PER_PASS;
+
+    Camera camera = Scenes::create_default_camera((float)width / height);
+    CompiledScene scene;
+    if (!load_scene(options, &scene, &camera)) {
+        return 1;
+    }
+    camera.set_aspect_ratio((float)width / height);
+
+    Renderer renderer(width, height, LOW_RES_SCALE, options.placement);
+    renderer.set_resolve_settings(options.resolve);
+    renderer.set_render_preset(options.render_preset);
+    renderer.set_samples_per_pixel(samples_per_pass * options.passes);
+
+    AccumulationBuffer accumulation(width, height, renderer.get_sampler_type(), samples_per_pass, get_checkpoint_key(options, camera, scene));
+
+    std::string error;
+    if (options.checkpoint_path != nullptr) {
+        if (accumulation.ReadCheckpoint(options.checkpoint_path, &error)) {
+            std::cout << "resuming from " << options.checkpoint_path << " after pass " << accumulation.get_pass_index() << "\n";
+        } else {
+            std::cout << "starting fresh (" << error << ")\n";
+        }
+    }
+
+    std::cout << "rendering " << width << "x" << height << " in " << options.passes << " passes of "
+              << samples_per_pass << "spp to " << options.output_path << "\n";
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t first_pass = accumulation.get_pass_index();
+    while (accumulation.get_pass_index() < options.passes) {
+        renderer.RenderPass(&accumulation, camera, scene);
+
+        uint32_t pass = accumulation.get_pass_index();
+        std::cout << "  pass " << pass << "/" << options.passes << "\n";
+
+        bool last_pass = pass == options.passes;
+        if (options.checkpoint_path != nullptr && (last_pass || pass % options.checkpoint_every == 0)) {
+            if (!accumulation.WriteCheckpoint(options.checkpoint_path, &error)) {
+                std::cerr << error << "\n";
+                return 1;
+            }
+        }
+    }
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<uint8_t> pixels((size_t)width * height * 4);
+    accumulation.Resolve(options.resolve, pixels.data());
+
+    PpmBandWriter writer;
+    if (!writer.Open(options.output_path, width, height, &error) ||
+        !writer.WriteRows(pixels.data(), height, &error) ||
+        !writer.Close(&error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    std::cout << "rendered " << accumulation.get_pass_index() - first_pass << " passes in " << elapsed_s << " s\n";
+    return 0;
+}
+
+// splits one offline frame across worker processes, which can be on
+//   this machine or any other that can reach the address
+static int run_coordinator(const Options& options) {
+    if (options.output_path == nullptr) {
+        std::cerr << "--coordinator needs --output\n";
+        return 1;
+    }
+
+    uint32_t width = options.output_width;
+    uint32_t height = options.output_height;
+
+    Camera camera = Scenes::create_default_camera((float)width / height);
+    CompiledScene scene;
+    if (!load_scene(options, &scene, &camera)) {
+        return 1;
+    }
+    camera.set_aspect_ratio((float)width / height);
+
+    // workers get the scene file's text rather than its path,
+    //   so they don't need to share a filesystem
+    std::string scene_text;
+    if (options.scene_path != nullptr) {
+        std::ifstream in(options.scene_path, std::ios::binary);
+        std::stringstream text;
+        text << in.rdbuf();
+        scene_text = text.str();
+    }
+
+    Renderer renderer(width, height, LOW_RES_SCALE, options.placement);
+    renderer.set_resolve_settings(options.resolve);
+    uint32_t samples_per_pixel = options.samples_per_pixel > 0 ? options.samples_per_pixel : renderer.get_samples_per_pixel();
+
+    Distributed::FrameSettings settings = {
+        width,
+        height,
+        samples_per_pixel,
+        renderer.get_sampler_type(),
+        options.render_preset,
+        camera,
+        scene_text,
+        options.worker_timeout_s
+    };
+    AccumulationBuffer image(width, height, settings.sampler_type, samples_per_pixel, 0);
+
+    std::cout << "rendering " << width << "x" << height << " at " << samples_per_pixel << "spp to " << options.output_path
+              << ", waiting for workers on " << options.coordinator_address << "\n";
+
+    Distributed::CoordinatorReport report;
+    std::string error;
+    if (!Distributed::RunCoordinator(options.coordinator_address, settings, &image, &report, &error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    std::vector<uint8_t> pixels((size_t)width * height * 4);
+    image.Resolve(options.resolve, pixels.data());
+
+    PpmBandWriter writer;
+    if (!writer.Open(options.output_path, width, height, &error) ||
+        !writer.WriteRows(pixels.data(), height, &error) ||
+        !writer.Close(&error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    std::cout << "rendered " << report.tile_count << " tiles in " << report.seconds << " s with "
+              << report.workers_connected << " workers (" << report.workers_lost << " lost), "
+              << report.tiles_reassigned << " tiles reassigned, "
+              << report.tiles_duplicated << " duplicated for slow workers\n";
+    return 0;
+}
+
+static void update_stats_title(double delta_time) {
+    static double time_since_update = 0.0;
+    time_since_update += delta_time;
+    if (time_since_update < TITLE_UPDATE_INTERVAL) return;
+    time_since_update = 0.0;
+
+    const RayStats::FrameStats& stats = RayStats::get_last_frame();
+    char title[256];
+    snprintf(
+        title,
+        sizeof(title),
+        "%s | %.2f Mrays/s | depth %.2f | %llu sphere tests",
+        APP_NAME,
+        stats.get_rays_per_second() / 1e6,
+        stats.get_average_depth(),
+        (unsigned long long)stats.counters.sphere_tests
+    );
+    Thirteen::SetApplicationName(title);
+}
+
+static bool present() {
+    PROFILE_EVENT(Profiler::Stage::Present);
+    return Thirteen::Render();
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, &options)) {
+        return 1;
+    }
+
+    if (options.bench) {
+        return Benchmark::Run(options.bench_name);
+    }
+
+    const ThreadPlacement& placement = options.placement;
+    if (placement.policy != ThreadPlacementPolicy::Unpinned || !placement.cpus.empty() || placement.numa_node >= 0) {
+        std::vector<uint32_t> cpus;
+        std::string error;
+        if (!CpuTopology::select_cpus(placement, &cpus, &error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+
+    // the scene and framebuffers are built on this thread, so they
+    //   get first touched on the render threads' node too
+    if (placement.numa_node >= 0 && !CpuTopology::PreferNode(placement.numa_node)) {
+        std::cerr << "couldn't prefer memory from numa node " << placement.numa_node << ", continuing without\n";
+    }
+
+    if (options.worker_address != nullptr) {
+        std::string error;
+        if (!Distributed::RunWorker(options.worker_address, options.placement, &error)) {
+            std::cerr << "worker: " << error << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (options.coordinator_address != nullptr) {
+        return run_coordinator(options);
+    }
+
+    if (options.output_path != nullptr && options.passes > 0) {
+        return run_progressive(options);
+    }
+
+    if (options.output_path != nullptr) {
+        return run_offline(options);
+    }
+
+    if (options.headless) {
+        return run_headless(options);
+    }
+
+    // before opening the window so a bad scene file doesn't flash one up
+    Camera camera = Scenes::create_default_camera((float)WIDTH / HEIGHT);
+    CompiledScene scene;
+    if (!load_scene(options, &scene, &camera)) {
+        return 1;
+    }
+
     uint8_t* pixels = Thirteen::Init(WIDTH, HEIGHT);
     if (pixels == nullptr) {
         return 1;
     }
 
-    Thirteen::SetApplicationName("!! rtrt_cpu !!");
+    Thirteen::SetApplicationName(APP_NAME);
 
-    Camera camera(
-        {0, 0, -5},            // pos
-        (float)WIDTH / HEIGHT, // aspect
-        1.0f,                  // focal length
-        2.0f                   // viewport height
-    );
+    if (options.stats_title && !RayStats::is_enabled()) {
+        std::cerr << "ray stats aren't compiled in, rebuild with \"make clean && make STATS=1\"\n";
+    }
 
-    auto mat_ground = std::make_shared<Lambertian>(Vec3f(0.8f, 0.8f, 0));
-    auto mat_lamb1 = std::make_shared<Lambertian>(Vec3f(1.0f, 0.25f, 0.25f));
-    auto mat_metal1 = std::make_shared<Metal>(Vec3f(0.8f, 0.8f, 0.8f), 0.9f);
-    auto mat_metal2 = std::make_shared<Metal>(Vec3f(0.2f, 0.8f, 0.8f), 0.3f);
+    Renderer renderer(WIDTH, HEIGHT, LOW_RES_SCALE, options.placement);
+    renderer.set_resolve_settings(options.resolve);
+    renderer.set_upscale_filter(options.upscale_filter);
+    renderer.set_shading_rate_source(options.shading_rate_source);
+    renderer.set_interleave_mode(options.interleave_mode);
+    renderer.set_render_preset(options.render_preset);
+    if (options.frame_budget_ms > 0.0) {
+        renderer.set_frame_budget_ms(options.frame_budget_ms);
+    }
 
-    HittableList objects({
-        std::make_shared<Sphere>(Vec3f(0, -1001, 0), 1000.0f, mat_ground),
-        std::make_shared<Sphere>(Vec3f(0, 0, 0), 1.0f, mat_lamb1),
-        std::make_shared<Sphere>(Vec3f(-3, 0, 0), 1.0f, mat_metal1),
-        std::make_shared<Sphere>(Vec3f(3, 0, 0), 1.0f, mat_metal2),
-    });
+    std::vector<Vec3f> base_centers;
+    for (uint32_t i = 0; i < scene.get_sphere_count(); i++) {
+        base_centers.push_back(scene.get_sphere_center(i));
+    }
+    double time = 0.0;
+    uint32_t edit_index = 0;
 
-    Renderer renderer(WIDTH, HEIGHT, 0.1f);
+    // with a pipeline depth of 1 frames render right into the window's
+    //   pixels, deeper pipelines copy each frame in just before it's shown
+    //   since Thirteen only presents its own buffer
+    FramePipeline pipeline(&renderer, WIDTH, HEIGHT, options.pipeline_depth, [pixels](const uint8_t* frame_pixels) {
+        if (frame_pixels != pixels) {
+            memcpy(pixels, frame_pixels, (size_t)WIDTH * HEIGHT * 4);
+        }
+        return present();
+    }, pixels);
 
-    while (Thirteen::Render() && !Thirteen::GetKey(VK_ESCAPE)) {
+    while (pipeline.BeginFrame() && !Thirteen::GetKey(VK_ESCAPE)) {
         bool something_moved = update_camera(camera);
+        if (options.animate) {
+            time += Thirteen::GetDeltaTime();
+            animate_scene(&scene, base_centers, time, &renderer.get_thread_pool());
+            something_moved = true;
+        }
+
+        bool can_recolor = scene.get_materials().get_count() > EDIT_MATERIAL_INDEX;
+        if (can_recolor && Thirteen::GetKey('c') && !Thirteen::GetKeyLastFrame('c')) {
+            recolor_material(&scene, &renderer, ++edit_index);
+        }
+
+        if (update_resolve_settings(&renderer)) {
+            renderer.ResolveFrame(pipeline.get_target());
+        }
+
+        update_shading_rates(&renderer);
+        update_interleave_mode(&renderer);
+        update_render_preset(&renderer);
         renderer.set_low_res(something_moved);
-        renderer.RenderFrame(pixels, camera, objects);
+        pipeline.Submit(camera, scene);
+
+        if (options.stats_title && RayStats::is_enabled()) {
+            update_stats_title(Thirteen::GetDeltaTime());
+        }
     }
 
+    pipeline.Drain();
     Thirteen::Shutdown();
+    write_trace(options);
     return 0;
 }
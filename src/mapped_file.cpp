@@ -0,0 +1,89 @@
+#include "mapped_file.h"
+
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define RTRT_HAS_MMAP
+#endif
+
+MappedFile::MappedFile()
+  : data(nullptr),
+    size(0),
+    mapped(false) { }
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const char* path, std::string* out_error) {
+    Close();
+
+#ifdef RTRT_HAS_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        *out_error = std::string("couldn't open \"") + path + "\": " + strerror(errno);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        *out_error = std::string("couldn't stat \"") + path + "\": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    size = (size_t)info.st_size;
+    mapped = true;
+
+    // mmap can't map zero bytes, an empty file is just empty
+    if (size > 0) {
+        void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            *out_error = std::string("couldn't map \"") + path + "\": " + strerror(errno);
+            close(fd);
+            size = 0;
+            mapped = false;
+            return false;
+        }
+
+        data = (const uint8_t*)address;
+    }
+
+    // the mapping keeps the file alive on its own
+    close(fd);
+    return true;
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        *out_error = std::string("couldn't open \"") + path + "\"";
+        return false;
+    }
+
+    buffer.resize((size_t)file.tellg());
+    file.seekg(0);
+    file.read((char*)buffer.data(), buffer.size());
+    data = buffer.data();
+    size = buffer.size();
+    return true;
+#endif
+}
+
+void MappedFile::Close() {
+#ifdef RTRT_HAS_MMAP
+    if (mapped && data != nullptr) {
+        munmap((void*)data, size);
+    }
+#endif
+
+    buffer.clear();
+    buffer.shrink_to_fit();
+    data = nullptr;
+    size = 0;
+    mapped = false;
+}
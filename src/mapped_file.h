@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// read only view of a whole file, memory mapped where the platform
+//   supports it so pages are only read in when touched and are shared
+//   between processes, otherwise read into a buffer
+class MappedFile {
+   private:
+    const uint8_t* data;
+    size_t size;
+    std::vector<uint8_t> buffer;
+    bool mapped;
+
+   public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* path, std::string* out_error);
+    void Close();
+
+    const uint8_t* get_data() const { return data; }
+    size_t get_size() const { return size; }
+};
@@ -1,22 +1,18 @@
 #include "lambertian.h"
 
-#include "../math_utils.h"
-
 Lambertian::Lambertian(const Vec3f& albedo)
   : albedo(albedo) { }
 
 bool Lambertian::Scatter(
     const Ray& in_ray,
     const HitData& hit_data,
+    Sampler& sampler,
     Vec3f* out_attenuation,
     Ray* out_scattered
 ) const {
-    Vec3f scatter_dir = hit_data.normal + Utils::get_rand_vec3_norm();
-    if (Vec3f::near_zero(scatter_dir)) {
-        scatter_dir = hit_data.normal;
-    }
+    return lambertian_scatter(albedo, hit_data, sampler, out_attenuation, out_scattered);
+}
 
-    *out_scattered = Ray(hit_data.point, scatter_dir);
-    *out_attenuation = albedo;
-    return true;
+MaterialRecord Lambertian::get_record() const {
+    return {albedo, 0.0f, MaterialType::Lambertian};
 }
@@ -1,6 +1,31 @@
 #pragma once
 
 #include "material.h"
+#include "../sampling.h"
+#include "../ray_stats.h"
+
+// shared by Lambertian::Scatter and MaterialTable so both dispatch
+//   paths shade identically, inline so the table path can fold it
+//   straight into the integrator
+inline bool lambertian_scatter(
+    const Vec3f& albedo,
+    const HitData& hit_data,
+    Sampler& sampler,
+    Vec3f* out_attenuation,
+    Ray* out_scattered
+) {
+    // importance sample the cosine term directly, the pdf
+    //   cancels out with the lambertian brdf leaving the albedo
+    Vec3f tangent, bitangent;
+    Sampling::build_basis(hit_data.normal, &tangent, &bitangent);
+    Vec3f local_dir = Sampling::sample_cosine_hemisphere(sampler.Get2D());
+    Vec3f scatter_dir = Sampling::to_world(local_dir, tangent, bitangent, hit_data.normal);
+
+    *out_scattered = Ray(hit_data.point, scatter_dir);
+    *out_attenuation = albedo;
+    STATS_SCATTER(RayStats::MaterialKind::Lambertian, true);
+    return true;
+}
 
 class Lambertian : public Material {
    private:
@@ -12,7 +37,10 @@ class Lambertian : public Material {
     bool Scatter(
         const Ray& in_ray,
         const HitData& hit_data,
+        Sampler& sampler,
         Vec3f* out_attenuation,
         Ray* out_scattered
     ) const override;
+
+    MaterialRecord get_record() const override;
 };
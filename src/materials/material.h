@@ -2,6 +2,21 @@
 
 #include "../ray.h"
 #include "../objects/hittable.h"
+#include "../samplers/sampler.h"
+
+enum class MaterialType : uint32_t {
+    Absorb,
+    Lambertian,
+    Metal
+};
+
+// flat, trivially copyable description of a material, this is what
+//   the renderer actually shades with (see MaterialTable)
+struct MaterialRecord {
+    Vec3f albedo;
+    float fuzz;
+    MaterialType type;
+};
 
 class Material {
    public:
@@ -10,7 +25,10 @@ class Material {
     virtual bool Scatter(
         const Ray& in_ray,
         const HitData& hit_data,
+        Sampler& sampler,
         Vec3f* out_attenuation,
         Ray* out_scattered
     ) const { return false; }
+
+    virtual MaterialRecord get_record() const { return {Vec3f(0.0f), 0.0f, MaterialType::Absorb}; }
 };
@@ -0,0 +1,17 @@
+#include "material_table.h"
+
+uint32_t MaterialTable::Add(const std::shared_ptr<Material>& material) {
+    auto it = indices.find(material.get());
+    if (it != indices.end()) {
+        return it->second;
+    }
+
+    uint32_t index = Add(material->get_record());
+    indices[material.get()] = index;
+    return index;
+}
+
+uint32_t MaterialTable::Add(const MaterialRecord& record) {
+    records.push_back(record);
+    return (uint32_t)records.size() - 1;
+}
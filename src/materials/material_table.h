@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "material.h"
+#include "lambertian.h"
+#include "metal.h"
+
+// every material of a scene packed into one contiguous array of POD
+//   records, shading switches on the record's type instead of going
+//   through a virtual call so both material paths can be inlined
+class MaterialTable {
+   private:
+    std::vector<MaterialRecord> records;
+    std::unordered_map<const Material*, uint32_t> indices;
+
+   public:
+    MaterialTable() = default;
+
+    // returns the index of the material, adding it only once
+    //   no matter how many objects share it
+    uint32_t Add(const std::shared_ptr<Material>& material);
+    uint32_t Add(const MaterialRecord& record);
+    void Set(uint32_t index, const MaterialRecord& record) { records[index] = record; }
+
+    bool Scatter(
+        uint32_t index,
+        const Ray& in_ray,
+        const HitData& hit_data,
+        Sampler& sampler,
+        Vec3f* out_attenuation,
+        Ray* out_scattered
+    ) const {
+        const MaterialRecord& record = records[index];
+        switch (record.type) {
+            case MaterialType::Lambertian:
+                return lambertian_scatter(record.albedo, hit_data, sampler, out_attenuation, out_scattered);
+            case MaterialType::Metal:
+                return metal_scatter(record.albedo, record.fuzz, in_ray, hit_data, sampler, out_attenuation, out_scattered);
+            case MaterialType::Absorb: break;
+        }
+
+        return false;
+    }
+
+    const MaterialRecord& get_record(uint32_t index) const { return records[index]; }
+    uint32_t get_count() const { return (uint32_t)records.size(); }
+};
@@ -1,6 +1,47 @@
 #pragma once
 
+#include <algorithm>
 #include "material.h"
+#include "../sampling.h"
+#include "../ray_stats.h"
+
+// below this the GGX lobe is numerically a mirror anyway
+constexpr float METAL_MIN_ALPHA = 1e-4f;
+
+// shared by Metal::Scatter and MaterialTable, see lambertian_scatter
+inline bool metal_scatter(
+    const Vec3f& albedo,
+    float fuzz,
+    const Ray& in_ray,
+    const HitData& hit_data,
+    Sampler& sampler,
+    Vec3f* out_attenuation,
+    Ray* out_scattered
+) {
+    // fuzz is used directly as the GGX roughness, microfacet normals are
+    //   sampled from the visible normal distribution so almost no
+    //   samples are wasted on back-facing microfacets
+    float alpha = std::max(fuzz, METAL_MIN_ALPHA);
+
+    Vec3f tangent, bitangent;
+    Sampling::build_basis(hit_data.normal, &tangent, &bitangent);
+
+    Vec3f view = -in_ray.get_unit_direction();
+    Vec3f view_local = Sampling::to_local(view, tangent, bitangent, hit_data.normal);
+    view_local.z = std::max(view_local.z, 1e-6f);
+
+    Vec3f micro_normal = Sampling::sample_ggx_vndf(view_local, alpha, sampler.Get2D());
+    Vec3f refl_local = Vec3f::reflect(-view_local, micro_normal);
+
+    // with VNDF sampling the weight reduces to F * G1(out), metals
+    //   just use their albedo as the fresnel term
+    *out_scattered = Ray(hit_data.point, Sampling::to_world(refl_local, tangent, bitangent, hit_data.normal));
+    *out_attenuation = albedo * Sampling::ggx_smith_g1(refl_local, alpha);
+
+    bool accepted = refl_local.z > 0.0f;
+    STATS_SCATTER(RayStats::MaterialKind::Metal, accepted);
+    return accepted;
+}
 
 class Metal : public Material {
    private:
@@ -13,7 +54,10 @@ class Metal : public Material {
     bool Scatter(
         const Ray& in_ray,
         const HitData& hit_data,
+        Sampler& sampler,
         Vec3f* out_attenuation,
         Ray* out_scattered
     ) const override;
+
+    MaterialRecord get_record() const override;
 };
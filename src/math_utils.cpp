@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <float.h>
+#include "sampling.h"
 
 constexpr uint32_t RAND_SEED = 829734215;
 
@@ -37,13 +38,9 @@ Vec3f Utils::get_rand_vec3(float min, float max) {
 }
 
 Vec3f Utils::get_rand_vec3_norm() {
-    while (true) {
-        Vec3f p = get_rand_vec3(-1, 1);
-        float len_sq = Vec3f::length_sq(p);
-        if (len_sq >= FLT_EPSILON && len_sq <= 1.0f) {
-            return p / std::sqrtf(len_sq);
-        }
-    }
+    // closed-form mapping rather than rejection sampling, always
+    //   exactly two random numbers and no data-dependent loop
+    return Sampling::sample_uniform_sphere({randf_range(0, 1), randf_range(0, 1)});
 }
 
 Vec3f Utils::get_rand_vec3_on_hemisphere(const Vec3f& normal) {
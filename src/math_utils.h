@@ -1,8 +1,11 @@
 #pragma once
 
 #include "vec3.h"
+#include <numbers>
 
 namespace Utils {
+    constexpr float PI = std::numbers::pi_v<float>;
+
     Vec3f lerp(Vec3f a, Vec3f b, float x);
     float lerp(float a, float b, float x);
     float randf_range(float min, float max);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include "../vec3.h"
+#include "../interval.h"
+#include "../ray.h"
+
+struct Aabb {
+    Vec3f min;
+    Vec3f max;
+
+    // empty, expanding it by anything gives that thing's bounds
+    Aabb() : min(INFINITY_F), max(-INFINITY_F) { }
+    Aabb(const Vec3f& min, const Vec3f& max) : min(min), max(max) { }
+
+    void Expand(const Vec3f& p) {
+        min = Vec3f::min(min, p);
+        max = Vec3f::max(max, p);
+    }
+
+    void Expand(const Aabb& other) {
+        min = Vec3f::min(min, other.min);
+        max = Vec3f::max(max, other.max);
+    }
+
+    Vec3f get_center() const { return (min + max) * 0.5f; }
+
+    float get_surface_area() const {
+        Vec3f e = max - min;
+        if (e.x < 0.0f || e.y < 0.0f || e.z < 0.0f) return 0.0f;
+        return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+};
+
+// slab test, returns the entry distance or infinity on a miss. the
+//   ray's sign bits pick each axis' near and far plane so they don't
+//   need sorting. a ray starting exactly on an axis aligned plane gives
+//   a NaN for that axis, std::max/min keep their first argument then so
+//   the axis is skipped. (std::fmax/fmin do the same but aren't inlined
+//   without -ffast-math, which made them most of the cost)
+inline float aabb_hit_distance(const Aabb& box, const Ray& ray, float t_min, float t_max) {
+    const Vec3f& origin = ray.get_origin();
+    const Vec3f& inv_dir = ray.get_inv_direction();
+    uint8_t sign = ray.get_sign_mask();
+
+    float tx_near = (((sign & 1) ? box.max.x : box.min.x) - origin.x) * inv_dir.x;
+    float tx_far = (((sign & 1) ? box.min.x : box.max.x) - origin.x) * inv_dir.x;
+    float ty_near = (((sign & 2) ? box.max.y : box.min.y) - origin.y) * inv_dir.y;
+    float ty_far = (((sign & 2) ? box.min.y : box.max.y) - origin.y) * inv_dir.y;
+    float tz_near = (((sign & 4) ? box.max.z : box.min.z) - origin.z) * inv_dir.z;
+    float tz_far = (((sign & 4) ? box.min.z : box.max.z) - origin.z) * inv_dir.z;
+
+    float t_enter = std::max(std::max(std::max(t_min, tx_near), ty_near), tz_near);
+    float t_exit = std::min(std::min(std::min(t_max, tx_far), ty_far), tz_far);
+
+    return t_enter <= t_exit ? t_enter : INFINITY_F;
+}
@@ -0,0 +1,176 @@
+#include "blas.h"
+
+#include <cmath>
+#include <algorithm>
+#include "hittable_list.h"
+#include "../ray_stats.h"
+
+Blas::Blas(const std::vector<SceneBuilder::SpherePrimitive>& spheres, const std::vector<std::shared_ptr<Material>>& materials)
+  : materials(materials) {
+    Rebuild(spheres);
+}
+
+void Blas::Rebuild(const std::vector<SceneBuilder::SpherePrimitive>& spheres) {
+    std::vector<Aabb> bounds;
+    bounds.reserve(spheres.size());
+    for (const auto& s : spheres) {
+        bounds.emplace_back(s.center - Vec3f(s.radius), s.center + Vec3f(s.radius));
+    }
+
+    bvh.Build(bounds);
+
+    sphere_x.clear();
+    sphere_y.clear();
+    sphere_z.clear();
+    sphere_radius_sq.clear();
+    sphere_inv_radius.clear();
+    sphere_material.clear();
+    sphere_slots.resize(spheres.size());
+
+    sphere_x.reserve(spheres.size());
+    sphere_y.reserve(spheres.size());
+    sphere_z.reserve(spheres.size());
+    sphere_radius_sq.reserve(spheres.size());
+    sphere_inv_radius.reserve(spheres.size());
+    sphere_material.reserve(spheres.size());
+
+    for (uint32_t prim : bvh.get_prim_indices()) {
+        const auto& s = spheres[prim];
+        sphere_slots[prim] = (uint32_t)sphere_x.size();
+        sphere_x.push_back(s.center.x);
+        sphere_y.push_back(s.center.y);
+        sphere_z.push_back(s.center.z);
+        sphere_radius_sq.push_back(s.radius * s.radius);
+        sphere_inv_radius.push_back(s.radius > 0.0f ? 1.0f / s.radius : 0.0f);
+        sphere_material.push_back(s.material_index);
+    }
+
+    dirty = false;
+}
+
+std::vector<SceneBuilder::SpherePrimitive> Blas::GetSpheres() const {
+    std::vector<SceneBuilder::SpherePrimitive> spheres(sphere_slots.size());
+    for (uint32_t i = 0; i < spheres.size(); i++) {
+        uint32_t slot = sphere_slots[i];
+        float radius = std::sqrt(sphere_radius_sq[slot]);
+        spheres[i] = {Vec3f(sphere_x[slot], sphere_y[slot], sphere_z[slot]), radius, sphere_material[slot]};
+    }
+
+    return spheres;
+}
+
+std::vector<Aabb> Blas::GetAllSphereBounds() const {
+    std::vector<Aabb> bounds(sphere_slots.size());
+    for (uint32_t i = 0; i < bounds.size(); i++) {
+        bounds[i] = GetSphereBounds(i);
+    }
+
+    return bounds;
+}
+
+void Blas::SetSphereCenter(uint32_t index, const Vec3f& center) {
+    uint32_t slot = sphere_slots[index];
+    sphere_x[slot] = center.x;
+    sphere_y[slot] = center.y;
+    sphere_z[slot] = center.z;
+    dirty = true;
+}
+
+Vec3f Blas::get_sphere_center(uint32_t index) const {
+    uint32_t slot = sphere_slots[index];
+    return Vec3f(sphere_x[slot], sphere_y[slot], sphere_z[slot]);
+}
+
+Aabb Blas::GetSphereBounds(uint32_t index) const {
+    uint32_t slot = sphere_slots[index];
+    Vec3f center(sphere_x[slot], sphere_y[slot], sphere_z[slot]);
+    Vec3f radius(std::sqrt(sphere_radius_sq[slot]));
+    return Aabb(center - radius, center + radius);
+}
+
+BvhUpdate Blas::Update(float rebuild_threshold, ThreadPool* pool) {
+    if (!dirty) return BvhUpdate::Unchanged;
+
+    if (rebuild_threshold <= 1.0f) {
+        Rebuild(GetSpheres());
+        return BvhUpdate::Rebuild;
+    }
+
+    // the bvh's prim indices are authoring indices, which is the
+    //   order the bounds come back in
+    bvh.Refit(GetAllSphereBounds(), pool);
+    dirty = false;
+
+    if (bvh.GetQualityRatio() > rebuild_threshold) {
+        Rebuild(GetSpheres());
+        return BvhUpdate::Rebuild;
+    }
+
+    return BvhUpdate::Refit;
+}
+
+std::shared_ptr<Blas> Blas::Build(const HittableList& asset) {
+    SceneBuilder builder;
+    asset.Compile(&builder);
+    return std::make_shared<Blas>(builder.spheres, builder.materials);
+}
+
+template <bool UNIT>
+bool Blas::HitSpheres(const Ray& ray, float t_min, float* t_closest, uint32_t* out_sphere) const {
+    const Vec3f& origin = ray.get_origin();
+    const Vec3f& dir = ray.get_direction();
+    float a = UNIT ? 1.0f : ray.get_length_sq();
+    float inv_a = UNIT ? 1.0f : 1.0f / a;
+    int32_t closest_index = -1;
+
+    bvh.Traverse(ray, t_min, t_closest, [&](uint32_t first, uint32_t count) {
+        STATS_ADD(sphere_tests, count);
+
+        // branch free so every sphere costs the same and the
+        //   compiler is free to keep everything in registers
+        for (uint32_t i = first; i < first + count; i++) {
+            float oc_x = sphere_x[i] - origin.x;
+            float oc_y = sphere_y[i] - origin.y;
+            float oc_z = sphere_z[i] - origin.z;
+
+            float h = dir.x * oc_x + dir.y * oc_y + dir.z * oc_z;
+            float c = oc_x * oc_x + oc_y * oc_y + oc_z * oc_z - sphere_radius_sq[i];
+            float discriminant = UNIT ? h * h - c : h * h - a * c;
+            float sqrt_d = std::sqrt(std::max(discriminant, 0.0f));
+
+            // nearest root in range, otherwise the far one
+            float root = UNIT ? h - sqrt_d : (h - sqrt_d) * inv_a;
+            root = root > t_min ? root : (UNIT ? h + sqrt_d : (h + sqrt_d) * inv_a);
+
+            bool closer = discriminant >= 0.0f && root > t_min && root < *t_closest;
+            *t_closest = closer ? root : *t_closest;
+            closest_index = closer ? (int32_t)i : closest_index;
+        }
+    });
+
+    if (closest_index < 0) {
+        return false;
+    }
+
+    *out_sphere = (uint32_t)closest_index;
+    return true;
+}
+
+bool Blas::Hit(const Ray& ray, float t_min, float* t_closest, uint32_t* out_sphere) const {
+    if (ray.is_unit()) {
+        return HitSpheres<true>(ray, t_min, t_closest, out_sphere);
+    }
+
+    return HitSpheres<false>(ray, t_min, t_closest, out_sphere);
+}
+
+void Blas::GetHitData(uint32_t sphere, const Ray& ray, float t, HitData* out_hit) const {
+    out_hit->t = t;
+    out_hit->point = ray.get_at(t);
+    out_hit->material = materials[sphere_material[sphere]].get();
+    out_hit->material_index = sphere_material[sphere];
+    out_hit->object_id = bvh.get_prim_indices()[sphere];
+    Vec3f center(sphere_x[sphere], sphere_y[sphere], sphere_z[sphere]);
+    Vec3f outward_normal = (out_hit->point - center) * sphere_inv_radius[sphere];
+    hit_data_set_face_normal(out_hit, ray, outward_normal);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "hittable.h"
+#include "bvh.h"
+#include "scene_builder.h"
+#include "../aligned_allocator.h"
+
+class HittableList;
+
+// bottom level acceleration structure: spheres in their own object
+//   space plus a BVH over them. a single Blas is shared by any
+//   number of Instances, each only adding a transform
+class Blas {
+   private:
+    // structure of arrays, reordered to BVH leaf order so
+    //   leaves address a contiguous range directly
+    AlignedVector<float> sphere_x;
+    AlignedVector<float> sphere_y;
+    AlignedVector<float> sphere_z;
+    AlignedVector<float> sphere_radius_sq;
+    AlignedVector<float> sphere_inv_radius;
+    AlignedVector<uint32_t> sphere_material;
+    // authoring index -> position in the arrays above
+    std::vector<uint32_t> sphere_slots;
+    Bvh bvh;
+    std::vector<std::shared_ptr<Material>> materials;
+    bool dirty = false;
+
+    void Rebuild(const std::vector<SceneBuilder::SpherePrimitive>& spheres);
+    std::vector<SceneBuilder::SpherePrimitive> GetSpheres() const;
+    std::vector<Aabb> GetAllSphereBounds() const;
+
+    // Hit's traversal, unit rays skip the quadratic's a term entirely
+    template <bool UNIT>
+    bool HitSpheres(const Ray& ray, float t_min, float* t_closest, uint32_t* out_sphere) const;
+
+   public:
+    Blas(const std::vector<SceneBuilder::SpherePrimitive>& spheres, const std::vector<std::shared_ptr<Material>>& materials);
+
+    // builds from an asset's object graph, instances inside
+    //   the asset aren't supported and are ignored
+    static std::shared_ptr<Blas> Build(const HittableList& asset);
+
+    // closest sphere hit in (t_min, *t_closest), lowers
+    //   *t_closest and writes the sphere index on a hit
+    bool Hit(const Ray& ray, float t_min, float* t_closest, uint32_t* out_sphere) const;
+
+    // fills in hit data in this Blas' space, material_index is
+    //   an index into get_materials() and object_id is the index
+    //   the sphere was added with
+    void GetHitData(uint32_t sphere, const Ray& ray, float t, HitData* out_hit) const;
+
+    // moves a sphere by the index it was added with, the BVH is stale
+    //   until Update is called so don't move spheres mid frame
+    void SetSphereCenter(uint32_t index, const Vec3f& center);
+    Vec3f get_sphere_center(uint32_t index) const;
+    Aabb GetSphereBounds(uint32_t index) const;
+
+    // brings the BVH up to date after spheres moved: refits, then rebuilds
+    //   from scratch if the SAH cost grew past rebuild_threshold times the
+    //   cost at the last build. a threshold of 1 or less always rebuilds
+    //   and an infinite one never does
+    BvhUpdate Update(float rebuild_threshold, ThreadPool* pool = nullptr);
+
+    float GetQualityRatio() const { return bvh.GetQualityRatio(); }
+
+    Aabb get_bounds() const { return bvh.get_bounds(); }
+    uint32_t get_sphere_count() const { return (uint32_t)sphere_x.size(); }
+    const std::vector<std::shared_ptr<Material>>& get_materials() const { return materials; }
+};
@@ -0,0 +1,203 @@
+#include "bvh.h"
+
+#include <numeric>
+#include <algorithm>
+#include "../thread_pool.h"
+
+constexpr uint32_t BIN_COUNT = 12;
+constexpr uint32_t MAX_LEAF_SIZE = 4;
+// leaves bigger than this are always split even if SAH says not to
+constexpr uint32_t FORCE_SPLIT_SIZE = 16;
+// past this depth nodes are split at the centroid median instead of by
+//   SAH, halving every level so BVH_MAX_DEPTH holds for any input SAH
+//   keeps peeling one primitive off of (long thin chains, duplicates)
+constexpr uint32_t MEDIAN_SPLIT_DEPTH = BVH_MAX_DEPTH - 16;
+// below this many nodes the pool overhead outweighs a parallel refit
+constexpr uint32_t PARALLEL_REFIT_MIN_NODES = 1 << 12;
+constexpr float SAH_TRAVERSAL_COST = 1.0f;
+constexpr float SAH_INTERSECTION_COST = 1.0f;
+
+struct Bin {
+    Aabb bounds;
+    uint32_t count = 0;
+};
+
+void Bvh::Build(const std::vector<Aabb>& prim_bounds) {
+    uint32_t prim_count = (uint32_t)prim_bounds.size();
+
+    nodes.clear();
+    prim_indices.resize(prim_count);
+    std::iota(prim_indices.begin(), prim_indices.end(), 0);
+
+    build_areas.clear();
+    if (prim_count == 0) return;
+
+    std::vector<Vec3f> centroids(prim_count);
+    for (uint32_t i = 0; i < prim_count; i++) {
+        centroids[i] = prim_bounds[i].get_center();
+    }
+
+    // a binary tree with n leaves has at most 2n - 1 nodes, reserving
+    //   up front keeps node references valid while subdividing
+    nodes.reserve(prim_count * 2);
+    nodes.push_back({Aabb(), 0, prim_count});
+    Subdivide(0, 0, prim_bounds, centroids);
+
+    build_areas.reserve(nodes.size());
+    for (const BvhNode& node : nodes) {
+        build_areas.push_back(node.bounds.get_surface_area());
+    }
+}
+
+void Bvh::Refit(const std::vector<Aabb>& prim_bounds, ThreadPool* pool) {
+    uint32_t node_count = (uint32_t)nodes.size();
+
+    auto refit_leaves = [this, &prim_bounds](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            BvhNode& node = nodes[i];
+            if (node.count == 0) continue;
+
+            node.bounds = Aabb();
+            for (uint32_t j = node.first; j < node.first + node.count; j++) {
+                node.bounds.Expand(prim_bounds[prim_indices[j]]);
+            }
+        }
+    };
+
+    if (pool != nullptr && node_count >= PARALLEL_REFIT_MIN_NODES) {
+        uint32_t grain = GrainSize::get_balanced(node_count, pool->get_thread_count());
+        pool->ParallelFor(0, node_count, grain, [&refit_leaves](uint32_t begin, uint32_t end, uint32_t) { refit_leaves(begin, end); });
+    } else {
+        refit_leaves(0, node_count);
+    }
+
+    // children are always created after their parent, so walking the
+    //   array backwards sees both children before the node itself
+    for (uint32_t i = node_count; i-- > 0;) {
+        BvhNode& node = nodes[i];
+        if (node.count > 0) continue;
+
+        node.bounds = nodes[node.first].bounds;
+        node.bounds.Expand(nodes[node.first + 1].bounds);
+    }
+}
+
+float Bvh::GetQualityRatio() const {
+    float cost = 0.0f;
+    float build_cost = 0.0f;
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        if (build_areas[i] <= 0.0f) continue;
+
+        const BvhNode& node = nodes[i];
+        float node_cost = node.count > 0 ? node.count * SAH_INTERSECTION_COST : SAH_TRAVERSAL_COST;
+        cost += node_cost * node.bounds.get_surface_area() / build_areas[i];
+        build_cost += node_cost;
+    }
+
+    return build_cost > 0.0f ? cost / build_cost : 1.0f;
+}
+
+void Bvh::Subdivide(uint32_t node_index, uint32_t depth, const std::vector<Aabb>& prim_bounds, const std::vector<Vec3f>& centroids) {
+    BvhNode& node = nodes[node_index];
+
+    Aabb centroid_bounds;
+    node.bounds = Aabb();
+    for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        node.bounds.Expand(prim_bounds[prim_indices[i]]);
+        centroid_bounds.Expand(centroids[prim_indices[i]]);
+    }
+
+    if (node.count <= MAX_LEAF_SIZE || depth == BVH_MAX_DEPTH) return;
+
+    uint32_t* begin = prim_indices.data() + node.first;
+    uint32_t* end = begin + node.count;
+    uint32_t* middle;
+
+    if (depth >= MEDIAN_SPLIT_DEPTH) {
+        uint32_t axis = 0;
+        Vec3f extent = centroid_bounds.max - centroid_bounds.min;
+        if (extent[1] > extent[axis]) axis = 1;
+        if (extent[2] > extent[axis]) axis = 2;
+
+        middle = begin + node.count / 2;
+        std::nth_element(begin, middle, end, [&](uint32_t a, uint32_t b) {
+            return centroids[a][axis] < centroids[b][axis];
+        });
+        SplitNode(node_index, (uint32_t)(middle - begin), depth, prim_bounds, centroids);
+        return;
+    }
+
+    // find the cheapest bin boundary over all three axes
+    float best_cost = INFINITY_F;
+    uint32_t best_axis = 0;
+    uint32_t best_split = 0;
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        float axis_min = centroid_bounds.min[axis];
+        float axis_extent = centroid_bounds.max[axis] - axis_min;
+        if (axis_extent <= 0.0f) continue;
+
+        Bin bins[BIN_COUNT];
+        float bin_scale = BIN_COUNT / axis_extent;
+        for (uint32_t i = node.first; i < node.first + node.count; i++) {
+            uint32_t prim = prim_indices[i];
+            uint32_t b = std::min(BIN_COUNT - 1, (uint32_t)((centroids[prim][axis] - axis_min) * bin_scale));
+            bins[b].count++;
+            bins[b].bounds.Expand(prim_bounds[prim]);
+        }
+
+        // sweep from both sides so every split is evaluated in O(bins)
+        float left_area[BIN_COUNT - 1];
+        uint32_t left_count[BIN_COUNT - 1];
+        Aabb left_box;
+        uint32_t left_sum = 0;
+        for (uint32_t i = 0; i < BIN_COUNT - 1; i++) {
+            left_sum += bins[i].count;
+            left_box.Expand(bins[i].bounds);
+            left_count[i] = left_sum;
+            left_area[i] = left_box.get_surface_area();
+        }
+
+        Aabb right_box;
+        uint32_t right_sum = 0;
+        for (uint32_t i = BIN_COUNT - 1; i > 0; i--) {
+            right_sum += bins[i].count;
+            right_box.Expand(bins[i].bounds);
+            float cost = left_count[i - 1] * left_area[i - 1] + right_sum * right_box.get_surface_area();
+            if (left_count[i - 1] > 0 && right_sum > 0 && cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = i;
+            }
+        }
+    }
+
+    float leaf_cost = node.count * node.bounds.get_surface_area();
+    if (best_cost >= leaf_cost && node.count <= FORCE_SPLIT_SIZE) return;
+
+    if (best_cost == INFINITY_F) {
+        // every centroid is in the same spot, just halve the range
+        middle = begin + node.count / 2;
+    } else {
+        float axis_min = centroid_bounds.min[best_axis];
+        float bin_scale = BIN_COUNT / (centroid_bounds.max[best_axis] - axis_min);
+        middle = std::partition(begin, end, [&](uint32_t prim) {
+            uint32_t b = std::min(BIN_COUNT - 1, (uint32_t)((centroids[prim][best_axis] - axis_min) * bin_scale));
+            return b < best_split;
+        });
+    }
+
+    SplitNode(node_index, (uint32_t)(middle - begin), depth, prim_bounds, centroids);
+}
+
+void Bvh::SplitNode(uint32_t node_index, uint32_t left_count, uint32_t depth, const std::vector<Aabb>& prim_bounds, const std::vector<Vec3f>& centroids) {
+    BvhNode& node = nodes[node_index];
+    uint32_t left_index = (uint32_t)nodes.size();
+    nodes.push_back({Aabb(), node.first, left_count});
+    nodes.push_back({Aabb(), node.first + left_count, node.count - left_count});
+
+    node.first = left_index;
+    node.count = 0;
+
+    Subdivide(left_index, depth + 1, prim_bounds, centroids);
+    Subdivide(left_index + 1, depth + 1, prim_bounds, centroids);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vector>
+#include <cassert>
+#include <stdint.h>
+#include "aabb.h"
+#include "../aligned_allocator.h"
+
+class ThreadPool;
+
+// deepest a leaf can be, Build guarantees it so Traverse can
+//   keep its stack of far children on the C++ stack
+constexpr uint32_t BVH_MAX_DEPTH = 64;
+
+// what an update did to a hierarchy, see Blas::Update
+enum class BvhUpdate : uint32_t {
+    Unchanged,
+    Refit,
+    Rebuild
+};
+
+// 32 bytes so two siblings share a cache line, children are always
+//   stored next to each other so one index is enough
+struct BvhNode {
+    Aabb bounds;
+    // first child for interior nodes, first primitive for leaves
+    uint32_t first;
+    // zero for interior nodes
+    uint32_t count;
+};
+
+// bounding volume hierarchy over anything that has bounds, built with
+//   binned SAH. it only stores primitive indices, the owner reorders
+//   its own primitive data with get_prim_indices() so that leaves
+//   address it directly
+class Bvh {
+   private:
+    AlignedVector<BvhNode> nodes;
+    std::vector<uint32_t> prim_indices;
+    // every node's surface area right after the last build
+    std::vector<float> build_areas;
+
+    void Subdivide(uint32_t node_index, uint32_t depth, const std::vector<Aabb>& prim_bounds, const std::vector<Vec3f>& centroids);
+    // turns a leaf into an interior node over its first left_count
+    //   primitives and the rest, then subdivides both
+    void SplitNode(uint32_t node_index, uint32_t left_count, uint32_t depth, const std::vector<Aabb>& prim_bounds, const std::vector<Vec3f>& centroids);
+
+   public:
+    Bvh() = default;
+
+    void Build(const std::vector<Aabb>& prim_bounds);
+
+    // recomputes every node's bounds bottom up for primitives that moved,
+    //   keeping the topology. O(n) against O(n log n) for a rebuild but
+    //   the tree gets worse the further things move from where they were
+    //   built. leaves are refit in parallel on big trees when a pool is given
+    void Refit(const std::vector<Aabb>& prim_bounds, ThreadPool* pool = nullptr);
+
+    // how much more a ray is expected to cost than right after the last
+    //   build, 1.0 for a fresh tree. this is the SAH with every node's hit
+    //   probability taken relative to its own area at build time instead
+    //   of the root's, otherwise one huge primitive (the ground sphere)
+    //   keeps the root so big that no amount of refitting shows up
+    float GetQualityRatio() const;
+
+    const std::vector<uint32_t>& get_prim_indices() const { return prim_indices; }
+    uint32_t get_node_count() const { return (uint32_t)nodes.size(); }
+    Aabb get_bounds() const { return nodes.empty() ? Aabb() : nodes[0].bounds; }
+
+    // visits every leaf the ray can reach nearest first, visit_leaf is
+    //   called with (first, count) and may lower *t_closest so that
+    //   farther nodes get culled
+    template <typename F>
+    void Traverse(const Ray& ray, float t_min, float* t_closest, F&& visit_leaf) const {
+        if (nodes.empty()) return;
+        if (aabb_hit_distance(nodes[0].bounds, ray, t_min, *t_closest) == INFINITY_F) return;
+
+        // at most one far child per ancestor of the current node
+        uint32_t stack[BVH_MAX_DEPTH];
+        float stack_dist[BVH_MAX_DEPTH];
+        uint32_t stack_size = 0;
+        uint32_t node_index = 0;
+
+        while (true) {
+            const BvhNode& node = nodes[node_index];
+
+            if (node.count > 0) {
+                visit_leaf(node.first, node.count);
+            } else {
+                uint32_t near = node.first;
+                uint32_t far = node.first + 1;
+                float near_dist = aabb_hit_distance(nodes[near].bounds, ray, t_min, *t_closest);
+                float far_dist = aabb_hit_distance(nodes[far].bounds, ray, t_min, *t_closest);
+
+                if (far_dist < near_dist) {
+                    std::swap(near, far);
+                    std::swap(near_dist, far_dist);
+                }
+
+                if (near_dist != INFINITY_F) {
+                    if (far_dist != INFINITY_F) {
+                        assert(stack_size < BVH_MAX_DEPTH);
+                        stack[stack_size] = far;
+                        stack_dist[stack_size] = far_dist;
+                        stack_size++;
+                    }
+
+                    node_index = near;
+                    continue;
+                }
+            }
+
+            // pop, skipping anything that's now behind the closest hit
+            bool found = false;
+            while (stack_size > 0) {
+                stack_size--;
+                if (stack_dist[stack_size] < *t_closest) {
+                    node_index = stack[stack_size];
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found) break;
+        }
+    }
+};
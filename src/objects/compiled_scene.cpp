@@ -0,0 +1,141 @@
+#include "compiled_scene.h"
+
+#include <unordered_map>
+#include "hittable_list.h"
+#include "instance.h"
+
+// rebuild once a refit hierarchy is expected to cost this much
+//   more per ray than it did when it was built
+constexpr float DEFAULT_REBUILD_THRESHOLD = 1.5f;
+
+CompiledScene::CompiledScene()
+  : world(std::make_shared<Blas>(std::vector<SceneBuilder::SpherePrimitive>(), std::vector<std::shared_ptr<Material>>())),
+    tlas_dirty(false),
+    rebuild_threshold(DEFAULT_REBUILD_THRESHOLD) { }
+
+CompiledScene CompiledScene::Compile(const HittableList& objects) {
+    SceneBuilder builder;
+    objects.Compile(&builder);
+    return Compile(builder);
+}
+
+CompiledScene CompiledScene::Compile(SceneBuilder& builder) {
+    CompiledScene scene;
+    scene.world = std::make_shared<Blas>(builder.spheres, builder.materials);
+
+    // every Blas is only added once no matter how many instances
+    //   share it, its materials join the scene's materials
+    std::unordered_map<const Blas*, uint32_t> blas_indices;
+    for (const auto& instance : builder.instances) {
+        auto it = blas_indices.find(instance.blas.get());
+        uint32_t blas_index;
+        if (it != blas_indices.end()) {
+            blas_index = it->second;
+        } else {
+            BlasEntry entry;
+            entry.blas = instance.blas;
+            for (const auto& material : instance.blas->get_materials()) {
+                entry.material_remap.push_back(builder.AddMaterial(material));
+            }
+
+            blas_index = (uint32_t)scene.blases.size();
+            blas_indices[instance.blas.get()] = blas_index;
+            scene.blases.push_back(std::move(entry));
+        }
+
+        scene.instances.push_back({instance.transform.get_inverse(), instance.transform, blas_index});
+        scene.instance_bounds.push_back(instance.transform.apply_bounds(instance.blas->get_bounds()));
+    }
+
+    // builder materials are already unique so table indices
+    //   line up with builder indices
+    for (const auto& material : builder.materials) {
+        scene.materials.Add(material);
+    }
+
+    scene.tlas.Build(scene.instance_bounds);
+    return scene;
+}
+
+void CompiledScene::SetSphereCenter(uint32_t index, const Vec3f& center) {
+    world->SetSphereCenter(index, center);
+}
+
+void CompiledScene::SetInstanceTransform(uint32_t index, const Transform& transform) {
+    InstanceRecord& instance = instances[index];
+    instance.object_to_world = transform;
+    instance.world_to_object = transform.get_inverse();
+    instance_bounds[index] = transform.apply_bounds(blases[instance.blas_index].blas->get_bounds());
+    tlas_dirty = true;
+}
+
+CompiledScene::UpdateResult CompiledScene::Update(ThreadPool* pool) {
+    UpdateResult result = {world->Update(rebuild_threshold, pool), BvhUpdate::Unchanged};
+    if (!tlas_dirty) return result;
+
+    // instance indices live in the TLAS prim indices, so unlike
+    //   a Blas nothing else has to be reordered on a rebuild
+    if (rebuild_threshold > 1.0f) {
+        tlas.Refit(instance_bounds, pool);
+        result.tlas = BvhUpdate::Refit;
+    }
+
+    if (rebuild_threshold <= 1.0f || tlas.GetQualityRatio() > rebuild_threshold) {
+        tlas.Build(instance_bounds);
+        result.tlas = BvhUpdate::Rebuild;
+    }
+
+    tlas_dirty = false;
+    return result;
+}
+
+bool CompiledScene::Hit(const Ray& ray, const Interval& ray_t, HitData* out_hit) const {
+    float t_min = ray_t.get_min();
+    float t_closest = ray_t.get_max();
+    uint32_t sphere = 0;
+    bool hit_world = world->Hit(ray, t_min, &t_closest, &sphere);
+
+    int32_t hit_instance = -1;
+    if (!instances.empty()) {
+        const Vec3f& dir = ray.get_direction();
+        const std::vector<uint32_t>& tlas_instances = tlas.get_prim_indices();
+
+        // instance rays keep their unnormalized direction so distances
+        //   match world space and t_closest culls across both levels
+        tlas.Traverse(ray, t_min, &t_closest, [&](uint32_t first, uint32_t count) {
+            for (uint32_t i = first; i < first + count; i++) {
+                uint32_t index = tlas_instances[i];
+                const InstanceRecord& instance = instances[index];
+                Ray object_ray(
+                    instance.world_to_object.apply_point(ray.get_origin()),
+                    instance.world_to_object.apply_vector(dir)
+                );
+
+                if (blases[instance.blas_index].blas->Hit(object_ray, t_min, &t_closest, &sphere)) {
+                    hit_instance = (int32_t)index;
+                }
+            }
+        });
+    }
+
+    if (hit_instance >= 0) {
+        const InstanceRecord& instance = instances[hit_instance];
+        const BlasEntry& entry = blases[instance.blas_index];
+        Ray object_ray(
+            instance.world_to_object.apply_point(ray.get_origin()),
+            instance.world_to_object.apply_vector(ray.get_direction())
+        );
+
+        instance_get_hit_data(*entry.blas, instance.world_to_object, sphere, ray, object_ray, t_closest, out_hit);
+        out_hit->material_index = entry.material_remap[out_hit->material_index];
+        out_hit->object_id = get_instance_object_id(hit_instance);
+        return true;
+    }
+
+    if (hit_world) {
+        world->GetHitData(sphere, ray, t_closest, out_hit);
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "hittable.h"
+#include "blas.h"
+#include "scene_builder.h"
+#include "../transform.h"
+#include "../materials/material_table.h"
+
+class HittableList;
+
+// flattened version of a HittableList that the renderer traces
+//   against. loose spheres go into one world space Blas, instances
+//   are kept as a transform plus a reference to a shared Blas and
+//   found through a top level BVH (the TLAS) over their world bounds
+class CompiledScene {
+   public:
+    // what Update had to do to each level
+    struct UpdateResult {
+        BvhUpdate world;
+        BvhUpdate tlas;
+    };
+
+   private:
+    struct BlasEntry {
+        std::shared_ptr<const Blas> blas;
+        // Blas material index -> scene MaterialTable index
+        std::vector<uint32_t> material_remap;
+    };
+
+    struct InstanceRecord {
+        Transform world_to_object;
+        Transform object_to_world;
+        uint32_t blas_index;
+    };
+
+    std::shared_ptr<Blas> world;
+    std::vector<BlasEntry> blases;
+    // indexed in authoring order, the TLAS refers to them through
+    //   its prim indices so instance indices stay stable
+    std::vector<InstanceRecord> instances;
+    std::vector<Aabb> instance_bounds;
+    Bvh tlas;
+    bool tlas_dirty;
+    MaterialTable materials;
+    float rebuild_threshold;
+
+   public:
+    CompiledScene();
+
+    static CompiledScene Compile(const HittableList& objects);
+    // for scenes that fill in a builder directly instead of going
+    //   through an object graph, see SceneFile::Compile
+    static CompiledScene Compile(SceneBuilder& builder);
+
+    bool Hit(const Ray& ray, const Interval& ray_t, HitData* out_hit) const;
+
+    // moves a loose sphere by the order it was compiled in
+    void SetSphereCenter(uint32_t index, const Vec3f& center);
+    Vec3f get_sphere_center(uint32_t index) const { return world->get_sphere_center(index); }
+
+    // moves an instance, the Blas it points at is left untouched
+    void SetInstanceTransform(uint32_t index, const Transform& transform);
+    const Transform& get_instance_transform(uint32_t index) const { return instances[index].object_to_world; }
+
+    // call once per frame after moving things and before tracing,
+    //   both levels are refit and rebuilt when they've degraded
+    //   too far, see Blas::Update
+    UpdateResult Update(ThreadPool* pool = nullptr);
+
+    void set_rebuild_threshold(float threshold) { rebuild_threshold = threshold; }
+    float get_rebuild_threshold() const { return rebuild_threshold; }
+    float GetWorldQualityRatio() const { return world->GetQualityRatio(); }
+    float GetTlasQualityRatio() const { return tlas.GetQualityRatio(); }
+
+    // swaps a material's parameters in place, e.g. for look-dev edits
+    void SetMaterial(uint32_t index, const MaterialRecord& record) { materials.Set(index, record); }
+
+    // every loose sphere and every instance gets an object id that
+    //   ends up in HitData::object_id, loose spheres come first
+    uint32_t get_sphere_object_id(uint32_t index) const { return index; }
+    uint32_t get_instance_object_id(uint32_t index) const { return world->get_sphere_count() + index; }
+    Aabb GetSphereBounds(uint32_t index) const { return world->GetSphereBounds(index); }
+    const Aabb& get_instance_bounds(uint32_t index) const { return instance_bounds[index]; }
+
+    const MaterialTable& get_materials() const { return materials; }
+    uint32_t get_sphere_count() const { return world->get_sphere_count(); }
+    uint32_t get_instance_count() const { return (uint32_t)instances.size(); }
+    uint32_t get_blas_count() const { return (uint32_t)blases.size(); }
+};
@@ -6,11 +6,19 @@
 #include <memory>
 
 class Material;
+class SceneBuilder;
 
 struct HitData {
     Vec3f point;
     Vec3f normal;
-    std::shared_ptr<Material> material;
+    // raw pointer so copying hit data never touches a refcount,
+    //   the object owning the material outlives every hit. compiled
+    //   scenes only fill in the index into their MaterialTable
+    const Material* material;
+    uint32_t material_index;
+    // compiled scenes only, see CompiledScene::get_sphere_object_id
+    //   and get_instance_object_id
+    uint32_t object_id;
     float t;
     bool front_face;
 };
@@ -21,4 +29,8 @@ class Hittable {
    public:
     virtual ~Hittable() = default;
     virtual bool Hit(const Ray& ray, const Interval& ray_t, HitData* out_hit) const = 0;
+
+    // adds the object's primitives and materials to a flattened
+    //   scene, see CompiledScene::Compile
+    virtual void Compile(SceneBuilder* builder) const { }
 };
@@ -26,3 +26,9 @@ bool HittableList::Hit(const Ray& ray, const Interval& ray_t, HitData* out_hit)
 
     return hit_anything;
 }
+
+void HittableList::Compile(SceneBuilder* builder) const {
+    for (const auto& object : objects) {
+        object->Compile(builder);
+    }
+}
@@ -16,4 +16,5 @@ class HittableList : public Hittable {
     void Add(std::shared_ptr<Hittable> object);
 
     bool Hit(const Ray& ray, const Interval& ray_t, HitData* out_hit) const override;
+    void Compile(SceneBuilder* builder) const override;
 };
@@ -0,0 +1,46 @@
+#include "instance.h"
+
+void instance_get_hit_data(
+    const Blas& blas,
+    const Transform& world_to_object,
+    uint32_t sphere,
+    const Ray& world_ray,
+    const Ray& object_ray,
+    float t,
+    HitData* out_hit
+) {
+    // the object space direction isn't renormalized so
+    //   t is the same distance in both spaces
+    blas.GetHitData(sphere, object_ray, t, out_hit);
+    out_hit->point = world_ray.get_at(t);
+
+    // normals transform with the inverse transpose
+    Vec3f outward_normal = out_hit->front_face ? out_hit->normal : -out_hit->normal;
+    outward_normal = Vec3f::normalize(world_to_object.apply_transposed(outward_normal));
+    hit_data_set_face_normal(out_hit, world_ray, outward_normal);
+}
+
+Instance::Instance(std::shared_ptr<const Blas> blas, const Transform& transform)
+  : blas(blas),
+    object_to_world(transform),
+    world_to_object(transform.get_inverse()) { }
+
+bool Instance::Hit(const Ray& ray, const Interval& ray_t, HitData* out_hit) const {
+    Ray object_ray(
+        world_to_object.apply_point(ray.get_origin()),
+        world_to_object.apply_vector(ray.get_direction())
+    );
+
+    float t_closest = ray_t.get_max();
+    uint32_t sphere;
+    if (!blas->Hit(object_ray, ray_t.get_min(), &t_closest, &sphere)) {
+        return false;
+    }
+
+    instance_get_hit_data(*blas, world_to_object, sphere, ray, object_ray, t_closest, out_hit);
+    return true;
+}
+
+void Instance::Compile(SceneBuilder* builder) const {
+    builder->AddInstance(blas, object_to_world);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <memory>
+#include "hittable.h"
+#include "blas.h"
+#include "../transform.h"
+
+// a shared Blas placed in the world with an affine transform,
+//   any number of instances can point at the same Blas
+class Instance : public Hittable {
+   private:
+    std::shared_ptr<const Blas> blas;
+    Transform object_to_world;
+    Transform world_to_object;
+
+   public:
+    Instance(std::shared_ptr<const Blas> blas, const Transform& transform);
+
+    bool Hit(const Ray& ray, const Interval& ray_t, HitData* out_hit) const override;
+    void Compile(SceneBuilder* builder) const override;
+};
+
+// shared by Instance::Hit and CompiledScene, the hit is found in object
+//   space and its point and normal are moved back to world space
+void instance_get_hit_data(
+    const Blas& blas,
+    const Transform& world_to_object,
+    uint32_t sphere,
+    const Ray& world_ray,
+    const Ray& object_ray,
+    float t,
+    HitData* out_hit
+);
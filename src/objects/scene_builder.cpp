@@ -0,0 +1,21 @@
+#include "scene_builder.h"
+
+uint32_t SceneBuilder::AddMaterial(const std::shared_ptr<Material>& material) {
+    auto it = material_indices.find(material.get());
+    if (it != material_indices.end()) {
+        return it->second;
+    }
+
+    uint32_t index = (uint32_t)materials.size();
+    materials.push_back(material);
+    material_indices[material.get()] = index;
+    return index;
+}
+
+void SceneBuilder::AddSphere(const Vec3f& center, float radius, const std::shared_ptr<Material>& material) {
+    spheres.push_back({center, radius, AddMaterial(material)});
+}
+
+void SceneBuilder::AddInstance(const std::shared_ptr<const Blas>& blas, const Transform& transform) {
+    instances.push_back({blas, transform});
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "../vec3.h"
+#include "../transform.h"
+
+class Material;
+class Blas;
+
+// collects primitives from the object graph, see Hittable::Compile
+class SceneBuilder {
+   public:
+    struct SpherePrimitive {
+        Vec3f center;
+        float radius;
+        uint32_t material_index;
+    };
+
+    struct InstancePrimitive {
+        std::shared_ptr<const Blas> blas;
+        Transform transform;
+    };
+
+   private:
+    std::unordered_map<const Material*, uint32_t> material_indices;
+
+   public:
+    // every distinct material once, indexed by SpherePrimitive::material_index
+    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<SpherePrimitive> spheres;
+    std::vector<InstancePrimitive> instances;
+
+    uint32_t AddMaterial(const std::shared_ptr<Material>& material);
+    void AddSphere(const Vec3f& center, float radius, const std::shared_ptr<Material>& material);
+    void AddInstance(const std::shared_ptr<const Blas>& blas, const Transform& transform);
+};
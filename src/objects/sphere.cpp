@@ -1,5 +1,8 @@
 #include "sphere.h"
 
+#include "../ray_stats.h"
+#include "scene_builder.h"
+
 Sphere::Sphere(
     const Vec3f& center,
     float radius,
@@ -9,12 +12,16 @@ Sphere::Sphere(
     material(material) { }
 
 bool Sphere::Hit(const Ray& ray, const Interval& ray_t, HitData* out_hit_data) const {
+    STATS_INC(sphere_tests);
+
+    // unit rays have a == 1, which drops the multiply and both divides
+    bool unit = ray.is_unit();
     Vec3f oc = center - ray.get_origin();
-    float a = Vec3f::length_sq(ray.get_direction());
+    float a = ray.get_length_sq();
     float h = Vec3f::dot(ray.get_direction(), oc);
     float c = Vec3f::length_sq(oc) - radius * radius;
 
-    float descriminant = h * h - a * c;
+    float descriminant = unit ? h * h - c : h * h - a * c;
     if (descriminant < 0) {
         return false;
     }
@@ -22,9 +29,9 @@ bool Sphere::Hit(const Ray& ray, const Interval& ray_t, HitData* out_hit_data) c
     float sqrt_d = std::sqrt(descriminant);
 
     // find the nearest root that lies within acceptable range
-    float root = (h - sqrt_d) / a;
+    float root = unit ? h - sqrt_d : (h - sqrt_d) / a;
     if (!ray_t.Surrounds(root)) {
-        root = (h + sqrt_d) / a;
+        root = unit ? h + sqrt_d : (h + sqrt_d) / a;
         if (!ray_t.Surrounds(root)) {
             return false;
         }
@@ -32,9 +39,13 @@ bool Sphere::Hit(const Ray& ray, const Interval& ray_t, HitData* out_hit_data) c
 
     out_hit_data->t = root;
     out_hit_data->point = ray.get_at(root);
-    out_hit_data->material = material;
+    out_hit_data->material = material.get();
     Vec3f outward_normal = (out_hit_data->point - center) / radius;
     hit_data_set_face_normal(out_hit_data, ray, outward_normal);
 
     return true;
 }
+
+void Sphere::Compile(SceneBuilder* builder) const {
+    builder->AddSphere(center, radius, material);
+}
@@ -16,4 +16,5 @@ class Sphere : public Hittable {
     Sphere(const Vec3f& center, float radius, std::shared_ptr<Material> material);
 
     bool Hit(const Ray& ray, const Interval& ray_t, HitData* out_hit_data) const override;
+    void Compile(SceneBuilder* builder) const override;
 };
@@ -0,0 +1,154 @@
+#include "perf_counters.h"
+
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static bool set_event_config(PerfEvent event, perf_event_attr* attr) {
+    switch (event) {
+        case PerfEvent::Cycles:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_CPU_CYCLES;
+            return true;
+        case PerfEvent::Instructions:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+            return true;
+        case PerfEvent::L1DMisses:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = PERF_COUNT_HW_CACHE_L1D |
+                           (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            return true;
+        case PerfEvent::LLCMisses:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = PERF_COUNT_HW_CACHE_LL |
+                           (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            return true;
+        case PerfEvent::BranchMisses:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+            return true;
+        case PerfEvent::Count: break;
+    }
+
+    return false;
+}
+
+PerfCounters::PerfCounters(int32_t thread_id) {
+    for (uint32_t i = 0; i < PERF_EVENT_COUNT; i++) {
+        fds[i] = -1;
+
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        if (!set_event_config((PerfEvent)i, &attr)) continue;
+
+        int fd = (int)syscall(SYS_perf_event_open, &attr, thread_id, -1, -1, 0);
+        if (fd < 0) {
+            // keep the first reason, it's usually the same for every event
+            if (error.empty()) {
+                error = std::string("perf_event_open failed: ") + strerror(errno);
+            }
+            continue;
+        }
+
+        fds[i] = fd;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (uint32_t i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+}
+
+void PerfCounters::Start() {
+    for (uint32_t i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (fds[i] < 0) continue;
+        ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void PerfCounters::Stop() {
+    for (uint32_t i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (fds[i] < 0) continue;
+        ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+}
+
+PerfValues PerfCounters::Read() const {
+    PerfValues result {};
+
+    for (uint32_t i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (fds[i] < 0) continue;
+
+        // value, time enabled, time running
+        uint64_t data[3];
+        if (read(fds[i], data, sizeof(data)) != sizeof(data)) continue;
+
+        // scale up if the kernel had to multiplex the counter
+        double scale = data[2] > 0 ? (double)data[1] / data[2] : 0.0;
+        result.values[i] = (uint64_t)(data[0] * scale);
+        result.valid[i] = data[2] > 0;
+    }
+
+    return result;
+}
+
+#else
+
+PerfCounters::PerfCounters(int32_t thread_id)
+  : error("hardware counters are only supported on linux") {
+    for (uint32_t i = 0; i < PERF_EVENT_COUNT; i++) {
+        fds[i] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() { }
+void PerfCounters::Start() { }
+void PerfCounters::Stop() { }
+PerfValues PerfCounters::Read() const { return {}; }
+
+#endif
+
+PerfValues& PerfValues::operator+=(const PerfValues& other) {
+    for (uint32_t i = 0; i < PERF_EVENT_COUNT; i++) {
+        values[i] += other.values[i];
+        valid[i] = valid[i] || other.valid[i];
+    }
+
+    return *this;
+}
+
+bool PerfCounters::is_available() const {
+    for (uint32_t i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (fds[i] >= 0) return true;
+    }
+
+    return false;
+}
+
+const char* PerfCounters::event_name(PerfEvent event) {
+    switch (event) {
+        case PerfEvent::Cycles: return "cycles";
+        case PerfEvent::Instructions: return "instructions";
+        case PerfEvent::L1DMisses: return "L1D misses";
+        case PerfEvent::LLCMisses: return "LLC misses";
+        case PerfEvent::BranchMisses: return "branch misses";
+        case PerfEvent::Count: break;
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+enum class PerfEvent : uint32_t {
+    Cycles,
+    Instructions,
+    L1DMisses,
+    LLCMisses,
+    BranchMisses,
+    Count
+};
+
+constexpr uint32_t PERF_EVENT_COUNT = (uint32_t)PerfEvent::Count;
+
+struct PerfValues {
+    uint64_t values[PERF_EVENT_COUNT];
+    bool valid[PERF_EVENT_COUNT];
+
+    PerfValues& operator+=(const PerfValues& other);
+};
+
+// hardware counters for a single thread through linux perf_event_open,
+//   every event is opened on its own so a machine (or container) that
+//   only supports some of them still reports the ones it has
+class PerfCounters {
+   private:
+    int fds[PERF_EVENT_COUNT];
+    std::string error;
+
+   public:
+    // thread_id is the kernel tid of the thread to count
+    PerfCounters(int32_t thread_id);
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    void Start();
+    void Stop();
+    PerfValues Read() const;
+
+    bool is_available() const;
+    const std::string& get_error() const { return error; }
+
+    static const char* event_name(PerfEvent event);
+};
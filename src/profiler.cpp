@@ -0,0 +1,208 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// per thread, old events are overwritten once it's full
+constexpr uint32_t RING_CAPACITY = 1 << 15;
+constexpr uint32_t CLOCK_CALIBRATION_READS = 64;
+
+struct TraceEvent {
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    Profiler::Stage stage;
+};
+
+struct ThreadData {
+    uint32_t thread_id;
+    std::array<TraceEvent, RING_CAPACITY> events;
+    std::atomic<uint64_t> write_index;
+    std::array<uint64_t, Profiler::STAGE_COUNT> stage_ns;
+    std::array<uint64_t, Profiler::STAGE_COUNT> stage_calls;
+
+    ThreadData(uint32_t thread_id)
+      : thread_id(thread_id),
+        write_index(0),
+        stage_ns {},
+        stage_calls {} { }
+};
+
+// threads only register once, after that they only touch their own data
+static std::mutex registry_mtx;
+static std::vector<std::unique_ptr<ThreadData>> registry;
+static const uint64_t epoch_ns = Profiler::now_ns();
+
+static ThreadData& get_thread_data() {
+    thread_local ThreadData* data = nullptr;
+    if (data == nullptr) {
+        std::lock_guard<std::mutex> lock(registry_mtx);
+        registry.push_back(std::make_unique<ThreadData>((uint32_t)registry.size()));
+        data = registry.back().get();
+    }
+
+    return *data;
+}
+
+const char* Profiler::stage_name(Stage stage) {
+    switch (stage) {
+        case Stage::Frame: return "Frame";
+        case Stage::RenderBatch: return "RenderBatch";
+        case Stage::RayGeneration: return "RayGeneration";
+        case Stage::Intersection: return "Intersection";
+        case Stage::Scattering: return "Scattering";
+        case Stage::Resolve: return "Resolve";
+        case Stage::Upscale: return "Upscale";
+        case Stage::Reconstruct: return "Reconstruct";
+        case Stage::PoolWait: return "ThreadPool::Wait";
+        case Stage::Present: return "Thirteen::Render";
+        case Stage::Count: break;
+    }
+
+    return "unknown";
+}
+
+uint64_t Profiler::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()
+    )
+        .count();
+}
+
+void Profiler::RecordEvent(Stage stage, uint64_t start_ns, uint64_t end_ns) {
+    ThreadData& data = get_thread_data();
+
+    uint64_t index = data.write_index.load(std::memory_order_relaxed);
+    data.events[index % RING_CAPACITY] = {start_ns, end_ns - start_ns, stage};
+    data.write_index.store(index + 1, std::memory_order_release);
+
+    data.stage_ns[(uint32_t)stage] += end_ns - start_ns;
+    data.stage_calls[(uint32_t)stage]++;
+}
+
+// what two back to back clock reads measure, the least of a few
+//   tries so a preemption in between doesn't count
+static uint64_t get_clock_overhead_ns() {
+    uint64_t overhead = UINT64_MAX;
+    for (uint32_t i = 0; i < CLOCK_CALIBRATION_READS; i++) {
+        uint64_t start = Profiler::now_ns();
+        overhead = std::min(overhead, Profiler::now_ns() - start);
+    }
+
+    return overhead;
+}
+
+void Profiler::AddPathStageTime(Stage stage, uint64_t start_ns, uint64_t end_ns) {
+    static const uint64_t clock_overhead_ns = get_clock_overhead_ns();
+
+    uint64_t duration_ns = end_ns - start_ns;
+    duration_ns = duration_ns > clock_overhead_ns ? duration_ns - clock_overhead_ns : 0;
+
+    ThreadData& data = get_thread_data();
+    data.stage_ns[(uint32_t)stage] += duration_ns * PATH_SAMPLE_INTERVAL;
+    data.stage_calls[(uint32_t)stage] += PATH_SAMPLE_INTERVAL;
+}
+
+bool Profiler::WriteChromeTrace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        std::cerr << "couldn't open trace file \"" << path << "\"\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mtx);
+
+    // chrome://tracing and perfetto both take the JSON trace event
+    //   format, timestamps are in (fractional) microseconds
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (const auto& data : registry) {
+        fprintf(
+            file,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+            first ? "" : ",\n",
+            data->thread_id,
+            data->thread_id
+        );
+        first = false;
+
+        uint64_t end = data->write_index.load(std::memory_order_acquire);
+        uint64_t begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+        for (uint64_t i = begin; i < end; i++) {
+            const TraceEvent& event = data->events[i % RING_CAPACITY];
+            fprintf(
+                file,
+                ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                stage_name(event.stage),
+                data->thread_id,
+                (event.start_ns - epoch_ns) / 1000.0,
+                event.duration_ns / 1000.0
+            );
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    return true;
+}
+
+void Profiler::PrintSummary(std::ostream& out) {
+    std::array<uint64_t, STAGE_COUNT> total_ns {};
+    std::array<uint64_t, STAGE_COUNT> total_calls {};
+
+    {
+        std::lock_guard<std::mutex> lock(registry_mtx);
+        for (const auto& data : registry) {
+            for (uint32_t i = 0; i < STAGE_COUNT; i++) {
+                total_ns[i] += data->stage_ns[i];
+                total_calls[i] += data->stage_calls[i];
+            }
+        }
+    }
+
+    uint64_t frames = std::max<uint64_t>(1, total_calls[(uint32_t)Stage::Frame]);
+
+    // per-ray stages are summed across threads so they're reported as
+    //   thread time, which can be larger than the wall time of a frame.
+    //   they're also scaled up from sampled paths, see PATH_SAMPLE_INTERVAL
+    out << "=== profile summary (" << frames << " frames) ===\n";
+    out << std::left << std::setw(20) << "stage"
+        << std::right << std::setw(14) << "total ms"
+        << std::setw(14) << "ms/frame"
+        << std::setw(14) << "calls"
+        << std::setw(14) << "ns/call" << "\n";
+
+    for (uint32_t i = 0; i < STAGE_COUNT; i++) {
+        if (total_calls[i] == 0) continue;
+
+        out << std::left << std::setw(20) << stage_name((Stage)i)
+            << std::right << std::fixed << std::setprecision(3)
+            << std::setw(14) << total_ns[i] / 1e6
+            << std::setw(14) << total_ns[i] / 1e6 / frames
+            << std::setw(14) << total_calls[i]
+            << std::setw(14) << std::setprecision(1) << (double)total_ns[i] / total_calls[i] << "\n";
+    }
+}
+
+void Profiler::Reset() {
+    std::lock_guard<std::mutex> lock(registry_mtx);
+    for (const auto& data : registry) {
+        data->write_index.store(0, std::memory_order_relaxed);
+        data->stage_ns.fill(0);
+        data->stage_calls.fill(0);
+    }
+}
+
+bool Profiler::is_enabled() {
+#ifdef RTRT_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
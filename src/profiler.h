@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <iostream>
+
+// low overhead frame profiler, only compiled in when building with
+//   RTRT_PROFILE defined (make PROFILE=1). every thread writes into its
+//   own ring buffer of trace events and its own per-stage totals so
+//   the hot path never takes a lock
+namespace Profiler {
+    enum class Stage : uint32_t {
+        Frame,
+        RenderBatch,
+        RayGeneration,
+        Intersection,
+        Scattering,
+        Resolve,
+        Upscale,
+        Reconstruct,
+        PoolWait,
+        Present,
+        Count
+    };
+
+    constexpr uint32_t STAGE_COUNT = (uint32_t)Stage::Count;
+    // per ray stages are too short to read the clock around every one
+    //   of them, it'd cost more than some of the stages. only every
+    //   PATH_SAMPLE_INTERVAL-th path a thread starts is timed, and its
+    //   times and calls count for the whole interval
+    constexpr uint32_t PATH_SAMPLE_INTERVAL = 64;
+
+    const char* stage_name(Stage stage);
+    uint64_t now_ns();
+
+    // coarse work gets a trace event plus its time added to the stage
+    //   total, fine-grained work (per ray) only adds to the total
+    void RecordEvent(Stage stage, uint64_t start_ns, uint64_t end_ns);
+    // one call of a per ray stage on a timed path, counted for the whole
+    //   sample interval with the cost of reading the clock taken out
+    void AddPathStageTime(Stage stage, uint64_t start_ns, uint64_t end_ns);
+
+    // whether the calling thread's current path is one of the timed ones
+    inline thread_local bool path_timed = false;
+    inline thread_local uint32_t paths_until_timed = 0;
+
+    // call once per path before any of its stages
+    inline void StartPath() {
+        path_timed = paths_until_timed == 0;
+        paths_until_timed = path_timed ? PATH_SAMPLE_INTERVAL - 1 : paths_until_timed - 1;
+    }
+
+    // these read every thread's buffers, only call while the
+    //   render threads are idle (e.g. after ThreadPool::Wait)
+    bool WriteChromeTrace(const char* path);
+    void PrintSummary(std::ostream& out);
+    void Reset();
+
+    bool is_enabled();
+
+    class ScopedEvent {
+       private:
+        Stage stage;
+        uint64_t start;
+
+       public:
+        ScopedEvent(Stage stage) : stage(stage), start(now_ns()) { }
+        ~ScopedEvent() { RecordEvent(stage, start, now_ns()); }
+    };
+
+    // a per ray stage, only timed on sampled paths
+    class ScopedStage {
+       private:
+        Stage stage;
+        bool timed;
+        uint64_t start;
+
+       public:
+        ScopedStage(Stage stage) : stage(stage), timed(path_timed), start(timed ? now_ns() : 0) { }
+        ~ScopedStage() {
+            if (timed) {
+                AddPathStageTime(stage, start, now_ns());
+            }
+        }
+    };
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef RTRT_PROFILE
+#define PROFILE_EVENT(stage) Profiler::ScopedEvent PROFILE_CONCAT(profile_event_, __LINE__)(stage)
+#define PROFILE_STAGE(stage) Profiler::ScopedStage PROFILE_CONCAT(profile_stage_, __LINE__)(stage)
+#define PROFILE_PATH() Profiler::StartPath()
+#else
+#define PROFILE_EVENT(stage)
+#define PROFILE_STAGE(stage)
+#define PROFILE_PATH()
+#endif
@@ -1,9 +1,16 @@
 #include "ray.h"
 
+// how far the squared length may be from 1 for a ray to count as unit.
+//   treating it as exactly 1 moves hits by about t * epsilon / 2, which
+//   stays well under the surface offset at any distance the scenes use
+constexpr float UNIT_LENGTH_EPSILON = 1e-5f;
+
 Ray::Ray(const Vec3f& origin, const Vec3f& direction)
   : origin(origin),
-    direction(direction) { }
-
-Vec3f Ray::get_at(float t) const { return origin + (direction * t); }
-const Vec3f& Ray::get_origin() const { return origin; }
-const Vec3f& Ray::get_direction() const { return direction; }
+    direction(direction),
+    inv_direction(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z),
+    length_sq(Vec3f::length_sq(direction)),
+    // from the inverse so a -0 component counts as negative, matching
+    //   the -infinity it inverts to
+    sign_mask((uint8_t)((inv_direction.x < 0.0f) | ((inv_direction.y < 0.0f) << 1) | ((inv_direction.z < 0.0f) << 2))),
+    unit(std::fabs(length_sq - 1.0f) < UNIT_LENGTH_EPSILON) { }
@@ -1,16 +1,34 @@
 #pragma once
 
+#include <stdint.h>
 #include "vec3.h"
 
+// a ray along with everything intersection tests would otherwise
+//   work out again per object, computed once when it's made
 class Ray {
    private:
     Vec3f origin;
     Vec3f direction;
+    Vec3f inv_direction;
+    float length_sq;
+    // bit 0/1/2 set when the x/y/z direction is negative, slab tests
+    //   use it to pick the near plane without comparing
+    uint8_t sign_mask;
+    // close enough to unit length that intersection tests can skip
+    //   dividing by it, see UNIT_LENGTH_EPSILON
+    bool unit;
 
    public:
     Ray(const Vec3f& origin, const Vec3f& direction);
 
-    Vec3f get_at(float t) const;
-    const Vec3f& get_origin() const;
-    const Vec3f& get_direction() const;
+    Vec3f get_at(float t) const { return origin + (direction * t); }
+    const Vec3f& get_origin() const { return origin; }
+    const Vec3f& get_direction() const { return direction; }
+    const Vec3f& get_inv_direction() const { return inv_direction; }
+    float get_length_sq() const { return length_sq; }
+    uint8_t get_sign_mask() const { return sign_mask; }
+    bool is_unit() const { return unit; }
+
+    // the direction scaled to unit length, free for unit rays
+    Vec3f get_unit_direction() const { return unit ? direction : direction / std::sqrt(length_sq); }
 };
@@ -0,0 +1,102 @@
+#include "ray_stats.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <iomanip>
+#include <string>
+
+// threads only register once, after that they only touch their own counters
+static std::mutex registry_mtx;
+static std::vector<std::unique_ptr<RayStats::Counters>> registry;
+static RayStats::FrameStats last_frame {};
+static RayStats::FrameStats total {};
+
+static void add_counters(RayStats::Counters* a, const RayStats::Counters& b) {
+    a->primary_rays += b.primary_rays;
+    a->secondary_rays += b.secondary_rays;
+    a->depth_limit_hits += b.depth_limit_hits;
+    a->sphere_tests += b.sphere_tests;
+    for (uint32_t i = 0; i < RayStats::MATERIAL_KIND_COUNT; i++) {
+        a->scatter_accepted[i] += b.scatter_accepted[i];
+        a->scatter_rejected[i] += b.scatter_rejected[i];
+    }
+}
+
+double RayStats::FrameStats::get_rays_per_second() const {
+    if (frame_ms <= 0.0) return 0.0;
+    return get_total_rays() / (frame_ms / 1000.0);
+}
+
+double RayStats::FrameStats::get_average_depth() const {
+    if (counters.primary_rays == 0) return 0.0;
+    return (double)get_total_rays() / counters.primary_rays;
+}
+
+const char* RayStats::material_kind_name(MaterialKind kind) {
+    switch (kind) {
+        case MaterialKind::Lambertian: return "lambertian";
+        case MaterialKind::Metal: return "metal";
+        case MaterialKind::Count: break;
+    }
+
+    return "unknown";
+}
+
+RayStats::Counters& RayStats::get_thread_counters() {
+    thread_local Counters* counters = nullptr;
+    if (counters == nullptr) {
+        std::lock_guard<std::mutex> lock(registry_mtx);
+        registry.push_back(std::make_unique<Counters>());
+        counters = registry.back().get();
+    }
+
+    return *counters;
+}
+
+void RayStats::EndFrame(double frame_ms) {
+    std::lock_guard<std::mutex> lock(registry_mtx);
+
+    last_frame = {};
+    last_frame.frame_ms = frame_ms;
+    for (const auto& counters : registry) {
+        add_counters(&last_frame.counters, *counters);
+        *counters = {};
+    }
+
+    add_counters(&total.counters, last_frame.counters);
+    total.frame_ms += frame_ms;
+}
+
+const RayStats::FrameStats& RayStats::get_last_frame() {
+    return last_frame;
+}
+
+const RayStats::FrameStats& RayStats::get_total() {
+    return total;
+}
+
+void RayStats::Print(std::ostream& out, const FrameStats& stats) {
+    const Counters& c = stats.counters;
+
+    out << std::fixed << std::setprecision(3);
+    out << std::left << std::setw(20) << "primary rays:" << std::right << c.primary_rays << "\n";
+    out << std::left << std::setw(20) << "secondary rays:" << std::right << c.secondary_rays << "\n";
+    out << std::left << std::setw(20) << "rays/sec:" << std::right << stats.get_rays_per_second() / 1e6 << " M\n";
+    out << std::left << std::setw(20) << "avg path depth:" << std::right << stats.get_average_depth() << "\n";
+    out << std::left << std::setw(20) << "depth limit hits:" << std::right << c.depth_limit_hits << "\n";
+    out << std::left << std::setw(20) << "sphere tests:" << std::right << c.sphere_tests << "\n";
+    for (uint32_t i = 0; i < MATERIAL_KIND_COUNT; i++) {
+        out << std::left << std::setw(20) << (std::string(material_kind_name((MaterialKind)i)) + " scatter:")
+            << std::right << c.scatter_accepted[i] << " accepted, "
+            << c.scatter_rejected[i] << " rejected\n";
+    }
+}
+
+bool RayStats::is_enabled() {
+#ifdef RTRT_STATS
+    return true;
+#else
+    return false;
+#endif
+}
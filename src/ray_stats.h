@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include <iostream>
+
+// per-thread ray counters, only compiled in when building with
+//   RTRT_STATS defined (make STATS=1). the counting macros expand to
+//   nothing otherwise so regular builds pay nothing for them
+namespace RayStats {
+    enum class MaterialKind : uint32_t {
+        Lambertian,
+        Metal,
+        Count
+    };
+
+    constexpr uint32_t MATERIAL_KIND_COUNT = (uint32_t)MaterialKind::Count;
+
+    struct Counters {
+        uint64_t primary_rays;
+        uint64_t secondary_rays;
+        uint64_t depth_limit_hits;
+        uint64_t sphere_tests;
+        uint64_t scatter_accepted[MATERIAL_KIND_COUNT];
+        uint64_t scatter_rejected[MATERIAL_KIND_COUNT];
+    };
+
+    struct FrameStats {
+        Counters counters;
+        double frame_ms;
+
+        uint64_t get_total_rays() const { return counters.primary_rays + counters.secondary_rays; }
+        double get_rays_per_second() const;
+        // rays per path, a path is one primary ray and all of its bounces
+        double get_average_depth() const;
+    };
+
+    const char* material_kind_name(MaterialKind kind);
+
+    Counters& get_thread_counters();
+
+    // sums and clears every thread's counters, only call while the
+    //   render threads are idle (e.g. after ThreadPool::Wait)
+    void EndFrame(double frame_ms);
+
+    const FrameStats& get_last_frame();
+    // every frame since startup added together
+    const FrameStats& get_total();
+
+    void Print(std::ostream& out, const FrameStats& stats);
+
+    bool is_enabled();
+};
+
+#ifdef RTRT_STATS
+#define STATS_INC(counter) (RayStats::get_thread_counters().counter++)
+#define STATS_ADD(counter, amount) (RayStats::get_thread_counters().counter += (amount))
+#define STATS_SCATTER(kind, accepted)                                                           \
+    ((accepted) ? RayStats::get_thread_counters().scatter_accepted[(uint32_t)(kind)]++          \
+                : RayStats::get_thread_counters().scatter_rejected[(uint32_t)(kind)]++)
+#else
+#define STATS_INC(counter)
+#define STATS_ADD(counter, amount)
+#define STATS_SCATTER(kind, accepted)
+#endif
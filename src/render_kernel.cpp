@@ -0,0 +1,25 @@
+#include "render_kernel.h"
+
+#include <cstring>
+
+const char* RenderKernel::preset_name(RenderPreset preset) {
+    switch (preset) {
+        case RenderPreset::Final: return "final";
+        case RenderPreset::Interactive: return "interactive";
+        case RenderPreset::Preview: return "preview";
+    }
+
+    return "unknown";
+}
+
+bool RenderKernel::parse_preset(const char* name, RenderPreset* out_preset) {
+    static const RenderPreset presets[] = {RenderPreset::Final, RenderPreset::Interactive, RenderPreset::Preview};
+    for (RenderPreset preset : presets) {
+        if (strcmp(name, preset_name(preset)) == 0) {
+            *out_preset = preset;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+
+// how deep paths go. each preset has its own set of compiled render
+//   kernels so the bounce loop's limit is a constant, switching is
+//   just picking a different entry of the kernel table
+enum class RenderPreset {
+    // deep enough that cutting paths off is never visible
+    Final,
+    // a few bounces, metal reflecting metal loses its last reflections
+    Interactive,
+    // the primary ray and two bounces, for moving around big scenes
+    Preview
+};
+
+namespace RenderKernel {
+    constexpr uint32_t PRESET_COUNT = 3;
+
+    constexpr uint32_t get_max_depth(RenderPreset preset) {
+        switch (preset) {
+            case RenderPreset::Final: return 50;
+            case RenderPreset::Interactive: return 8;
+            case RenderPreset::Preview: return 3;
+        }
+
+        return 50;
+    }
+
+    // what a kernel writes out besides radiance. no caller wants both
+    //   a tile record and a G-buffer, so that combination isn't compiled
+    enum class Output {
+        Radiance,
+        // what paths touch goes into the tile's record
+        TileRecord,
+        // primary hit depth and object id are written out for the upscaler
+        GBuffer
+    };
+    constexpr uint32_t OUTPUT_COUNT = 3;
+
+    // one pixel kernel per preset and output, batch kernels come
+    //   with and without the sample loop on top of that
+    constexpr uint32_t PIXEL_KERNEL_COUNT = PRESET_COUNT * OUTPUT_COUNT;
+    constexpr uint32_t BATCH_KERNEL_COUNT = PIXEL_KERNEL_COUNT * 2;
+
+    constexpr uint32_t get_pixel_kernel_index(RenderPreset preset, Output output) {
+        return (uint32_t)preset * OUTPUT_COUNT + (uint32_t)output;
+    }
+
+    constexpr uint32_t get_batch_kernel_index(RenderPreset preset, Output output, bool single_sample) {
+        return get_pixel_kernel_index(preset, output) * 2 + (single_sample ? 1 : 0);
+    }
+
+    // compile time configuration of pixel kernel number INDEX
+    template <uint32_t INDEX>
+    struct Policy {
+        static constexpr RenderPreset PRESET = (RenderPreset)(INDEX / OUTPUT_COUNT);
+        static constexpr uint32_t MAX_DEPTH = get_max_depth(PRESET);
+        static constexpr bool TILE_RECORD = (Output)(INDEX % OUTPUT_COUNT) == Output::TileRecord;
+        static constexpr bool GBUFFER = (Output)(INDEX % OUTPUT_COUNT) == Output::GBuffer;
+    };
+
+    // compile time configuration of batch kernel number INDEX
+    template <uint32_t INDEX>
+    struct BatchPolicy {
+        // the pixel kernel every pixel of the batch goes through
+        using Pixel = Policy<INDEX / 2>;
+        // one sample per pixel, no sample loop or averaging
+        static constexpr bool SINGLE_SAMPLE = INDEX % 2 != 0;
+    };
+
+    const char* preset_name(RenderPreset preset);
+    bool parse_preset(const char* name, RenderPreset* out_preset);
+};
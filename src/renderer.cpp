@@ -2,27 +2,134 @@
 
 #include "math_utils.h"
 #include "interval.h"
+#include "profiler.h"
+#include "ray_stats.h"
+#include "samplers/hash.h"
+#include <algorithm>
 #include <cstring>
+#include <chrono>
+#include <atomic>
+#include <cassert>
 
 constexpr uint32_t SAMPLES_PER_PIXEL = 30;
-constexpr uint32_t SCANLINES_PER_FRAME = 4;
-constexpr uint32_t RAY_MAX_DEPTH = 50;
+// a 60 fps frame
+constexpr double DEFAULT_FRAME_BUDGET_MS = 16.0;
+// how much of the per block cost average the latest frame makes up
+constexpr double BLOCK_COST_SMOOTHING = 0.25;
 constexpr float RAY_SURFACE_OFFSET = 0.001f;
-
-Renderer::Renderer(uint32_t width, uint32_t height, float low_res_scale)
+constexpr uint32_t SAMPLER_SEED = 0x5eed1234;
+// enough for a few tiles' worth of scratch, arenas grow if a frame needs more
+constexpr size_t FRAME_ARENA_SIZE = 64 * 1024;
+constexpr uint32_t TILE_SIZE = 16;
+// stored for primary rays that hit nothing, the sky is one object
+constexpr float GBUFFER_MISS_DEPTH = 1e30f;
+constexpr uint32_t GBUFFER_MISS_OBJECT = UINT32_MAX;
+// sampling jitters rays by up to half a pixel, footprints are grown
+//   by a pixel to stay conservative
+constexpr float FOOTPRINT_MARGIN = 1.0f;
+
+// sample dimensions are reserved up front so that each bounce always
+//   reads the same dimensions no matter what happened before it
+constexpr uint32_t PIXEL_DIMENSIONS = 2;
+constexpr uint32_t BOUNCE_DIMENSIONS = 4;
+
+Renderer::Renderer(uint32_t width, uint32_t height, float low_res_scale, const ThreadPlacement& placement)
   : full_width(width),
     full_height(height),
     low_res_width((uint32_t)(width * low_res_scale)),
     low_res_height((uint32_t)(height * low_res_scale)),
     low_res_scale(low_res_scale),
     low_res(false),
-    scanline(0),
-    thread_pool() {
-    low_res_pixels = new uint8_t[low_res_width * low_res_height * 4];
+    upscale_filter(UpscaleFilter::EdgeAware),
+    tiles_x((width + TILE_SIZE - 1) / TILE_SIZE),
+    tiles_y((height + TILE_SIZE - 1) / TILE_SIZE),
+    output_version(0),
+    full_output_version(0),
+    next_tile(0),
+    frame_budget_ms(DEFAULT_FRAME_BUDGET_MS),
+    average_ns_per_block(0.0),
+    shading_rate_source(ShadingRateSource::Off),
+    focus_x(width * 0.5f),
+    focus_y(height * 0.5f),
+    shading_rates_stale(true),
+    interleave_mode(InterleaveMode::Off),
+    interleave_phase(0),
+    has_tile_view(false),
+    samples_per_pixel(SAMPLES_PER_PIXEL),
+    render_preset(RenderPreset::Final),
+    sampler_type(SamplerType::Sobol),
+    sampler_seed(SAMPLER_SEED),
+    thread_pool(placement) {
+    CreateSamplers();
+
+    for (uint32_t i = 0; i < thread_pool.get_thread_count(); i++) {
+        frame_arenas.emplace_back(FRAME_ARENA_SIZE);
+    }
+}
+
+void Renderer::EnsureTiles() {
+    if (!tiles.empty()) return;
+
+    linear_pixels.resize((size_t)full_width * full_height * 4);
+    tiles.resize(tiles_x * tiles_y);
+    for (TileRecord& tile : tiles) {
+        tile.Clear();
+        tile.dirty = true;
+        tile.shading_rate = 0;
+        tile.target_rate = ShadingRate::FULL_RATE;
+        tile.ns_per_block = 0.0f;
+        tile.output_version = 0;
+    }
+    shading_rates_stale = true;
+}
+
+void Renderer::TileRecord::Clear() {
+    for (uint32_t i = 0; i < OBJECT_WORDS; i++) {
+        object_bits[i] = 0;
+    }
+    for (uint32_t i = 0; i < MATERIAL_WORDS; i++) {
+        material_bits[i] = 0;
+    }
+}
+
+void Renderer::TileRecord::Add(uint32_t object_id, uint32_t material_index) {
+    uint32_t object_bit = Hash::mix(object_id) % (OBJECT_WORDS * 64);
+    object_bits[object_bit / 64] |= 1ull << (object_bit % 64);
+    uint32_t material_bit = material_index % (MATERIAL_WORDS * 64);
+    material_bits[material_bit / 64] |= 1ull << (material_bit % 64);
 }
 
-Renderer::~Renderer() {
-    delete[] low_res_pixels;
+bool Renderer::TileRecord::HasObject(uint32_t object_id) const {
+    uint32_t object_bit = Hash::mix(object_id) % (OBJECT_WORDS * 64);
+    return (object_bits[object_bit / 64] >> (object_bit % 64)) & 1;
+}
+
+bool Renderer::TileRecord::HasMaterial(uint32_t material_index) const {
+    uint32_t material_bit = material_index % (MATERIAL_WORDS * 64);
+    return (material_bits[material_bit / 64] >> (material_bit % 64)) & 1;
+}
+
+void Renderer::CreateSamplers() {
+    // one sampler per worker thread, they hold per-sample state
+    samplers.clear();
+    for (uint32_t i = 0; i < thread_pool.get_thread_count(); i++) {
+        samplers.push_back(create_sampler(sampler_type, samples_per_pixel, sampler_seed));
+    }
+}
+
+void Renderer::set_sampler_type(SamplerType sampler_type) {
+    this->sampler_type = sampler_type;
+    CreateSamplers();
+}
+
+void Renderer::set_sampler_seed(uint32_t seed) {
+    sampler_seed = seed;
+    CreateSamplers();
+}
+
+void Renderer::set_samples_per_pixel(uint32_t samples_per_pixel) {
+    this->samples_per_pixel = samples_per_pixel;
+    CreateSamplers();
 }
 
 void Renderer::UpdateVectors(const Camera& camera, uint32_t width, uint32_t height) {
@@ -38,167 +145,874 @@ void Renderer::UpdateVectors(const Camera& camera, uint32_t width, uint32_t heig
     viewport_top_left += (pixel_down * 0.5f);
 }
 
-Vec3f Renderer::ShadePixel(const Ray& ray, const HittableList& objects, uint32_t max_rays) {
-    if (max_rays == 0) {
-        return {0, 0, 0};
-    }
+void Renderer::SetTileView(const Camera& camera) {
+    tile_view.cam_pos = camera.get_position();
+    tile_view.forward = camera.get_forward();
+    tile_view.focal_length = camera.get_focal_length();
+    tile_view.top_left = viewport_top_left;
+    tile_view.pixel_right = pixel_right;
+    tile_view.pixel_down = pixel_down;
+    has_tile_view = true;
+}
+
+bool Renderer::TileView::ProjectDirection(const Vec3f& direction, float* out_x, float* out_y) const {
+    float depth = Vec3f::dot(direction, forward);
+    if (depth <= 0.0f) return false;
+
+    Vec3f on_plane = direction * (focal_length / depth) + cam_pos - top_left;
+    *out_x = Vec3f::dot(on_plane, pixel_right) / Vec3f::length_sq(pixel_right);
+    *out_y = Vec3f::dot(on_plane, pixel_down) / Vec3f::length_sq(pixel_down);
+    return true;
+}
+
+template <typename K>
+Vec3f Renderer::TracePath(Ray ray, const CompiledScene& scene, Sampler& sampler, TileRecord* record, GBufferSample* out_primary) {
+    Vec3f throughput = {1.0f, 1.0f, 1.0f};
+
+    for (uint32_t bounce = 0; bounce < K::MAX_DEPTH; bounce++) {
+        HitData hit_data;
+        bool hit;
+        {
+            PROFILE_STAGE(Profiler::Stage::Intersection);
+            hit = scene.Hit(ray, Interval(RAY_SURFACE_OFFSET, INFINITY_F), &hit_data);
+        }
+
+        // the sample's own primary ray instead of a second one through
+        //   the pixel centre, camera rays are unit length so t is depth
+        if constexpr (K::GBUFFER) {
+            if (bounce == 0) {
+                out_primary->depth = hit ? hit_data.t : GBUFFER_MISS_DEPTH;
+                out_primary->object_id = hit ? hit_data.object_id : GBUFFER_MISS_OBJECT;
+            }
+        }
+
+        if (!hit) {
+            Vec3f dir_norm = ray.get_unit_direction();
+            float a = 0.5f * (dir_norm.y + 1.0f);
+            return throughput * Utils::lerp({1.0f, 1.0f, 1.0f}, {0.5f, 0.7f, 1.0f}, a);
+        }
+
+        // every bounce is recorded, not just primary hits, so that
+        //   editing an object also catches its reflections
+        if constexpr (K::TILE_RECORD) {
+            record->Add(hit_data.object_id, hit_data.material_index);
+        }
+
+        sampler.set_dimension(PIXEL_DIMENSIONS + bounce * BOUNCE_DIMENSIONS);
 
-    HitData hit_data;
-    if (objects.Hit(ray, Interval(RAY_SURFACE_OFFSET, INFINITY_F), &hit_data)) {
         Ray scattered({0, 0, 0}, {0, 0, 0});
         Vec3f attenuation;
-        if (hit_data.material->Scatter(ray, hit_data, &attenuation, &scattered)) {
-            return attenuation * ShadePixel(scattered, objects, max_rays - 1);
+        bool did_scatter;
+        {
+            PROFILE_STAGE(Profiler::Stage::Scattering);
+            did_scatter = scene.get_materials().Scatter(hit_data.material_index, ray, hit_data, sampler, &attenuation, &scattered);
+        }
+
+        if (!did_scatter) {
+            return {0, 0, 0};
+        }
+
+        STATS_INC(secondary_rays);
+        throughput *= attenuation;
+        ray = scattered;
+    }
+
+    STATS_INC(depth_limit_hits);
+    return {0, 0, 0};
+}
+
+template <typename K>
+Vec3f Renderer::SamplePixelKernel(uint32_t x, uint32_t y, uint32_t first_sample, uint32_t count, const Vec3f& cam_pos, const CompiledScene& scene, Sampler& sampler, TileRecord* record, GBufferSample* out_primary, uint32_t rate) {
+    Vec3f color = {0.0f, 0.0f, 0.0f};
+    for (uint32_t s = first_sample; s < first_sample + count; s++) {
+        sampler.StartSample(x, y, s);
+        STATS_INC(primary_rays);
+        PROFILE_PATH();
+        Ray r({0, 0, 0}, {0, 0, 0});
+        {
+            PROFILE_STAGE(Profiler::Stage::RayGeneration);
+            r = get_ray(x, y, cam_pos, sampler, rate);
         }
 
-        return {0, 0, 0};
+        color += TracePath<K>(r, scene, sampler, record, out_primary);
     }
 
-    Vec3f dir_norm = Vec3f::normalize(ray.get_direction());
-    float a = 0.5f * (dir_norm.y + 1.0f);
-    return Utils::lerp({1.0f, 1.0f, 1.0f}, {0.5f, 0.7f, 1.0f}, a);
+    return color;
 }
 
-void Renderer::RenderBatch(uint32_t i_start, uint32_t count, const Vec3f& cam_pos, uint8_t* pixels, uint32_t width, const HittableList& objects) {
+template <typename B>
+void Renderer::RenderBatchKernel(uint32_t i_start, uint32_t count, const Vec3f& cam_pos, float* out_linear, uint32_t width, const CompiledScene& scene, Sampler& sampler, TileRecord* record, GBufferSample* out_gbuffer) {
+    using K = typename B::Pixel;
+
+    PROFILE_EVENT(Profiler::Stage::RenderBatch);
+
     for (uint32_t i = i_start; i < i_start + count; i++) {
         uint32_t y = i / width;
         uint32_t x = i - (y * width);
-
-        Vec3f color = {0.0f, 0.0f, 0.0f};
-        for (uint32_t i = 0; i < SAMPLES_PER_PIXEL; i++) {
-            Ray r = get_ray(x, y, cam_pos);
-            color += ShadePixel(r, objects, RAY_MAX_DEPTH);
+        GBufferSample* primary = K::GBUFFER ? out_gbuffer + (i - i_start) : nullptr;
+
+        Vec3f color;
+        if constexpr (B::SINGLE_SAMPLE) {
+            color = SamplePixelKernel<K>(x, y, 0, 1, cam_pos, scene, sampler, record, primary, 1);
+        } else {
+            color = SamplePixelKernel<K>(x, y, 0, samples_per_pixel, cam_pos, scene, sampler, record, primary, 1);
+            color /= (float)samples_per_pixel;
         }
-        color /= (float)SAMPLES_PER_PIXEL;
-
-        color.x = Utils::correct_gamma(color.x);
-        color.y = Utils::correct_gamma(color.y);
-        color.z = Utils::correct_gamma(color.z);
 
-        static const Interval intensity(0.0f, 1.0f);
-        pixels[i * 4 + 0] = (uint8_t)(intensity.Clamp(color.x) * 255.0f);
-        pixels[i * 4 + 1] = (uint8_t)(intensity.Clamp(color.y) * 255.0f);
-        pixels[i * 4 + 2] = (uint8_t)(intensity.Clamp(color.z) * 255.0f);
-        pixels[i * 4 + 3] = 255;
+        float* pixel = out_linear + (size_t)(i - i_start) * 4;
+        pixel[0] = color.x;
+        pixel[1] = color.y;
+        pixel[2] = color.z;
+        pixel[3] = 1.0f;
     }
 }
 
-void Renderer::CopyPixelsBatch(uint32_t i_start, uint32_t count, uint8_t* out_pixels) {
-    for (uint32_t i = i_start; i < i_start + count; i++) {
-        uint32_t y = i / full_width;
-        uint32_t x = i - (y * full_width);
+template <uint32_t... INDICES>
+constexpr std::array<Renderer::PixelKernel, sizeof...(INDICES)> Renderer::get_pixel_kernels(std::integer_sequence<uint32_t, INDICES...>) {
+    return {&Renderer::SamplePixelKernel<RenderKernel::Policy<INDICES>>...};
+}
 
-        uint32_t low_res_x = (uint32_t)(x * low_res_scale);
-        uint32_t low_res_y = (uint32_t)(y * low_res_scale);
-        uint32_t sample_index = low_res_y * low_res_width + low_res_x;
+template <uint32_t... INDICES>
+constexpr std::array<Renderer::BatchKernel, sizeof...(INDICES)> Renderer::get_batch_kernels(std::integer_sequence<uint32_t, INDICES...>) {
+    return {&Renderer::RenderBatchKernel<RenderKernel::BatchPolicy<INDICES>>...};
+}
 
-        memcpy(
-            &out_pixels[i * 4],
-            &low_res_pixels[sample_index * 4],
-            4
-        );
-    }
+const std::array<Renderer::PixelKernel, RenderKernel::PIXEL_KERNEL_COUNT> Renderer::pixel_kernels = get_pixel_kernels(std::make_integer_sequence<uint32_t, RenderKernel::PIXEL_KERNEL_COUNT>());
+const std::array<Renderer::BatchKernel, RenderKernel::BATCH_KERNEL_COUNT> Renderer::batch_kernels = get_batch_kernels(std::make_integer_sequence<uint32_t, RenderKernel::BATCH_KERNEL_COUNT>());
+
+static RenderKernel::Output get_kernel_output(bool has_record, bool has_gbuffer) {
+    assert(!(has_record && has_gbuffer));
+
+    if (has_gbuffer) return RenderKernel::Output::GBuffer;
+    if (has_record) return RenderKernel::Output::TileRecord;
+    return RenderKernel::Output::Radiance;
+}
+
+Vec3f Renderer::SamplePixel(uint32_t x, uint32_t y, uint32_t first_sample, uint32_t count, const Vec3f& cam_pos, const CompiledScene& scene, Sampler& sampler, TileRecord* record, GBufferSample* out_primary, uint32_t rate) {
+    RenderKernel::Output output = get_kernel_output(record != nullptr, out_primary != nullptr);
+    PixelKernel kernel = pixel_kernels[RenderKernel::get_pixel_kernel_index(render_preset, output)];
+    return (this->*kernel)(x, y, first_sample, count, cam_pos, scene, sampler, record, out_primary, rate);
+}
+
+void Renderer::RenderBatch(uint32_t i_start, uint32_t count, const Vec3f& cam_pos, float* out_linear, uint32_t width, const CompiledScene& scene, Sampler& sampler, TileRecord* record, GBufferSample* out_gbuffer) {
+    RenderKernel::Output output = get_kernel_output(record != nullptr, out_gbuffer != nullptr);
+    BatchKernel kernel = batch_kernels[RenderKernel::get_batch_kernel_index(render_preset, output, samples_per_pixel == 1)];
+    (this->*kernel)(i_start, count, cam_pos, out_linear, width, scene, sampler, record, out_gbuffer);
 }
 
-Ray Renderer::get_ray(uint32_t x, uint32_t y, const Vec3f& cam_pos) const {
-    float x_offset = Utils::randf_range(-0.5f, 0.5f);
-    float y_offset = Utils::randf_range(-0.5f, 0.5f);
+Ray Renderer::get_ray(uint32_t x, uint32_t y, const Vec3f& cam_pos, Sampler& sampler, uint32_t rate) const {
+    Sample2D jitter = sampler.Get2D();
+    float x_offset = jitter.x * (float)rate - 0.5f;
+    float y_offset = jitter.y * (float)rate - 0.5f;
 
     Vec3f frag_screen_pos = viewport_top_left +
                             (pixel_right * (x + x_offset)) +
                             (pixel_down * (y + y_offset));
-    Vec3f ray_dir = frag_screen_pos - cam_pos;
+    // unit length so every intersection test along the path takes
+    //   the fast path, scattered rays already come out unit length
+    Vec3f ray_dir = Vec3f::normalize(frag_screen_pos - cam_pos);
 
     return Ray(cam_pos, ray_dir);
 }
 
-void Renderer::RenderLowRes(uint8_t* pixels, const Camera& camera, const HittableList& objects) {
+void Renderer::RenderLowRes(uint8_t* pixels, const Camera& camera, const CompiledScene& scene) {
     Vec3f cam_pos = camera.get_position();
 
+    if (low_res_linear.empty()) {
+        low_res_linear.resize((size_t)low_res_width * low_res_height * 4);
+        low_res_gbuffer.resize((size_t)low_res_width * low_res_height);
+        upscaler = std::make_unique<Upscaler>(low_res_width, low_res_height, full_width, full_height, thread_pool.get_thread_count());
+    }
+
     UpdateVectors(camera, low_res_width, low_res_height);
 
     // send shading in grouped-together batches
     //   if we send them off all scattered then cache misses
     //   will cause serious performance hits
+    thread_pool.ParallelFor(
+        0,
+        low_res_width * low_res_height,
+        &low_res_grain,
+        [&](uint32_t pixel_index_start, uint32_t pixel_index_end, uint32_t thread_index) {
+            uint32_t count = pixel_index_end - pixel_index_start;
+            // the edge aware filter needs the G-buffer, which the kernel
+            //   fills in from the primary hits it already traces
+            GBufferSample* gbuffer = upscale_filter == UpscaleFilter::EdgeAware ? low_res_gbuffer.data() + pixel_index_start : nullptr;
+            RenderBatch(pixel_index_start, count, cam_pos, low_res_linear.data() + (size_t)pixel_index_start * 4, low_res_width, scene, *samplers[thread_index], nullptr, gbuffer);
+        }
+    );
 
-    uint32_t pixel_index_start = 0;
-    uint32_t pixels_remaining = low_res_width * low_res_height;
+    UpscaleLowRes(pixels);
+}
 
-    for (uint32_t i = 0; i < thread_pool.get_thread_count(); i++) {
-        uint32_t count = low_res_width * low_res_height / thread_pool.get_thread_count();
-        if (count > pixels_remaining) count = pixels_remaining;
+void Renderer::UpscaleLowRes(uint8_t* pixels) {
+    // if we're in low res mode we render to the lower
+    //   res array and upscale it into the output using
+    //   the thread pool when we're done, whole rows at a time.
+    //   filtering runs on linear radiance and the resolve happens
+    //   per output row, blending sRGB bytes would darken edges
+    const GBufferSample* gbuffer = upscale_filter == UpscaleFilter::EdgeAware ? low_res_gbuffer.data() : nullptr;
+
+    thread_pool.ParallelFor(0, full_height, &upscale_grain, [&](uint32_t y_start, uint32_t y_end, uint32_t thread_index) {
+        upscaler->UpscaleRows(low_res_linear.data(), gbuffer, upscale_filter, resolve_settings, y_start, y_end, thread_index, pixels);
+    });
+}
 
-        thread_pool.QueueJob(
-            [this, pixel_index_start, count, &cam_pos, &objects](uint32_t thread_index) {
-                RenderBatch(pixel_index_start, count, cam_pos, low_res_pixels, low_res_width, objects);
+void Renderer::RenderInterleavedRows(uint32_t y_start, uint32_t y_end, const Vec3f& cam_pos, const Vec3f& forward, const CompiledScene& scene, Sampler& sampler) {
+    PROFILE_EVENT(Profiler::Stage::RenderBatch);
+
+    for (uint32_t y = y_start; y < y_end; y++) {
+        uint32_t x_first;
+        uint32_t x_step;
+        if (!Interleave::get_row_pattern(interleave_mode, interleave_phase, y, &x_first, &x_step)) continue;
+
+        for (uint32_t x = x_first; x < full_width; x += x_step) {
+            size_t i = (size_t)y * full_width + x;
+
+            GBufferSample primary;
+            Vec3f color = SamplePixel(x, y, 0, samples_per_pixel, cam_pos, scene, sampler, nullptr, &primary);
+            color /= (float)samples_per_pixel;
+            float* pixel = linear_pixels.data() + i * 4;
+            pixel[0] = color.x;
+            pixel[1] = color.y;
+            pixel[2] = color.z;
+            pixel[3] = 1.0f;
+
+            // depth along the view direction, for working out where the
+            //   neighbours this frame skips were in the last one. from
+            //   the samples' own primary hits, t is the distance along a
+            //   unit camera ray within a pixel of the centre one
+            if (primary.depth == GBUFFER_MISS_DEPTH) {
+                interleave_depth[i] = INFINITY_F;
+            } else {
+                Vec3f ray_dir = Vec3f::normalize(viewport_top_left + pixel_right * (float)x + pixel_down * (float)y - cam_pos);
+                interleave_depth[i] = primary.depth * Vec3f::dot(ray_dir, forward);
             }
-        );
+        }
+    }
+}
 
-        pixel_index_start += count;
-        pixels_remaining -= count;
+// bilinear sample of a linear RGBA image at pixel coordinates x, y,
+//   false if that's off the image
+static bool sample_linear(const float* linear, uint32_t width, uint32_t height, float x, float y, Vec3f* out_color) {
+    if (!(x >= 0.0f && y >= 0.0f && x <= (float)(width - 1) && y <= (float)(height - 1))) return false;
+
+    uint32_t x0 = (uint32_t)x;
+    uint32_t y0 = (uint32_t)y;
+    uint32_t x1 = std::min(x0 + 1, width - 1);
+    uint32_t y1 = std::min(y0 + 1, height - 1);
+    float fx = x - (float)x0;
+    float fy = y - (float)y0;
+
+    const float* p00 = linear + ((size_t)y0 * width + x0) * 4;
+    const float* p10 = linear + ((size_t)y0 * width + x1) * 4;
+    const float* p01 = linear + ((size_t)y1 * width + x0) * 4;
+    const float* p11 = linear + ((size_t)y1 * width + x1) * 4;
+    Vec3f top = Vec3f(p00[0], p00[1], p00[2]) * (1.0f - fx) + Vec3f(p10[0], p10[1], p10[2]) * fx;
+    Vec3f bottom = Vec3f(p01[0], p01[1], p01[2]) * (1.0f - fx) + Vec3f(p11[0], p11[1], p11[2]) * fx;
+    *out_color = top * (1.0f - fy) + bottom * fy;
+    return true;
+}
+
+void Renderer::ReconstructRows(uint32_t y_start, uint32_t y_end, const Vec3f& cam_pos, const Vec3f& forward, const TileView* previous) {
+    PROFILE_EVENT(Profiler::Stage::Reconstruct);
+
+    float* linear = linear_pixels.data();
+    const float* history = interleave_history.data();
+    for (uint32_t y = y_start; y < y_end; y++) {
+        for (uint32_t x = 0; x < full_width; x++) {
+            if (Interleave::is_shaded(interleave_mode, interleave_phase, x, y)) continue;
+
+            Vec3f ray_dir = viewport_top_left + pixel_right * (float)x + pixel_down * (float)y - cam_pos;
+            float dir_depth = Vec3f::dot(ray_dir, forward);
+
+            // every skipped pixel has a shaded one somewhere in its 3x3
+            //   neighbourhood in both patterns
+            Vec3f sum(0.0f, 0.0f, 0.0f);
+            Vec3f sum_squares(0.0f, 0.0f, 0.0f);
+            Vec3f best_history;
+            float best_error = INFINITY_F;
+            uint32_t count = 0;
+            for (uint32_t ny = y == 0 ? 0 : y - 1; ny <= std::min(y + 1, full_height - 1); ny++) {
+                for (uint32_t nx = x == 0 ? 0 : x - 1; nx <= std::min(x + 1, full_width - 1); nx++) {
+                    if (!Interleave::is_shaded(interleave_mode, interleave_phase, nx, ny)) continue;
+
+                    size_t n = (size_t)ny * full_width + nx;
+                    Vec3f neighbour(linear[n * 4], linear[n * 4 + 1], linear[n * 4 + 2]);
+                    sum += neighbour;
+                    sum_squares += neighbour * neighbour;
+                    count++;
+
+                    if (previous == nullptr) continue;
+
+                    // guess the pixel is on the same surface as this
+                    //   neighbour and see where that was last frame. the
+                    //   guess whose history looks most like its neighbour
+                    //   wins, so silhouettes don't smear onto the background
+                    float depth = interleave_depth[n];
+                    Vec3f direction = depth == INFINITY_F ? ray_dir : cam_pos + ray_dir * (depth / dir_depth) - previous->cam_pos;
+                    float history_x;
+                    float history_y;
+                    Vec3f history_color;
+                    if (!previous->ProjectDirection(direction, &history_x, &history_y)) continue;
+                    if (!sample_linear(history, full_width, full_height, history_x, history_y, &history_color)) continue;
+
+                    float error = Vec3f::length_sq(history_color - neighbour);
+                    if (error < best_error) {
+                        best_error = error;
+                        best_history = history_color;
+                    }
+                }
+            }
+
+            // whatever the last frame had there, as long as it's within a
+            //   standard deviation of the neighbours. anything that was
+            //   hidden or moved since gets pulled back towards them, and
+            //   a silhouette's mix of both sides stays a mix
+            Vec3f mean = sum / (float)count;
+            Vec3f color = mean;
+            if (best_error != INFINITY_F) {
+                Vec3f variance = sum_squares / (float)count - mean * mean;
+                Vec3f deviation(
+                    std::sqrt(std::max(variance.x, 0.0f)),
+                    std::sqrt(std::max(variance.y, 0.0f)),
+                    std::sqrt(std::max(variance.z, 0.0f))
+                );
+                color = Vec3f::min(Vec3f::max(best_history, mean - deviation), mean + deviation);
+            }
+
+            float* pixel = linear + ((size_t)y * full_width + x) * 4;
+            pixel[0] = color.x;
+            pixel[1] = color.y;
+            pixel[2] = color.z;
+            pixel[3] = 1.0f;
+        }
     }
+}
 
-    thread_pool.Wait();
+void Renderer::RenderInterleaved(uint8_t* pixels, const Camera& camera, const CompiledScene& scene) {
+    Vec3f cam_pos = camera.get_position();
+    Vec3f forward = camera.get_forward();
 
-    // if we're in low res mode we render to the lower
-    //   res array and copy over to the output using
-    //   the thread pool when we're done
+    EnsureTiles();
+    if (interleave_history.empty()) {
+        interleave_history.resize(linear_pixels.size());
+        interleave_depth.resize((size_t)full_width * full_height);
+    }
 
-    pixel_index_start = 0;
-    pixels_remaining = full_width * full_height;
+    // linear_pixels always holds the last frame seen from tile_view, full
+    //   res or interleaved. it becomes the history and the older buffer
+    //   gets overwritten, every pixel is either shaded or reconstructed
+    std::swap(linear_pixels, interleave_history);
+    TileView previous = tile_view;
+    bool has_previous = has_tile_view;
 
-    for (uint32_t i = 0; i < thread_pool.get_thread_count(); i++) {
-        uint32_t count = full_width * full_height / thread_pool.get_thread_count();
-        if (count > pixels_remaining) count = pixels_remaining;
+    UpdateVectors(camera, full_width, full_height);
+    SetTileView(camera);
+    interleave_phase = (interleave_phase + 1) % Interleave::get_phase_count(interleave_mode);
+
+    thread_pool.ParallelFor(0, full_height, &interleave_grain, [&](uint32_t y_start, uint32_t y_end, uint32_t thread_index) {
+        RenderInterleavedRows(y_start, y_end, cam_pos, forward, scene, *samplers[thread_index]);
+    });
+
+    // reconstruction reads the shaded rows either side
+    //   of its own, so it waits for all of them
+    thread_pool.ParallelFor(0, full_height, &reconstruct_grain, [&](uint32_t y_start, uint32_t y_end, uint32_t thread_index) {
+        ReconstructRows(y_start, y_end, cam_pos, forward, has_previous ? &previous : nullptr);
+
+        PROFILE_EVENT(Profiler::Stage::Resolve);
+        size_t i_start = (size_t)y_start * full_width;
+        Resolve::ResolvePixels(linear_pixels.data() + i_start * 4, (uint32_t)i_start, (y_end - y_start) * full_width, full_width, resolve_settings, pixels + i_start * 4);
+    });
+}
+
+void Renderer::RenderTile(uint32_t tile_index, const Vec3f& cam_pos, uint8_t* pixels, const CompiledScene& scene, Sampler& sampler, FrameArena* arena) {
+    TileRecord& record = tiles[tile_index];
+    record.Clear();
+    record.output_version = output_version;
+
+    uint32_t x_start = (tile_index % tiles_x) * TILE_SIZE;
+    uint32_t y_start = (tile_index / tiles_x) * TILE_SIZE;
+    uint32_t width = std::min(TILE_SIZE, full_width - x_start);
+    uint32_t y_end = std::min(y_start + TILE_SIZE, full_height);
+    float* tile_linear = linear_pixels.data() + ((size_t)y_start * full_width + x_start) * 4;
+
+    uint32_t rate = record.target_rate;
+    if (rate == ShadingRate::FULL_RATE) {
+        for (uint32_t y = y_start; y < y_end; y++) {
+            size_t pixel_index = (size_t)y * full_width + x_start;
+            RenderBatch((uint32_t)pixel_index, width, cam_pos, linear_pixels.data() + pixel_index * 4, full_width, scene, sampler, &record);
+        }
+
+        if (shading_rate_source == ShadingRateSource::Variance) {
+            record.target_rate = (uint8_t)ShadingRate::get_variance_rate(tile_linear, width, y_end - y_start, full_width);
+        }
+    } else {
+        // one shaded value per block, spread over the tile afterwards
+        uint32_t blocks_x = (width + rate - 1) / rate;
+        uint32_t blocks_y = (y_end - y_start + rate - 1) / rate;
+        float* blocks = arena->AllocateArray<float>((size_t)blocks_x * blocks_y * 4);
+        for (uint32_t by = 0; by < blocks_y; by++) {
+            for (uint32_t bx = 0; bx < blocks_x; bx++) {
+                Vec3f color = SamplePixel(x_start + bx * rate, y_start + by * rate, 0, samples_per_pixel, cam_pos, scene, sampler, &record, nullptr, rate);
+                color /= (float)samples_per_pixel;
+
+                float* block = blocks + (size_t)(by * blocks_x + bx) * 4;
+                block[0] = color.x;
+                block[1] = color.y;
+                block[2] = color.z;
+                block[3] = 1.0f;
+            }
+        }
+
+        if (shading_rate_source == ShadingRateSource::Variance) {
+            record.target_rate = (uint8_t)ShadingRate::get_variance_rate(blocks, blocks_x, blocks_y, blocks_x);
+        }
 
+        ShadingRate::FillTile(blocks, rate, width, y_end - y_start, upscale_filter == UpscaleFilter::Nearest, tile_linear, full_width);
+    }
+    record.shading_rate = (uint8_t)rate;
+
+    // resolved once the whole tile is shaded so the
+    //   linear rows are still warm in cache
+    PROFILE_EVENT(Profiler::Stage::Resolve);
+    for (uint32_t y = y_start; y < y_end; y++) {
+        size_t pixel_index = (size_t)y * full_width + x_start;
+        Resolve::ResolvePixels(linear_pixels.data() + pixel_index * 4, (uint32_t)pixel_index, width, full_width, resolve_settings, pixels + pixel_index * 4);
+    }
+}
+
+void Renderer::UpdateShadingRates() {
+    if (shading_rates_stale) {
+        float fovea_x = shading_rate_source == ShadingRateSource::Cursor ? focus_x : full_width * 0.5f;
+        float fovea_y = shading_rate_source == ShadingRateSource::Cursor ? focus_y : full_height * 0.5f;
+
+        for (uint32_t tile_index = 0; tile_index < tiles.size(); tile_index++) {
+            TileRecord& tile = tiles[tile_index];
+            uint32_t x_start = (tile_index % tiles_x) * TILE_SIZE;
+            uint32_t y_start = (tile_index / tiles_x) * TILE_SIZE;
+            uint32_t x_end = std::min(x_start + TILE_SIZE, full_width);
+            uint32_t y_end = std::min(y_start + TILE_SIZE, full_height);
+
+            switch (shading_rate_source) {
+                case ShadingRateSource::Off:
+                    tile.target_rate = ShadingRate::FULL_RATE;
+                    break;
+                case ShadingRateSource::Center:
+                case ShadingRateSource::Cursor:
+                    tile.target_rate = (uint8_t)ShadingRate::get_foveated_rate(x_start, y_start, x_end, y_end, fovea_x, fovea_y, full_height);
+                    break;
+                case ShadingRateSource::Variance:
+                    // whatever's there stands until the tile is shaded again
+                    //   and its own contrast says otherwise
+                    tile.target_rate = tile.shading_rate == 0 ? ShadingRate::COARSEST_RATE : tile.shading_rate;
+                    break;
+            }
+        }
+
+        shading_rates_stale = false;
+    }
+
+    for (TileRecord& tile : tiles) {
+        // nothing to measure yet, start coarse
+        if (shading_rate_source == ShadingRateSource::Variance && tile.shading_rate == 0) {
+            tile.target_rate = ShadingRate::COARSEST_RATE;
+        }
+
+        tile.dirty |= tile.shading_rate > tile.target_rate;
+    }
+}
+
+uint32_t Renderer::RenderDirtyTiles(uint8_t* pixels, const Camera& camera, const CompiledScene& scene, double budget_ms) {
+    auto frame_start = std::chrono::steady_clock::now();
+    auto deadline = frame_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(budget_ms));
+    bool has_deadline = budget_ms > 0.0;
+    Vec3f cam_pos = camera.get_position();
+
+    EnsureTiles();
+    UpdateVectors(camera, full_width, full_height);
+    SetTileView(camera);
+    UpdateShadingRates();
+
+    // walk on from where the last frame stopped so a full
+    //   invalidation still sweeps down the screen progressively
+    uint32_t tile_count = (uint32_t)tiles.size();
+    dirty_order.clear();
+    for (uint32_t i = 0; i < tile_count; i++) {
+        uint32_t tile_index = (next_tile + i) % tile_count;
+        if (tiles[tile_index].dirty) {
+            dirty_order.push_back(tile_index);
+        }
+    }
+
+    if (dirty_order.empty()) return 0;
+
+    // tiles are claimed strictly in order, so whatever's left when the
+    //   deadline hits is one unbroken run for the next frame to pick up.
+    //   shared through one pointer so the jobs' captures fit in a Job
+    struct {
+        std::atomic<uint32_t> next_claim;
+        std::atomic<uint64_t> shaded_ns;
+        std::atomic<uint64_t> shaded_blocks;
+    } claims = {0, 0, 0};
+    double fallback_ns_per_block = average_ns_per_block;
+
+    for (uint32_t i = 0; i < thread_pool.get_thread_count(); i++) {
         thread_pool.QueueJob(
-            [this, pixel_index_start, count, pixels](uint32_t thread_index) {
-                CopyPixelsBatch(pixel_index_start, count, pixels);
+            [this, &claims, has_deadline, deadline, fallback_ns_per_block, &cam_pos, &scene, pixels](uint32_t thread_index) {
+                // every thread gets one tile no matter what, so each frame
+                //   makes progress and fresh tiles get a measured cost
+                bool guaranteed = true;
+
+                while (true) {
+                    uint32_t claim = claims.next_claim.load(std::memory_order_relaxed);
+                    if (claim >= dirty_order.size()) return;
+
+                    TileRecord& tile = tiles[dirty_order[claim]];
+                    uint32_t blocks_per_side = (TILE_SIZE + tile.target_rate - 1) / tile.target_rate;
+                    uint32_t blocks = blocks_per_side * blocks_per_side;
+
+                    if (has_deadline && !guaranteed) {
+                        // untimed tiles go by what this frame's tiles cost so
+                        //   far, then by earlier frames. with nothing known at
+                        //   all the cost can't be predicted, so stop
+                        double ns_per_block = tile.ns_per_block;
+                        if (ns_per_block <= 0.0) {
+                            uint64_t shaded_blocks = claims.shaded_blocks.load(std::memory_order_relaxed);
+                            ns_per_block = shaded_blocks > 0
+                                ? (double)claims.shaded_ns.load(std::memory_order_relaxed) / (double)shaded_blocks
+                                : fallback_ns_per_block;
+                        }
+                        if (ns_per_block <= 0.0) return;
+
+                        auto predicted = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::nano>(ns_per_block * blocks));
+                        if (std::chrono::steady_clock::now() + predicted > deadline) return;
+                    }
+
+                    if (!claims.next_claim.compare_exchange_weak(claim, claim + 1, std::memory_order_relaxed)) continue;
+                    guaranteed = false;
+
+                    // nothing else touches tiles until Wait returns, edits
+                    //   only ever happen between frames
+                    tile.dirty = false;
+
+                    auto tile_start = std::chrono::steady_clock::now();
+                    RenderTile(dirty_order[claim], cam_pos, pixels, scene, *samplers[thread_index], &frame_arenas[thread_index]);
+                    uint64_t elapsed_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - tile_start).count();
+
+                    tile.ns_per_block = (float)elapsed_ns / (float)blocks;
+                    claims.shaded_ns += elapsed_ns;
+                    claims.shaded_blocks += blocks;
+                }
             }
         );
-
-        pixel_index_start += count;
-        pixels_remaining -= count;
     }
 
     thread_pool.Wait();
+
+    // wall clock of one block on one thread, the same units as the
+    //   tiles' own timings the scheduler compares against the deadline
+    if (claims.shaded_blocks > 0) {
+        double frame_ns_per_block = (double)claims.shaded_ns / (double)claims.shaded_blocks;
+        average_ns_per_block = average_ns_per_block == 0.0
+            ? frame_ns_per_block
+            : average_ns_per_block + (frame_ns_per_block - average_ns_per_block) * BLOCK_COST_SMOOTHING;
+    }
+
+    uint32_t rendered = std::min(claims.next_claim.load(), (uint32_t)dirty_order.size());
+    next_tile = rendered < dirty_order.size() ? dirty_order[rendered] : (dirty_order.back() + 1) % tile_count;
+    return rendered;
 }
 
-void Renderer::RenderFullRes(uint8_t* pixels, const Camera& camera, const HittableList& objects) {
+void Renderer::RenderFullRes(uint8_t* pixels, const Camera& camera, const CompiledScene& scene) {
+    // once every tile is clean frames cost nothing until an edit
+    RenderDirtyTiles(pixels, camera, scene, frame_budget_ms);
+}
+
+void Renderer::RenderPass(AccumulationBuffer* accumulation, const Camera& camera, const CompiledScene& scene) {
     Vec3f cam_pos = camera.get_position();
+    uint32_t samples = accumulation->get_samples_per_pass();
 
     UpdateVectors(camera, full_width, full_height);
 
-    // send shading in grouped-together batches
-    //   if we send them off all scattered then cache misses
-    //   will cause serious performance hits
+    // pixels never share sums so tiles can be handed out freely, the
+    //   order they finish in doesn't change any pixel's result
+    thread_pool.ParallelForTiles(
+        full_width,
+        full_height,
+        TILE_SIZE,
+        [&](uint32_t x_start, uint32_t y_start, uint32_t x_end, uint32_t y_end, uint32_t thread_index) {
+            PROFILE_EVENT(Profiler::Stage::RenderBatch);
+
+            Sampler& sampler = *samplers[thread_index];
+            for (uint32_t y = y_start; y < y_end; y++) {
+                for (uint32_t x = x_start; x < x_end; x++) {
+                    uint32_t pixel_index = y * full_width + x;
+                    uint32_t first_sample = accumulation->get_sample_count(pixel_index);
+                    Vec3f sum = SamplePixel(x, y, first_sample, samples, cam_pos, scene, sampler, nullptr);
+                    accumulation->AddSamples(pixel_index, sum, samples);
+                }
+            }
+        }
+    );
 
-    uint32_t pixel_index_start = scanline * full_width;
-    uint32_t pixels_remaining = full_width * SCANLINES_PER_FRAME;
+    accumulation->EndPass();
+}
 
-    for (uint32_t i = 0; i < thread_pool.get_thread_count(); i++) {
-        uint32_t count = full_width * full_height / thread_pool.get_thread_count();
-        if (count > pixels_remaining) count = pixels_remaining;
+void Renderer::RenderRegion(uint32_t x_start, uint32_t y_start, uint32_t width, uint32_t height, const Camera& camera, const CompiledScene& scene, float* out_sums) {
+    Vec3f cam_pos = camera.get_position();
 
-        thread_pool.QueueJob(
-            [this, pixel_index_start, count, &cam_pos, pixels, &objects](uint32_t thread_index) {
-                RenderBatch(pixel_index_start, count, cam_pos, pixels, full_width, objects);
+    UpdateVectors(camera, full_width, full_height);
+
+    // a row per chunk, regions are only a tile or so high
+    thread_pool.ParallelFor(y_start, y_start + height, 1, [&](uint32_t row_start, uint32_t row_end, uint32_t thread_index) {
+        PROFILE_EVENT(Profiler::Stage::RenderBatch);
+
+        for (uint32_t y = row_start; y < row_end; y++) {
+            float* row = out_sums + (size_t)(y - y_start) * width * 3;
+            for (uint32_t x = x_start; x < x_start + width; x++) {
+                Vec3f sum = SamplePixel(x, y, 0, samples_per_pixel, cam_pos, scene, *samplers[thread_index], nullptr);
+                row[(x - x_start) * 3 + 0] = sum.x;
+                row[(x - x_start) * 3 + 1] = sum.y;
+                row[(x - x_start) * 3 + 2] = sum.z;
             }
+        }
+    });
+}
+
+uint32_t Renderer::RenderDirty(uint8_t* pixels, const Camera& camera, const CompiledScene& scene) {
+    output_version++;
+    return RenderDirtyTiles(pixels, camera, scene, 0.0);
+}
+
+void Renderer::InvalidateAll() {
+    // the view changed, so their contrast says nothing anymore
+    for (TileRecord& tile : tiles) {
+        tile.dirty = true;
+        tile.shading_rate = 0;
+    }
+}
+
+void Renderer::InvalidateObject(uint32_t object_id) {
+    for (TileRecord& tile : tiles) {
+        tile.dirty |= tile.HasObject(object_id);
+    }
+}
+
+void Renderer::InvalidateMaterial(uint32_t material_index) {
+    for (TileRecord& tile : tiles) {
+        tile.dirty |= tile.HasMaterial(material_index);
+    }
+}
+
+void Renderer::InvalidateBounds(const Aabb& world_bounds) {
+    if (tiles.empty()) return;
+
+    if (!has_tile_view) {
+        InvalidateAll();
+        return;
+    }
+
+    // project all eight corners onto the full res image plane
+    float min_x = INFINITY_F;
+    float min_y = INFINITY_F;
+    float max_x = -INFINITY_F;
+    float max_y = -INFINITY_F;
+    for (uint32_t i = 0; i < 8; i++) {
+        Vec3f corner(
+            (i & 1) ? world_bounds.max.x : world_bounds.min.x,
+            (i & 2) ? world_bounds.max.y : world_bounds.min.y,
+            (i & 4) ? world_bounds.max.z : world_bounds.min.z
         );
 
-        pixel_index_start += count;
-        pixels_remaining -= count;
+        // anything reaching behind the camera can't be bounded
+        //   on screen, just give up and redo everything
+        float x;
+        float y;
+        if (!tile_view.ProjectDirection(corner - tile_view.cam_pos, &x, &y)) {
+            InvalidateAll();
+            return;
+        }
+
+        min_x = std::min(min_x, x);
+        min_y = std::min(min_y, y);
+        max_x = std::max(max_x, x);
+        max_y = std::max(max_y, y);
     }
 
-    thread_pool.Wait();
-    scanline += SCANLINES_PER_FRAME;
-    scanline %= full_height;
+    min_x -= FOOTPRINT_MARGIN;
+    min_y -= FOOTPRINT_MARGIN;
+    max_x += FOOTPRINT_MARGIN;
+    max_y += FOOTPRINT_MARGIN;
+    if (max_x < 0.0f || max_y < 0.0f || min_x >= full_width || min_y >= full_height) return;
+
+    uint32_t tile_x_start = (uint32_t)std::max(min_x, 0.0f) / TILE_SIZE;
+    uint32_t tile_y_start = (uint32_t)std::max(min_y, 0.0f) / TILE_SIZE;
+    uint32_t tile_x_end = std::min((uint32_t)max_x / TILE_SIZE, tiles_x - 1);
+    uint32_t tile_y_end = std::min((uint32_t)max_y / TILE_SIZE, tiles_y - 1);
+    for (uint32_t ty = tile_y_start; ty <= tile_y_end; ty++) {
+        for (uint32_t tx = tile_x_start; tx <= tile_x_end; tx++) {
+            tiles[ty * tiles_x + tx].dirty = true;
+        }
+    }
 }
 
-void Renderer::RenderFrame(uint8_t* pixels, const Camera& camera, const HittableList& objects) {
+uint32_t Renderer::GetDirtyTileCount() const {
+    if (tiles.empty()) return get_tile_count();
+
+    uint32_t count = 0;
+    for (const TileRecord& tile : tiles) {
+        count += tile.dirty;
+    }
+
+    return count;
+}
+
+void Renderer::CopyOutputTiles(uint64_t since_version, const uint8_t* src, uint8_t* dst) const {
+    for (uint32_t tile_index = 0; tile_index < tiles_x * tiles_y; tile_index++) {
+        uint64_t written = tiles.empty() ? 0 : tiles[tile_index].output_version;
+        written = std::max(written, full_output_version);
+        if (written <= since_version || written == output_version) continue;
+
+        uint32_t x_start = (tile_index % tiles_x) * TILE_SIZE;
+        uint32_t y_start = (tile_index / tiles_x) * TILE_SIZE;
+        uint32_t width = std::min(TILE_SIZE, full_width - x_start);
+        uint32_t y_end = std::min(y_start + TILE_SIZE, full_height);
+        for (uint32_t y = y_start; y < y_end; y++) {
+            size_t offset = ((size_t)y * full_width + x_start) * 4;
+            memcpy(dst + offset, src + offset, (size_t)width * 4);
+        }
+    }
+}
+
+void Renderer::RenderFrame(uint8_t* pixels, const Camera& camera, const CompiledScene& scene) {
+    PROFILE_EVENT(Profiler::Stage::Frame);
+
+#ifdef RTRT_STATS
+    auto start = std::chrono::steady_clock::now();
+#endif
+
+    // the last frame's jobs are all done, nothing points into these anymore
+    for (FrameArena& arena : frame_arenas) {
+        arena.Reset();
+    }
+
+    output_version++;
     if (low_res) {
-        RenderLowRes(pixels, camera, objects);
+        full_output_version = output_version;
+    }
+
+    if (low_res && interleave_mode != InterleaveMode::Off) {
+        RenderInterleaved(pixels, camera, scene);
+    } else if (low_res) {
+        RenderLowRes(pixels, camera, scene);
     } else {
-        RenderFullRes(pixels, camera, objects);
+        RenderFullRes(pixels, camera, scene);
+    }
+
+#ifdef RTRT_STATS
+    RayStats::EndFrame(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+#endif
+}
+
+void Renderer::ResolveFrame(uint8_t* pixels) {
+    output_version++;
+    full_output_version = output_version;
+
+    // low res frames resolve as part of the upscale
+    if (low_res && interleave_mode == InterleaveMode::Off && !low_res_linear.empty()) {
+        UpscaleLowRes(pixels);
+        return;
     }
+    if (linear_pixels.empty()) return;
+
+    // a tile's worth of rows per chunk
+    thread_pool.ParallelFor(0, full_height, TILE_SIZE, [&](uint32_t y_start, uint32_t y_end, uint32_t thread_index) {
+        PROFILE_EVENT(Profiler::Stage::Resolve);
+
+        size_t i_start = (size_t)y_start * full_width;
+        Resolve::ResolvePixels(linear_pixels.data() + i_start * 4, (uint32_t)i_start, (y_end - y_start) * full_width, full_width, resolve_settings, pixels + i_start * 4);
+    });
+}
+
+bool Renderer::RenderBands(
+    const Camera& camera,
+    const CompiledScene& scene,
+    uint32_t band_height,
+    const std::function<bool(const uint8_t* pixels, uint32_t y_start, uint32_t rows)>& write_band
+) {
+    Vec3f cam_pos = camera.get_position();
+
+    UpdateVectors(camera, full_width, full_height);
+
+    // one band renders while the other is being written
+    band_height = std::max(1u, std::min(band_height, full_height));
+    std::vector<uint8_t> bands[2];
+    bands[0].resize((size_t)full_width * band_height * 4);
+    bands[1].resize((size_t)full_width * band_height * 4);
+    std::vector<float, AlignedAllocator<float, CACHE_LINE_SIZE>> linear_bands[2];
+    linear_bands[0].resize((size_t)full_width * band_height * 4);
+    linear_bands[1].resize((size_t)full_width * band_height * 4);
+
+    // tile wide columns of the band as jobs so every
+    //   thread has work even on short bands
+    auto queue_band = [this, band_height, &bands, &linear_bands, &cam_pos, &scene](uint32_t band) {
+        uint32_t y_start = band * band_height;
+        uint32_t rows = std::min(band_height, full_height - y_start);
+        uint8_t* band_pixels = bands[band % 2].data();
+        float* band_linear = linear_bands[band % 2].data();
+
+        for (uint32_t x = 0; x < full_width; x += TILE_SIZE) {
+            uint32_t width = std::min(TILE_SIZE, full_width - x);
+            thread_pool.QueueJob(
+                [this, x, width, y_start, rows, band_pixels, band_linear, &cam_pos, &scene](uint32_t thread_index) {
+                    for (uint32_t row = 0; row < rows; row++) {
+                        size_t band_index = (size_t)row * full_width + x;
+                        RenderBatch((y_start + row) * full_width + x, width, cam_pos, band_linear + band_index * 4, full_width, scene, *samplers[thread_index]);
+                    }
+
+                    PROFILE_EVENT(Profiler::Stage::Resolve);
+                    for (uint32_t row = 0; row < rows; row++) {
+                        size_t band_index = (size_t)row * full_width + x;
+                        Resolve::ResolvePixels(band_linear + band_index * 4, (y_start + row) * full_width + x, width, full_width, resolve_settings, band_pixels + band_index * 4);
+                    }
+                }
+            );
+        }
+    };
+
+    uint32_t band_count = (full_height + band_height - 1) / band_height;
+    queue_band(0);
+    thread_pool.Wait();
+
+    for (uint32_t band = 0; band < band_count; band++) {
+        if (band + 1 < band_count) {
+            queue_band(band + 1);
+        }
+
+        uint32_t y_start = band * band_height;
+        bool written = write_band(bands[band % 2].data(), y_start, std::min(band_height, full_height - y_start));
+
+        // the next band's jobs point at locals, always let them finish
+        thread_pool.Wait();
+        if (!written) return false;
+    }
+
+    return true;
+}
+
+void Renderer::RenderImage(uint8_t* pixels, const Camera& camera, const CompiledScene& scene) {
+#ifdef RTRT_STATS
+    auto start = std::chrono::steady_clock::now();
+#endif
+
+    // tiles are small enough that threads stay balanced when some
+    //   parts of the image are much more expensive than others, and
+    //   rendering them as tiles leaves every tile's record up to date
+    InvalidateAll();
+    RenderDirty(pixels, camera, scene);
+
+#ifdef RTRT_STATS
+    RayStats::EndFrame(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+#endif
 }
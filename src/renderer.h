@@ -1,24 +1,134 @@
 #pragma once
 
-#include "materials/material.h"
+#include "samplers/sampler.h"
 #include "thread_pool.h"
 #include <stdint.h>
 #include "ray.h"
-#include "objects/hittable_list.h"
+#include "objects/compiled_scene.h"
 #include "camera.h"
+#include "accumulation_buffer.h"
+#include "resolve.h"
+#include "upscaler.h"
+#include "shading_rate.h"
+#include "interleave.h"
+#include "aligned_allocator.h"
+#include "frame_arena.h"
+#include "render_kernel.h"
+#include <vector>
+#include <array>
+#include <utility>
+#include <memory>
+#include <functional>
 
 class Renderer {
    private:
+    // what a tile's paths touched the last time it was rendered, object ids
+    //   and material indices are hashed into bitsets so a false positive
+    //   only costs re-rendering the tile
+    struct TileRecord {
+        static constexpr uint32_t OBJECT_WORDS = 4;
+        static constexpr uint32_t MATERIAL_WORDS = 4;
+
+        uint64_t object_bits[OBJECT_WORDS];
+        uint64_t material_bits[MATERIAL_WORDS];
+        bool dirty;
+        // block size the tile's pixels were shaded at, 0 once they no
+        //   longer match the view, and the one it should be shaded at
+        uint8_t shading_rate;
+        uint8_t target_rate;
+        // how long a block took the last time the tile was shaded,
+        //   0 until it has been
+        float ns_per_block;
+        // output version that last wrote the tile's pixels
+        uint64_t output_version;
+
+        void Clear();
+        void Add(uint32_t object_id, uint32_t material_index);
+        bool HasObject(uint32_t object_id) const;
+        bool HasMaterial(uint32_t material_index) const;
+    };
+
+    // full res camera linear_pixels were last rendered with, used to find
+    //   the screen footprint of edited bounds and to reproject the last
+    //   frame into an interleaved one
+    struct TileView {
+        Vec3f cam_pos;
+        Vec3f forward;
+        float focal_length;
+        Vec3f top_left;
+        Vec3f pixel_right;
+        Vec3f pixel_down;
+
+        // full res pixel coordinates of cam_pos + direction, pixel centres
+        //   at whole numbers. false if it's behind the camera
+        bool ProjectDirection(const Vec3f& direction, float* out_x, float* out_y) const;
+    };
+
     uint32_t full_width;
     uint32_t full_height;
     uint32_t low_res_width;
     uint32_t low_res_height;
     uint32_t writes_per_pixel;
-    uint8_t* low_res_pixels;
+    // only allocated once something is rendered in low res, the
+    //   upscaler filters it and resolves at output resolution
+    std::vector<float, AlignedAllocator<float, CACHE_LINE_SIZE>> low_res_linear;
+    // primary hits through each low res pixel's centre, guides the
+    //   edge aware upscale. only filled in when that filter is on
+    std::vector<GBufferSample> low_res_gbuffer;
     float low_res_scale;
     bool low_res;
-    uint32_t scanline;
+    std::unique_ptr<Upscaler> upscaler;
+    UpscaleFilter upscale_filter;
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    // created on first use so offline renders that stream bands never pay
+    //   for per tile records, until then every tile counts as dirty
+    std::vector<TileRecord> tiles;
+    // bumped by every call that writes an output buffer, and the last
+    //   version that wrote all of it at once. see CopyOutputTiles
+    uint64_t output_version;
+    uint64_t full_output_version;
+    // linear RGBA radiance of the full res image, tiles shade into this and
+    //   are then resolved into the output. created along with the tiles
+    std::vector<float, AlignedAllocator<float, CACHE_LINE_SIZE>> linear_pixels;
+    ResolveSettings resolve_settings;
+    // where the progressive full res pass picks up looking for dirty tiles
+    uint32_t next_tile;
+    // wall clock the full res pass gets per frame, and a running average
+    //   of what a block costs for tiles that haven't been timed yet
+    double frame_budget_ms;
+    double average_ns_per_block;
+    // dirty tiles in the order the scheduler hands them out,
+    //   kept around so frames don't allocate
+    std::vector<uint32_t> dirty_order;
+    ShadingRateSource shading_rate_source;
+    // in full res pixels, only used by ShadingRateSource::Cursor
+    float focus_x;
+    float focus_y;
+    // the foveated target rates need working out again
+    bool shading_rates_stale;
+    InterleaveMode interleave_mode;
+    uint32_t interleave_phase;
+    // the last frame's linear pixels while linear_pixels is being
+    //   rebuilt, and the depth along the view direction of this frame's
+    //   shaded pixels. both created on the first interleaved frame
+    std::vector<float, AlignedAllocator<float, CACHE_LINE_SIZE>> interleave_history;
+    std::vector<float> interleave_depth;
+    TileView tile_view;
+    bool has_tile_view;
+    uint32_t samples_per_pixel;
+    RenderPreset render_preset;
+    SamplerType sampler_type;
+    uint32_t sampler_seed;
     ThreadPool thread_pool;
+    std::vector<std::unique_ptr<Sampler>> samplers;
+    // per worker thread scratch memory, reset at the start of every frame
+    std::vector<FrameArena> frame_arenas;
+    // chunk sizes of the per frame ParallelFor loops
+    GrainSize low_res_grain;
+    GrainSize upscale_grain;
+    GrainSize interleave_grain;
+    GrainSize reconstruct_grain;
     Vec3f viewport_top_left;
     Vec3f viewport_right;
     Vec3f viewport_down;
@@ -26,27 +136,196 @@ class Renderer {
     Vec3f pixel_down;
 
     void UpdateVectors(const Camera& camera, uint32_t width, uint32_t height);
-    Vec3f ShadePixel(const Ray& ray, const HittableList& objects, uint32_t max_depth);
-    void RenderBatch(uint32_t i_start, uint32_t count, const Vec3f& cam_pos, uint8_t* pixels, uint32_t width, const HittableList& objects);
-    void CopyPixelsBatch(uint32_t i_start, uint32_t count, uint8_t* out_pixels);
+    void CreateSamplers();
+    void EnsureTiles();
+    void SetTileView(const Camera& camera);
+    // a path's radiance, bounces at most K::MAX_DEPTH times. K is one of
+    //   RenderKernel::Policy, record is only used with K::TILE_RECORD and
+    //   out_primary only with K::GBUFFER
+    template <typename K>
+    Vec3f TracePath(Ray ray, const CompiledScene& scene, Sampler& sampler, TileRecord* record, GBufferSample* out_primary);
+    // sum of count samples of one pixel starting at sample index first_sample
+    //   rate spreads the samples over the rate by rate block starting at x, y
+    template <typename K>
+    Vec3f SamplePixelKernel(uint32_t x, uint32_t y, uint32_t first_sample, uint32_t count, const Vec3f& cam_pos, const CompiledScene& scene, Sampler& sampler, TileRecord* record, GBufferSample* out_primary, uint32_t rate);
+    // B is one of RenderKernel::BatchPolicy
+    template <typename B>
+    void RenderBatchKernel(uint32_t i_start, uint32_t count, const Vec3f& cam_pos, float* out_linear, uint32_t width, const CompiledScene& scene, Sampler& sampler, TileRecord* record, GBufferSample* out_gbuffer);
+
+    // every instantiation of the two kernels, indexed by
+    //   RenderKernel::get_pixel_kernel_index and get_batch_kernel_index
+    using PixelKernel = Vec3f (Renderer::*)(uint32_t, uint32_t, uint32_t, uint32_t, const Vec3f&, const CompiledScene&, Sampler&, TileRecord*, GBufferSample*, uint32_t);
+    using BatchKernel = void (Renderer::*)(uint32_t, uint32_t, const Vec3f&, float*, uint32_t, const CompiledScene&, Sampler&, TileRecord*, GBufferSample*);
+    template <uint32_t... INDICES>
+    static constexpr std::array<PixelKernel, sizeof...(INDICES)> get_pixel_kernels(std::integer_sequence<uint32_t, INDICES...>);
+    template <uint32_t... INDICES>
+    static constexpr std::array<BatchKernel, sizeof...(INDICES)> get_batch_kernels(std::integer_sequence<uint32_t, INDICES...>);
+    static const std::array<PixelKernel, RenderKernel::PIXEL_KERNEL_COUNT> pixel_kernels;
+    static const std::array<BatchKernel, RenderKernel::BATCH_KERNEL_COUNT> batch_kernels;
 
-    Ray get_ray(uint32_t x, uint32_t y, const Vec3f& cam_pos) const;
+    // the preset's SamplePixelKernel, picked at runtime. out_primary gets
+    //   the last sample's primary hit when it isn't null. at most one of
+    //   record and out_primary can be given
+    Vec3f SamplePixel(uint32_t x, uint32_t y, uint32_t first_sample, uint32_t count, const Vec3f& cam_pos, const CompiledScene& scene, Sampler& sampler, TileRecord* record, GBufferSample* out_primary = nullptr, uint32_t rate = 1);
+    // renders count pixels starting at pixel index i_start of an image width
+    //   pixels wide as linear RGBA into out_linear, which points at the
+    //   batch's first pixel, with the kernel for the preset, sample count
+    //   and outputs. out_gbuffer also points at the batch's first pixel,
+    //   at most one of record and out_gbuffer can be given
+    void RenderBatch(uint32_t i_start, uint32_t count, const Vec3f& cam_pos, float* out_linear, uint32_t width, const CompiledScene& scene, Sampler& sampler, TileRecord* record = nullptr, GBufferSample* out_gbuffer = nullptr);
+    void RenderTile(uint32_t tile_index, const Vec3f& cam_pos, uint8_t* pixels, const CompiledScene& scene, Sampler& sampler, FrameArena* arena);
+    // shades dirty tiles until budget_ms of wall clock is nearly up, workers
+    //   only start a tile if it's predicted to finish in time and whatever
+    //   is left carries over to the next call. every thread shades at
+    //   least one tile, budget_ms <= 0 shades everything
+    uint32_t RenderDirtyTiles(uint8_t* pixels, const Camera& camera, const CompiledScene& scene, double budget_ms);
+    // refreshes the tiles' target rates and marks tiles shaded
+    //   coarser than their target as dirty
+    void UpdateShadingRates();
+    void UpscaleLowRes(uint8_t* pixels);
+    // shades this phase's pixels of rows [y_start, y_end) into linear_pixels
+    //   and interleave_depth
+    void RenderInterleavedRows(uint32_t y_start, uint32_t y_end, const Vec3f& cam_pos, const Vec3f& forward, const CompiledScene& scene, Sampler& sampler);
+    // fills in the pixels of rows [y_start, y_end) this phase skipped from
+    //   the last frame (seen from previous, null if there isn't one) and
+    //   their shaded neighbours
+    void ReconstructRows(uint32_t y_start, uint32_t y_end, const Vec3f& cam_pos, const Vec3f& forward, const TileView* previous);
 
-    void RenderLowRes(uint8_t* pixels, const Camera& camera, const HittableList& objects);
-    void RenderFullRes(uint8_t* pixels, const Camera& camera, const HittableList& objects);
+    Ray get_ray(uint32_t x, uint32_t y, const Vec3f& cam_pos, Sampler& sampler, uint32_t rate = 1) const;
+
+    void RenderLowRes(uint8_t* pixels, const Camera& camera, const CompiledScene& scene);
+    void RenderInterleaved(uint8_t* pixels, const Camera& camera, const CompiledScene& scene);
+    void RenderFullRes(uint8_t* pixels, const Camera& camera, const CompiledScene& scene);
 
    public:
-    Renderer(uint32_t width, uint32_t height, float low_res_scale);
-    ~Renderer();
+    // placement picks which cpus the render threads run on, see cpu_topology.h
+    Renderer(uint32_t width, uint32_t height, float low_res_scale, const ThreadPlacement& placement = ThreadPlacement());
 
     void set_low_res(bool low_res) {
-        // reset scanline when changing resolutions
+        // low res output covers the whole frame, so every
+        //   tile has to be redone when changing resolutions
         if (this->low_res != low_res) {
-            scanline = 0;
+            InvalidateAll();
         }
 
         this->low_res = low_res;
     }
 
-    void RenderFrame(uint8_t* pixels, const Camera& camera, const HittableList& objects);
+    // takes effect on the next pixels rendered, call ResolveFrame to
+    //   apply it to what's already there without re-rendering
+    void set_resolve_settings(const ResolveSettings& settings) { resolve_settings = settings; }
+    const ResolveSettings& get_resolve_settings() const { return resolve_settings; }
+
+    // also picks how variable rate blocks are filled, nearest repeats
+    //   them and the other filters interpolate
+    void set_upscale_filter(UpscaleFilter filter) { upscale_filter = filter; }
+    UpscaleFilter get_upscale_filter() const { return upscale_filter; }
+
+    // variable rate shading of full res tiles, see shading_rate.h. tiles
+    //   already shaded finer than they need are kept, tiles shaded coarser
+    //   are redone as soon as the rates change
+    void set_shading_rate_source(ShadingRateSource source) {
+        shading_rate_source = source;
+        shading_rates_stale = true;
+    }
+    ShadingRateSource get_shading_rate_source() const { return shading_rate_source; }
+
+    // wall clock each full res frame gets, including resolving its tiles.
+    //   frames stay near it no matter how expensive the scene is, slower
+    //   scenes just take more frames to clean up
+    void set_frame_budget_ms(double budget_ms) { frame_budget_ms = budget_ms; }
+    double get_frame_budget_ms() const { return frame_budget_ms; }
+
+    // what low res frames are replaced with, see interleave.h
+    void set_interleave_mode(InterleaveMode mode) { interleave_mode = mode; }
+    InterleaveMode get_interleave_mode() const { return interleave_mode; }
+    void set_focus(float x, float y) {
+        if (x != focus_x || y != focus_y) {
+            shading_rates_stale = true;
+        }
+
+        focus_x = x;
+        focus_y = y;
+    }
+
+    // which compiled kernels shade pixels, see render_kernel.h. the
+    //   image changes with it so everything is re-rendered
+    void set_render_preset(RenderPreset preset) {
+        if (render_preset != preset) {
+            InvalidateAll();
+        }
+
+        render_preset = preset;
+    }
+    RenderPreset get_render_preset() const { return render_preset; }
+
+    void set_sampler_type(SamplerType sampler_type);
+    SamplerType get_sampler_type() const { return sampler_type; }
+    // a different seed draws a different, independent set of samples
+    void set_sampler_seed(uint32_t seed);
+    uint32_t get_sampler_seed() const { return sampler_seed; }
+    void set_samples_per_pixel(uint32_t samples_per_pixel);
+    uint32_t get_samples_per_pixel() const { return samples_per_pixel; }
+    const ThreadPool& get_thread_pool() const { return thread_pool; }
+    ThreadPool& get_thread_pool() { return thread_pool; }
+
+    void RenderFrame(uint8_t* pixels, const Camera& camera, const CompiledScene& scene);
+
+    // re-resolves the last rendered linear pixels (full or low res,
+    //   whichever is active) into pixels with the current settings
+    void ResolveFrame(uint8_t* pixels);
+
+    // renders every full res pixel in one go rather than progressively,
+    //   used for offline/headless output
+    void RenderImage(uint8_t* pixels, const Camera& camera, const CompiledScene& scene);
+
+    // renders every dirty tile in one go, leaving clean tiles' pixels
+    //   alone. returns how many tiles were rendered
+    uint32_t RenderDirty(uint8_t* pixels, const Camera& camera, const CompiledScene& scene);
+
+    // scene edits only invalidate the tiles they can affect so everything
+    //   else keeps its finished pixels. to move something, invalidate its
+    //   object id (where it was, including reflections) and its new bounds
+    //   (where it's going, primary visibility only)
+    void InvalidateAll();
+    void InvalidateObject(uint32_t object_id);
+    void InvalidateMaterial(uint32_t material_index);
+    void InvalidateBounds(const Aabb& world_bounds);
+
+    uint32_t GetDirtyTileCount() const;
+    uint32_t get_tile_count() const { return tiles_x * tiles_y; }
+
+    // counts the calls that wrote an output buffer (RenderFrame,
+    //   ResolveFrame, RenderDirty), for keeping several of them in sync
+    uint64_t get_output_version() const { return output_version; }
+    // brings dst up to date after the latest call wrote into it. dst was
+    //   complete as of since_version, src has to be complete as of the
+    //   version before the latest. only the tiles written in between
+    //   are copied, nothing when the latest call wrote every pixel
+    void CopyOutputTiles(uint64_t since_version, const uint8_t* src, uint8_t* dst) const;
+
+    // adds the accumulation buffer's samples per pass to every pixel,
+    //   carrying on from each pixel's sample count so passes split across
+    //   runs (see AccumulationBuffer::ReadCheckpoint) draw the exact same
+    //   samples as one long run. samples_per_pixel should cover the total
+    //   over every pass, only sobol and the other progressive samplers
+    //   give the same samples when more passes are added later
+    void RenderPass(AccumulationBuffer* accumulation, const Camera& camera, const CompiledScene& scene);
+
+    // writes the rgb sum of samples_per_pixel samples for every pixel of
+    //   a width by height region of the full res image into out_sums, for
+    //   rendering part of a frame somewhere else (see distributed/worker.h)
+    void RenderRegion(uint32_t x_start, uint32_t y_start, uint32_t width, uint32_t height, const Camera& camera, const CompiledScene& scene, float* out_sums);
+
+    // offline rendering for images too big to hold in memory: renders the
+    //   full res image top to bottom in bands of band_height rows and hands
+    //   each finished band (RGBA, rows * width pixels) to write_band while
+    //   the next one renders. only two bands are ever allocated. stops and
+    //   returns false as soon as write_band does
+    bool RenderBands(
+        const Camera& camera,
+        const CompiledScene& scene,
+        uint32_t band_height,
+        const std::function<bool(const uint8_t* pixels, uint32_t y_start, uint32_t rows)>& write_band
+    );
 };
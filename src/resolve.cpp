@@ -0,0 +1,184 @@
+#include "resolve.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define RTRT_RESOLVE_SSE2
+#endif
+
+// linear [0, 1] in, sRGB out. 4096 entries keeps every step in the
+//   darks under one 8 bit code value
+constexpr uint32_t SRGB_LUT_SIZE = 4096;
+// table entries are 8.8 fixed point so dithering can
+//   pick the rounding before the low byte is dropped
+constexpr uint32_t SRGB_LUT_FRACTION_BITS = 8;
+constexpr uint32_t ROUND_TO_NEAREST = 1 << (SRGB_LUT_FRACTION_BITS - 1);
+
+constexpr float ACES_A = 2.51f;
+constexpr float ACES_B = 0.03f;
+constexpr float ACES_C = 2.43f;
+constexpr float ACES_D = 0.59f;
+constexpr float ACES_E = 0.14f;
+
+constexpr uint8_t BAYER_4X4[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5}
+};
+
+struct SrgbLut {
+    uint16_t values[SRGB_LUT_SIZE];
+
+    SrgbLut() {
+        for (uint32_t i = 0; i < SRGB_LUT_SIZE; i++) {
+            float linear = (float)i / (SRGB_LUT_SIZE - 1);
+            float encoded = linear <= 0.0031308f
+                                ? linear * 12.92f
+                                : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+            values[i] = (uint16_t)std::lround(encoded * 255.0f * (1 << SRGB_LUT_FRACTION_BITS));
+        }
+    }
+};
+
+static const SrgbLut& get_srgb_lut() {
+    static const SrgbLut lut;
+    return lut;
+}
+
+// what gets added before dropping the fraction, ordered dither spreads
+//   it over the whole step instead of always rounding to nearest
+static uint32_t get_rounding(const ResolveSettings& settings, uint32_t x, uint32_t y) {
+    if (!settings.dither) return ROUND_TO_NEAREST;
+    return BAYER_4X4[y & 3][x & 3] * 16 + 8;
+}
+
+static uint8_t encode(const SrgbLut& lut, uint32_t index, uint32_t rounding) {
+    return (uint8_t)((lut.values[index] + rounding) >> SRGB_LUT_FRACTION_BITS);
+}
+
+// comparisons written to match _mm_max_ps/_mm_min_ps exactly, NaN goes to 0
+static float tone_map_scalar(float v, const ResolveSettings& settings) {
+    v *= settings.exposure;
+    if (settings.tone_map == ToneMap::Reinhard) {
+        v = v / (1.0f + v);
+    } else if (settings.tone_map == ToneMap::Aces) {
+        v = (v * (ACES_A * v + ACES_B)) / (v * (ACES_C * v + ACES_D) + ACES_E);
+    }
+
+    v = v > 0.0f ? v : 0.0f;
+    v = v < 1.0f ? v : 1.0f;
+    return v;
+}
+
+void Resolve::ResolvePixelsScalar(const float* linear, uint32_t i_start, uint32_t count, uint32_t width, const ResolveSettings& settings, uint8_t* out_pixels) {
+    const SrgbLut& lut = get_srgb_lut();
+
+    uint32_t y = i_start / width;
+    uint32_t x = i_start - y * width;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t rounding = get_rounding(settings, x, y);
+        for (uint32_t c = 0; c < 3; c++) {
+            float v = tone_map_scalar(linear[i * 4 + c], settings);
+            uint32_t index = (uint32_t)(v * (float)(SRGB_LUT_SIZE - 1) + 0.5f);
+            out_pixels[i * 4 + c] = encode(lut, index, rounding);
+        }
+        out_pixels[i * 4 + 3] = 255;
+
+        if (++x == width) {
+            x = 0;
+            y++;
+        }
+    }
+}
+
+#ifdef RTRT_RESOLVE_SSE2
+
+// one pixel per register since the framebuffer is RGBA, the curve and
+//   the lut index are computed for all channels at once and only the
+//   table reads are scalar (SSE2 has no gather)
+template <ToneMap Curve>
+static void resolve_sse2(const float* linear, uint32_t i_start, uint32_t count, uint32_t width, const ResolveSettings& settings, uint8_t* out_pixels) {
+    const SrgbLut& lut = get_srgb_lut();
+
+    const __m128 exposure = _mm_set1_ps(settings.exposure);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 lut_scale = _mm_set1_ps((float)(SRGB_LUT_SIZE - 1));
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    uint32_t y = i_start / width;
+    uint32_t x = i_start - y * width;
+    alignas(16) uint32_t indices[4];
+    for (uint32_t i = 0; i < count; i++) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(linear + (size_t)i * 4), exposure);
+        if constexpr (Curve == ToneMap::Reinhard) {
+            v = _mm_div_ps(v, _mm_add_ps(one, v));
+        } else if constexpr (Curve == ToneMap::Aces) {
+            __m128 numerator = _mm_mul_ps(v, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ACES_A), v), _mm_set1_ps(ACES_B)));
+            __m128 denominator = _mm_add_ps(_mm_mul_ps(v, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ACES_C), v), _mm_set1_ps(ACES_D))), _mm_set1_ps(ACES_E));
+            v = _mm_div_ps(numerator, denominator);
+        }
+        v = _mm_min_ps(_mm_max_ps(v, zero), one);
+        _mm_store_si128((__m128i*)indices, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, lut_scale), half)));
+
+        // x86 is little endian, so this lands as R, G, B, A in memory
+        uint32_t rounding = get_rounding(settings, x, y);
+        uint32_t packed = (uint32_t)encode(lut, indices[0], rounding) |
+                          ((uint32_t)encode(lut, indices[1], rounding) << 8) |
+                          ((uint32_t)encode(lut, indices[2], rounding) << 16) |
+                          (255u << 24);
+        memcpy(out_pixels + (size_t)i * 4, &packed, 4);
+
+        if (++x == width) {
+            x = 0;
+            y++;
+        }
+    }
+}
+
+#endif
+
+void Resolve::ResolvePixels(const float* linear, uint32_t i_start, uint32_t count, uint32_t width, const ResolveSettings& settings, uint8_t* out_pixels) {
+#ifdef RTRT_RESOLVE_SSE2
+    switch (settings.tone_map) {
+        case ToneMap::Clamp: resolve_sse2<ToneMap::Clamp>(linear, i_start, count, width, settings, out_pixels); return;
+        case ToneMap::Reinhard: resolve_sse2<ToneMap::Reinhard>(linear, i_start, count, width, settings, out_pixels); return;
+        case ToneMap::Aces: resolve_sse2<ToneMap::Aces>(linear, i_start, count, width, settings, out_pixels); return;
+    }
+#endif
+
+    ResolvePixelsScalar(linear, i_start, count, width, settings, out_pixels);
+}
+
+bool Resolve::is_simd() {
+#ifdef RTRT_RESOLVE_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char* Resolve::tone_map_name(ToneMap tone_map) {
+    switch (tone_map) {
+        case ToneMap::Clamp: return "clamp";
+        case ToneMap::Reinhard: return "reinhard";
+        case ToneMap::Aces: return "aces";
+    }
+
+    return "unknown";
+}
+
+bool Resolve::parse_tone_map(const char* name, ToneMap* out_tone_map) {
+    static const ToneMap tone_maps[] = {ToneMap::Clamp, ToneMap::Reinhard, ToneMap::Aces};
+    for (ToneMap tone_map : tone_maps) {
+        if (strcmp(name, tone_map_name(tone_map)) == 0) {
+            *out_tone_map = tone_map;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+// curve squeezing linear radiance into [0, 1] before encoding
+enum class ToneMap {
+    // no curve, anything brighter than 1 clips
+    Clamp,
+    Reinhard,
+    // Narkowicz's fit of the ACES filmic curve
+    Aces
+};
+
+struct ResolveSettings {
+    float exposure = 1.0f;
+    ToneMap tone_map = ToneMap::Clamp;
+    // 4x4 ordered dither before quantizing, hides banding in gradients
+    bool dither = false;
+};
+
+// turns the renderer's linear float framebuffer (RGBA, 4 floats per
+//   pixel) into displayable RGBA8: exposure, tone map, sRGB encode
+//   through a lookup table, then dither and quantize
+namespace Resolve {
+    // count pixels starting at pixel index i_start of an image width pixels
+    //   wide, linear and out_pixels point at the first pixel. the position
+    //   only picks the dither pattern so any split of an image resolves
+    //   to the same bytes
+    void ResolvePixels(const float* linear, uint32_t i_start, uint32_t count, uint32_t width, const ResolveSettings& settings, uint8_t* out_pixels);
+
+    // plain per channel version of ResolvePixels, same output
+    void ResolvePixelsScalar(const float* linear, uint32_t i_start, uint32_t count, uint32_t width, const ResolveSettings& settings, uint8_t* out_pixels);
+
+    bool is_simd();
+    const char* tone_map_name(ToneMap tone_map);
+    bool parse_tone_map(const char* name, ToneMap* out_tone_map);
+};
@@ -0,0 +1,125 @@
+#include "blue_noise.h"
+
+#include <vector>
+#include <cmath>
+#include "hash.h"
+
+constexpr uint32_t MASK_AREA = BlueNoise::MASK_SIZE * BlueNoise::MASK_SIZE;
+constexpr float SIGMA = 1.5f;
+
+// void-and-cluster (Ulichney 1993), energy of every pixel is the
+//   toroidally wrapped gaussian-filtered sum of all set pixels
+class VoidAndCluster {
+   private:
+    std::vector<float> kernel;
+    std::vector<float> energy;
+    std::vector<uint8_t> pattern;
+
+    void Toggle(uint32_t index, bool set) {
+        pattern[index] = set;
+        float sign = set ? 1.0f : -1.0f;
+
+        uint32_t px = index % BlueNoise::MASK_SIZE;
+        uint32_t py = index / BlueNoise::MASK_SIZE;
+        for (uint32_t y = 0; y < BlueNoise::MASK_SIZE; y++) {
+            uint32_t dy = (y - py) & (BlueNoise::MASK_SIZE - 1);
+            for (uint32_t x = 0; x < BlueNoise::MASK_SIZE; x++) {
+                uint32_t dx = (x - px) & (BlueNoise::MASK_SIZE - 1);
+                energy[y * BlueNoise::MASK_SIZE + x] += sign * kernel[dy * BlueNoise::MASK_SIZE + dx];
+            }
+        }
+    }
+
+    // tightest cluster is the set pixel with the highest energy,
+    //   largest void is the unset pixel with the lowest energy
+    uint32_t Find(bool tightest_cluster) const {
+        uint32_t best = 0;
+        float best_energy = tightest_cluster ? -INFINITY : INFINITY;
+        for (uint32_t i = 0; i < MASK_AREA; i++) {
+            if (pattern[i] != tightest_cluster) continue;
+            if (tightest_cluster ? energy[i] > best_energy : energy[i] < best_energy) {
+                best_energy = energy[i];
+                best = i;
+            }
+        }
+
+        return best;
+    }
+
+   public:
+    VoidAndCluster()
+      : kernel(MASK_AREA),
+        energy(MASK_AREA, 0.0f),
+        pattern(MASK_AREA, 0) {
+        for (uint32_t y = 0; y < BlueNoise::MASK_SIZE; y++) {
+            for (uint32_t x = 0; x < BlueNoise::MASK_SIZE; x++) {
+                // wrapped distance to the origin
+                float dx = (float)std::min(x, BlueNoise::MASK_SIZE - x);
+                float dy = (float)std::min(y, BlueNoise::MASK_SIZE - y);
+                kernel[y * BlueNoise::MASK_SIZE + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * SIGMA * SIGMA));
+            }
+        }
+    }
+
+    std::vector<float> Generate() {
+        std::vector<uint32_t> ranks(MASK_AREA);
+
+        // initial binary pattern: random ~10% of pixels, relaxed until
+        //   removing the tightest cluster creates the largest void
+        uint32_t initial_count = MASK_AREA / 10;
+        uint32_t state = 0x1234567u;
+        for (uint32_t placed = 0; placed < initial_count;) {
+            state = Hash::mix(state + 1);
+            uint32_t i = state % MASK_AREA;
+            if (!pattern[i]) {
+                Toggle(i, true);
+                placed++;
+            }
+        }
+
+        while (true) {
+            uint32_t cluster = Find(true);
+            Toggle(cluster, false);
+            uint32_t hole = Find(false);
+            Toggle(hole, true);
+            if (hole == cluster) break;
+        }
+
+        std::vector<uint8_t> initial_pattern = pattern;
+        std::vector<float> initial_energy = energy;
+
+        // phase 1: rank the initial points by removing tightest clusters
+        for (uint32_t rank = initial_count; rank > 0; rank--) {
+            uint32_t cluster = Find(true);
+            Toggle(cluster, false);
+            ranks[cluster] = rank - 1;
+        }
+
+        pattern = initial_pattern;
+        energy = initial_energy;
+
+        // phases 2 and 3: fill the largest voids until the mask is full
+        for (uint32_t rank = initial_count; rank < MASK_AREA; rank++) {
+            uint32_t hole = Find(false);
+            Toggle(hole, true);
+            ranks[hole] = rank;
+        }
+
+        std::vector<float> mask(MASK_AREA);
+        for (uint32_t i = 0; i < MASK_AREA; i++) {
+            mask[i] = (ranks[i] + 0.5f) / (float)MASK_AREA;
+        }
+
+        return mask;
+    }
+};
+
+const float* BlueNoise::get_mask() {
+    // function-local static so it's generated once and thread-safe
+    static const std::vector<float> mask = VoidAndCluster().Generate();
+    return mask.data();
+}
+
+float BlueNoise::sample(uint32_t x, uint32_t y) {
+    return get_mask()[(y % MASK_SIZE) * MASK_SIZE + (x % MASK_SIZE)];
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace BlueNoise {
+    constexpr uint32_t MASK_SIZE = 64;
+
+    // tileable MASK_SIZE x MASK_SIZE blue noise threshold mask with values
+    //   in [0, 1), generated once with the void-and-cluster method
+    const float* get_mask();
+
+    float sample(uint32_t x, uint32_t y);
+};
@@ -0,0 +1,41 @@
+#include "blue_noise_sampler.h"
+
+#include "hash.h"
+#include "sobol.h"
+#include "blue_noise.h"
+
+static float wrap(float x) {
+    return x >= 1.0f ? x - 1.0f : x;
+}
+
+BlueNoiseSampler::BlueNoiseSampler(uint32_t samples_per_pixel, uint32_t seed)
+  : Sampler(samples_per_pixel, seed) { }
+
+void BlueNoiseSampler::StartSample(uint32_t x, uint32_t y, uint32_t sample_index) {
+    Sampler::StartSample(x, y, sample_index);
+
+    // make sure the mask is built outside of the per-dimension path
+    BlueNoise::get_mask();
+}
+
+float BlueNoiseSampler::get_offset(uint32_t dim) const {
+    // every dimension reads the mask at a different random tile offset
+    //   so dimensions don't share the same dither pattern
+    uint32_t h = Hash::combine(seed, dim);
+    return BlueNoise::sample(pixel_x + (h & 0xffff), pixel_y + (h >> 16));
+}
+
+float BlueNoiseSampler::Get1D() {
+    float value = Sobol::sample_1d(sample_index, Hash::combine(seed, dimension));
+    float offset = get_offset(dimension);
+    dimension++;
+    return wrap(value + offset);
+}
+
+Sample2D BlueNoiseSampler::Get2D() {
+    Sample2D value = Sobol::sample_2d(sample_index, Hash::combine(seed, dimension));
+    float offset_x = get_offset(dimension);
+    float offset_y = get_offset(dimension + 1);
+    dimension += 2;
+    return {wrap(value.x + offset_x), wrap(value.y + offset_y)};
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "sampler.h"
+
+// every pixel uses the same owen-scrambled sobol sequence, toroidally
+//   shifted by a blue noise mask so that the remaining error is
+//   distributed as blue noise across the screen
+//   ("Blue-noise Dithered Sampling", Georgiev & Fajardo 2016)
+class BlueNoiseSampler : public Sampler {
+   private:
+    float get_offset(uint32_t dim) const;
+
+   public:
+    BlueNoiseSampler(uint32_t samples_per_pixel, uint32_t seed);
+
+    void StartSample(uint32_t x, uint32_t y, uint32_t sample_index) override;
+    float Get1D() override;
+    Sample2D Get2D() override;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// small stateless integer hashes used to decorrelate
+//   sample sequences between pixels and dimensions
+namespace Hash {
+    // "lowbias32" integer mixer by Chris Wellons
+    //   https://nullprogram.com/blog/2018/07/31/
+    inline uint32_t mix(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    inline uint32_t combine(uint32_t seed, uint32_t value) {
+        return mix(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+    }
+
+    // 64 bit FNV-1a over raw bytes, for names and file contents rather
+    //   than sample sequences. pass a previous result to keep going
+    inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+        }
+
+        return hash;
+    }
+
+    // maps the top 24 bits to a float in [0, 1)
+    inline float to_unit_float(uint32_t x) {
+        return (float)(x >> 8) * 0x1p-24f;
+    }
+};
@@ -0,0 +1,18 @@
+#include "independent_sampler.h"
+
+#include "hash.h"
+
+IndependentSampler::IndependentSampler(uint32_t samples_per_pixel, uint32_t seed)
+  : Sampler(samples_per_pixel, seed) { }
+
+float IndependentSampler::Get1D() {
+    uint32_t h = Hash::combine(Hash::combine(get_pixel_hash(), sample_index), dimension);
+    dimension++;
+    return Hash::to_unit_float(h);
+}
+
+Sample2D IndependentSampler::Get2D() {
+    uint32_t h = Hash::combine(Hash::combine(get_pixel_hash(), sample_index), dimension);
+    dimension += 2;
+    return {Hash::to_unit_float(h), Hash::to_unit_float(Hash::mix(h))};
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "sampler.h"
+
+// plain white noise, every dimension of every sample is
+//   an independent uniform random number
+class IndependentSampler : public Sampler {
+   public:
+    IndependentSampler(uint32_t samples_per_pixel, uint32_t seed);
+
+    float Get1D() override;
+    Sample2D Get2D() override;
+};
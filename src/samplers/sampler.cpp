@@ -0,0 +1,48 @@
+#include "sampler.h"
+
+#include "hash.h"
+#include "independent_sampler.h"
+#include "stratified_sampler.h"
+#include "sobol_sampler.h"
+#include "blue_noise_sampler.h"
+
+Sampler::Sampler(uint32_t samples_per_pixel, uint32_t seed)
+  : samples_per_pixel(samples_per_pixel),
+    seed(seed),
+    pixel_x(0),
+    pixel_y(0),
+    sample_index(0),
+    dimension(0) { }
+
+uint32_t Sampler::get_pixel_hash() const {
+    return Hash::combine(Hash::combine(seed, pixel_x), pixel_y);
+}
+
+void Sampler::StartSample(uint32_t x, uint32_t y, uint32_t sample_index) {
+    pixel_x = x;
+    pixel_y = y;
+    this->sample_index = sample_index;
+    dimension = 0;
+}
+
+std::unique_ptr<Sampler> create_sampler(SamplerType type, uint32_t samples_per_pixel, uint32_t seed) {
+    switch (type) {
+        case SamplerType::Independent: return std::make_unique<IndependentSampler>(samples_per_pixel, seed);
+        case SamplerType::Stratified: return std::make_unique<StratifiedSampler>(samples_per_pixel, seed);
+        case SamplerType::Sobol: return std::make_unique<SobolSampler>(samples_per_pixel, seed);
+        case SamplerType::BlueNoise: return std::make_unique<BlueNoiseSampler>(samples_per_pixel, seed);
+    }
+
+    return nullptr;
+}
+
+const char* sampler_type_name(SamplerType type) {
+    switch (type) {
+        case SamplerType::Independent: return "independent";
+        case SamplerType::Stratified: return "stratified";
+        case SamplerType::Sobol: return "sobol";
+        case SamplerType::BlueNoise: return "blue_noise";
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+
+struct Sample2D {
+    float x;
+    float y;
+};
+
+enum class SamplerType {
+    Independent,
+    Stratified,
+    Sobol,
+    BlueNoise
+};
+
+// generates sample values in [0, 1) for a single pixel sample at a time,
+//   every call to Get1D/Get2D consumes the next dimension(s) of the
+//   sample vector. one sampler instance is owned by each render thread
+class Sampler {
+   protected:
+    uint32_t samples_per_pixel;
+    uint32_t seed;
+    uint32_t pixel_x;
+    uint32_t pixel_y;
+    uint32_t sample_index;
+    uint32_t dimension;
+
+    uint32_t get_pixel_hash() const;
+
+   public:
+    Sampler(uint32_t samples_per_pixel, uint32_t seed);
+    virtual ~Sampler() = default;
+
+    virtual void StartSample(uint32_t x, uint32_t y, uint32_t sample_index);
+    virtual float Get1D() = 0;
+    virtual Sample2D Get2D() = 0;
+
+    uint32_t get_samples_per_pixel() const { return samples_per_pixel; }
+    uint32_t get_dimension() const { return dimension; }
+    void set_dimension(uint32_t dimension) { this->dimension = dimension; }
+};
+
+std::unique_ptr<Sampler> create_sampler(SamplerType type, uint32_t samples_per_pixel, uint32_t seed);
+const char* sampler_type_name(SamplerType type);
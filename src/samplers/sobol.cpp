@@ -0,0 +1,79 @@
+#include "sobol.h"
+
+#include <array>
+#include <algorithm>
+#include "hash.h"
+
+constexpr float ONE_MINUS_EPSILON = 0x1.fffffep-1f;
+
+// generator matrices as direction numbers, dimension 0 is the
+//   van der corput sequence and dimension 1 has all ones
+//   for its primitive polynomial (x + 1)
+static constexpr std::array<std::array<uint32_t, 32>, 2> make_directions() {
+    std::array<std::array<uint32_t, 32>, 2> directions {};
+
+    uint32_t v = 1u << 31;
+    for (uint32_t bit = 0; bit < 32; bit++) {
+        directions[0][bit] = 1u << (31 - bit);
+        directions[1][bit] = v;
+        v ^= v >> 1;
+    }
+
+    return directions;
+}
+
+static constexpr auto DIRECTIONS = make_directions();
+
+static uint32_t reverse_bits(uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+    x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+static uint32_t laine_karras_permutation(uint32_t x, uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+static float to_float(uint32_t x) {
+    return std::min((float)x * 0x1p-32f, ONE_MINUS_EPSILON);
+}
+
+uint32_t Sobol::sample(uint32_t index, uint32_t dim) {
+    uint32_t x = 0;
+    for (uint32_t bit = 0; index != 0; bit++, index >>= 1) {
+        // branchless select of the direction number
+        x ^= (0u - (index & 1u)) & DIRECTIONS[dim][bit];
+    }
+
+    return x;
+}
+
+uint32_t Sobol::nested_uniform_scramble(uint32_t x, uint32_t seed) {
+    x = reverse_bits(x);
+    x = laine_karras_permutation(x, seed);
+    return reverse_bits(x);
+}
+
+float Sobol::sample_1d(uint32_t index, uint32_t seed) {
+    uint32_t shuffled = nested_uniform_scramble(index, Hash::mix(seed));
+    uint32_t x = sample(shuffled, 0);
+    return to_float(nested_uniform_scramble(x, Hash::combine(seed, 1)));
+}
+
+Sample2D Sobol::sample_2d(uint32_t index, uint32_t seed) {
+    uint32_t shuffled = nested_uniform_scramble(index, Hash::mix(seed));
+    uint32_t x = sample(shuffled, 0);
+    uint32_t y = sample(shuffled, 1);
+
+    return {
+        to_float(nested_uniform_scramble(x, Hash::combine(seed, 1))),
+        to_float(nested_uniform_scramble(y, Hash::combine(seed, 2)))
+    };
+}
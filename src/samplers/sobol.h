@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+#include "sampler.h"
+
+// first two dimensions of the sobol sequence with hash-based owen
+//   scrambling, implementation follows "Practical Hash-based Owen
+//   Scrambling" (Burley 2020). higher dimensions are made by
+//   padding independently shuffled and scrambled 2D sets
+namespace Sobol {
+    uint32_t sample(uint32_t index, uint32_t dim);
+    uint32_t nested_uniform_scramble(uint32_t x, uint32_t seed);
+    float sample_1d(uint32_t index, uint32_t seed);
+    Sample2D sample_2d(uint32_t index, uint32_t seed);
+};
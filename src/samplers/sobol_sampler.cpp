@@ -0,0 +1,19 @@
+#include "sobol_sampler.h"
+
+#include "hash.h"
+#include "sobol.h"
+
+SobolSampler::SobolSampler(uint32_t samples_per_pixel, uint32_t seed)
+  : Sampler(samples_per_pixel, seed) { }
+
+float SobolSampler::Get1D() {
+    uint32_t dim_seed = Hash::combine(get_pixel_hash(), dimension);
+    dimension++;
+    return Sobol::sample_1d(sample_index, dim_seed);
+}
+
+Sample2D SobolSampler::Get2D() {
+    uint32_t dim_seed = Hash::combine(get_pixel_hash(), dimension);
+    dimension += 2;
+    return Sobol::sample_2d(sample_index, dim_seed);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "sampler.h"
+
+// padded owen-scrambled sobol, every pixel and every dimension
+//   pair gets its own scramble so the sequence stays decorrelated
+class SobolSampler : public Sampler {
+   public:
+    SobolSampler(uint32_t samples_per_pixel, uint32_t seed);
+
+    float Get1D() override;
+    Sample2D Get2D() override;
+};
@@ -0,0 +1,79 @@
+#include "stratified_sampler.h"
+
+#include <cmath>
+#include "hash.h"
+
+// random permutation of [0, l) without storing a table, from
+//   "Correlated Multi-Jittered Sampling" (Kensler 2013)
+static uint32_t permute(uint32_t i, uint32_t l, uint32_t p) {
+    uint32_t w = l - 1;
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+
+    do {
+        i ^= p;
+        i *= 0xe170893du;
+        i ^= p >> 16;
+        i ^= (i & w) >> 4;
+        i ^= p >> 8;
+        i *= 0x0929eb3fu;
+        i ^= p >> 23;
+        i ^= (i & w) >> 1;
+        i *= 1 | p >> 27;
+        i *= 0x6935fa69u;
+        i ^= (i & w) >> 11;
+        i *= 0x74dcb303u;
+        i ^= (i & w) >> 2;
+        i *= 0x9e501cc3u;
+        i ^= (i & w) >> 2;
+        i *= 0xc860a3dfu;
+        i &= w;
+        i ^= i >> 5;
+    } while (i >= l);
+
+    return (i + p) % l;
+}
+
+StratifiedSampler::StratifiedSampler(uint32_t samples_per_pixel, uint32_t seed)
+  : Sampler(samples_per_pixel, seed) {
+    // closest-to-square grid that doesn't exceed the sample count,
+    //   samples past the grid fall back to being plain jittered
+    strata_x = std::max(1u, (uint32_t)std::sqrt((float)samples_per_pixel));
+    strata_y = std::max(1u, samples_per_pixel / strata_x);
+}
+
+float StratifiedSampler::Get1D() {
+    uint32_t h = Hash::combine(Hash::combine(get_pixel_hash(), seed), dimension);
+    dimension++;
+
+    uint32_t count = std::max(1u, samples_per_pixel);
+    uint32_t stratum = permute(sample_index % count, count, h);
+    float jitter = Hash::to_unit_float(Hash::combine(h, sample_index));
+    return (stratum + jitter) / (float)count;
+}
+
+Sample2D StratifiedSampler::Get2D() {
+    uint32_t h = Hash::combine(Hash::combine(get_pixel_hash(), seed), dimension);
+    dimension += 2;
+
+    uint32_t count = strata_x * strata_y;
+    uint32_t jitter_hash = Hash::combine(h, sample_index);
+    float jitter_x = Hash::to_unit_float(jitter_hash);
+    float jitter_y = Hash::to_unit_float(Hash::mix(jitter_hash));
+
+    if (sample_index >= count) {
+        return {jitter_x, jitter_y};
+    }
+
+    uint32_t stratum = permute(sample_index, count, h);
+    uint32_t sx = stratum % strata_x;
+    uint32_t sy = stratum / strata_x;
+
+    return {
+        (sx + jitter_x) / (float)strata_x,
+        (sy + jitter_y) / (float)strata_y
+    };
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "sampler.h"
+
+// jittered stratification, every dimension is split into strata
+//   and the sample index is mapped to a stratum through a
+//   per-pixel, per-dimension random permutation
+class StratifiedSampler : public Sampler {
+   private:
+    uint32_t strata_x;
+    uint32_t strata_y;
+
+   public:
+    StratifiedSampler(uint32_t samples_per_pixel, uint32_t seed);
+
+    float Get1D() override;
+    Sample2D Get2D() override;
+};
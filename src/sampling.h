@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include "vec3.h"
+#include "math_utils.h"
+#include "samplers/sampler.h"
+
+// closed-form warps from the unit square to directions. everything
+//   here is branch free (selects instead of jumps) and only uses
+//   sqrt plus polynomial sin/cos so loops over it can be vectorized
+namespace Sampling {
+    // sin and cos of any angle, range reduced to [-pi/4, pi/4] and
+    //   evaluated with minimax polynomials (max error around 1e-7)
+    inline void fast_sincos(float x, float* out_sin, float* out_cos) {
+        constexpr float TWO_OVER_PI = 0.636619772f;
+        constexpr float PI_OVER_TWO_HI = 1.57079625f;
+        constexpr float PI_OVER_TWO_LO = 7.54978942e-8f;
+
+        float q = std::nearbyint(x * TWO_OVER_PI);
+        float r = (x - q * PI_OVER_TWO_HI) - q * PI_OVER_TWO_LO;
+        float r2 = r * r;
+
+        float s = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+        float c = 1.0f + r2 * (-0.5f + r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f)));
+
+        // rotate the result into the right quadrant
+        int32_t quadrant = (int32_t)q;
+        bool swap = quadrant & 1;
+        float sin_sign = (quadrant & 2) ? -1.0f : 1.0f;
+        float cos_sign = ((quadrant + 1) & 2) ? -1.0f : 1.0f;
+
+        *out_sin = (swap ? c : s) * sin_sign;
+        *out_cos = (swap ? s : c) * cos_sign;
+    }
+
+    // branchless orthonormal basis around a unit vector
+    //   ("Building an Orthonormal Basis, Revisited", Duff et al. 2017)
+    inline void build_basis(const Vec3f& n, Vec3f* out_tangent, Vec3f* out_bitangent) {
+        float sign = std::copysign(1.0f, n.z);
+        float a = -1.0f / (sign + n.z);
+        float b = n.x * n.y * a;
+        *out_tangent = Vec3f(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+        *out_bitangent = Vec3f(b, sign + n.y * n.y * a, -n.y);
+    }
+
+    inline Vec3f to_world(const Vec3f& local, const Vec3f& tangent, const Vec3f& bitangent, const Vec3f& normal) {
+        return tangent * local.x + bitangent * local.y + normal * local.z;
+    }
+
+    inline Vec3f to_local(const Vec3f& world, const Vec3f& tangent, const Vec3f& bitangent, const Vec3f& normal) {
+        return {Vec3f::dot(world, tangent), Vec3f::dot(world, bitangent), Vec3f::dot(world, normal)};
+    }
+
+    inline Vec3f sample_uniform_sphere(const Sample2D& u) {
+        float z = 1.0f - 2.0f * u.x;
+        float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+        float s, c;
+        fast_sincos(2.0f * Utils::PI * u.y, &s, &c);
+        return {r * c, r * s, z};
+    }
+
+    // shirley-chiu concentric mapping, keeps strata of the
+    //   square contiguous and undistorted on the disk
+    inline Sample2D sample_concentric_disk(const Sample2D& u) {
+        float a = 2.0f * u.x - 1.0f;
+        float b = 2.0f * u.y - 1.0f;
+
+        bool horizontal = std::fabs(a) > std::fabs(b);
+        float r = horizontal ? a : b;
+
+        // the denominators are kept non-zero, at the center
+        //   r is zero so the angle doesn't matter
+        float safe_a = a == 0.0f ? 1.0f : a;
+        float safe_b = b == 0.0f ? 1.0f : b;
+        float phi = horizontal
+                        ? (Utils::PI / 4.0f) * (b / safe_a)
+                        : (Utils::PI / 2.0f) - (Utils::PI / 4.0f) * (a / safe_b);
+
+        float s, c;
+        fast_sincos(phi, &s, &c);
+        return {r * c, r * s};
+    }
+
+    // cosine-weighted hemisphere around +z, pdf = cos(theta) / pi
+    inline Vec3f sample_cosine_hemisphere(const Sample2D& u) {
+        Sample2D d = sample_concentric_disk(u);
+        float z = std::sqrt(std::max(0.0f, 1.0f - d.x * d.x - d.y * d.y));
+        return {d.x, d.y, z};
+    }
+
+    // samples a GGX microfacet normal around +z from the distribution of
+    //   normals visible from view_local ("Sampling the GGX Distribution
+    //   of Visible Normals", Heitz 2018). view_local points away from
+    //   the surface and must be in the upper hemisphere
+    inline Vec3f sample_ggx_vndf(const Vec3f& view_local, float alpha, const Sample2D& u) {
+        // stretch the view so the problem becomes a hemisphere
+        Vec3f vh = Vec3f::normalize(Vec3f(alpha * view_local.x, alpha * view_local.y, view_local.z));
+
+        float len_sq = vh.x * vh.x + vh.y * vh.y;
+        float inv_len = len_sq > 0.0f ? 1.0f / std::sqrt(len_sq) : 0.0f;
+        Vec3f t1 = len_sq > 0.0f ? Vec3f(-vh.y * inv_len, vh.x * inv_len, 0.0f) : Vec3f(1.0f, 0.0f, 0.0f);
+        Vec3f t2 = Vec3f::cross(vh, t1);
+
+        // uniform point on the projected disk, warped towards the view
+        float r = std::sqrt(u.x);
+        float s, c;
+        fast_sincos(2.0f * Utils::PI * u.y, &s, &c);
+        float p1 = r * c;
+        float p2 = r * s;
+        float blend = 0.5f * (1.0f + vh.z);
+        p2 = (1.0f - blend) * std::sqrt(std::max(0.0f, 1.0f - p1 * p1)) + blend * p2;
+
+        Vec3f nh = t1 * p1 + t2 * p2 + vh * std::sqrt(std::max(0.0f, 1.0f - p1 * p1 - p2 * p2));
+
+        // unstretch back to the ellipsoid configuration
+        return Vec3f::normalize(Vec3f(alpha * nh.x, alpha * nh.y, std::max(0.0f, nh.z)));
+    }
+
+    // smith masking term for GGX, for a direction in the local frame
+    inline float ggx_smith_g1(const Vec3f& v_local, float alpha) {
+        float cos_sq = v_local.z * v_local.z;
+        float denom = v_local.z + std::sqrt(alpha * alpha * (1.0f - cos_sq) + cos_sq);
+        return denom > 0.0f ? (2.0f * v_local.z) / denom : 0.0f;
+    }
+};
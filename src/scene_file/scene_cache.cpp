@@ -0,0 +1,198 @@
+#include "scene_cache.h"
+
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <type_traits>
+#include "../aligned_allocator.h"
+
+// bump whenever anything in scene_data.h changes layout
+constexpr uint32_t CACHE_VERSION = 1;
+constexpr char CACHE_MAGIC[8] = {'R', 'T', 'R', 'T', 'S', 'C', 'N', '\0'};
+// reads back byte swapped on a machine with the other endianness
+constexpr uint32_t CACHE_BYTE_ORDER = 0x01020304;
+
+enum class CacheSection : uint32_t {
+    Materials,
+    WorldSpheres,
+    AssetSpheres,
+    Assets,
+    Instances,
+    Count
+};
+
+struct CacheSectionInfo {
+    uint64_t offset;
+    uint32_t count;
+    uint32_t element_size;
+};
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    SceneSourceStamp source;
+    SceneCamera camera;
+    CacheSectionInfo sections[(uint32_t)CacheSection::Count];
+};
+
+static_assert(std::is_trivially_copyable_v<MaterialRecord>);
+static_assert(std::is_trivially_copyable_v<SceneSphere>);
+static_assert(std::is_trivially_copyable_v<SceneAsset>);
+static_assert(std::is_trivially_copyable_v<SceneInstance>);
+static_assert(std::is_trivially_copyable_v<CacheHeader>);
+
+static uint64_t align_offset(uint64_t offset) {
+    return (offset + CACHE_LINE_SIZE - 1) & ~(uint64_t)(CACHE_LINE_SIZE - 1);
+}
+
+// points a span at a section inside the mapped file after checking it
+//   actually fits, a truncated file fails here. what's inside is checked
+//   by has_valid_indices
+template <typename T>
+static bool map_section(const MappedFile& file, const CacheHeader& header, CacheSection section, std::span<const T>* out_span) {
+    const CacheSectionInfo& info = header.sections[(uint32_t)section];
+    if (info.element_size != sizeof(T)) return false;
+    if (info.offset % CACHE_LINE_SIZE != 0) return false;
+    if (info.offset > file.get_size() || (file.get_size() - info.offset) / sizeof(T) < info.count) return false;
+
+    *out_span = std::span<const T>((const T*)(file.get_data() + info.offset), info.count);
+    return true;
+}
+
+// every index the scene's arrays hold into each other is in range, the
+//   loader uses them unchecked like it does parsed scenes'. a corrupt
+//   cache, or a stale one that happens to match the source's size and
+//   modified time, fails here instead of reading out of bounds
+static bool has_valid_indices(const SceneView& view) {
+    for (const SceneSphere& sphere : view.world_spheres) {
+        if (sphere.material_index >= view.materials.size()) return false;
+    }
+
+    for (const SceneSphere& sphere : view.asset_spheres) {
+        if (sphere.material_index >= view.materials.size()) return false;
+    }
+
+    for (const SceneAsset& asset : view.assets) {
+        if ((uint64_t)asset.first_sphere + asset.sphere_count > view.asset_spheres.size()) return false;
+    }
+
+    for (const SceneInstance& instance : view.instances) {
+        if (instance.asset_index >= view.assets.size()) return false;
+    }
+
+    return true;
+}
+
+bool SceneCache::Open(const char* path, const SceneSourceStamp& source, std::string* out_error) {
+    view = SceneView();
+    if (!file.Open(path, out_error)) return false;
+
+    auto fail = [this, out_error](const char* message) {
+        file.Close();
+        *out_error = message;
+        return false;
+    };
+
+    if (file.get_size() < sizeof(CacheHeader)) return fail("cache is truncated");
+
+    const CacheHeader& header = *(const CacheHeader*)file.get_data();
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) return fail("not a scene cache");
+    if (header.byte_order != CACHE_BYTE_ORDER) return fail("cache was written with a different byte order");
+    if (header.version != CACHE_VERSION) return fail("cache was written by a different version");
+    if (header.file_size != file.get_size()) return fail("cache is truncated");
+    if (header.source.size != source.size || header.source.modified_time != source.modified_time) {
+        return fail("cache is out of date");
+    }
+
+    view.camera = header.camera;
+    bool ok = map_section(file, header, CacheSection::Materials, &view.materials) &&
+              map_section(file, header, CacheSection::WorldSpheres, &view.world_spheres) &&
+              map_section(file, header, CacheSection::AssetSpheres, &view.asset_spheres) &&
+              map_section(file, header, CacheSection::Assets, &view.assets) &&
+              map_section(file, header, CacheSection::Instances, &view.instances);
+
+    if (!ok) {
+        view = SceneView();
+        return fail("cache sections don't match this build");
+    }
+
+    if (!has_valid_indices(view)) {
+        view = SceneView();
+        return fail("cache has out of range indices");
+    }
+
+    return true;
+}
+
+bool SceneCache::Write(const char* path, const SceneView& scene, const SceneSourceStamp& source, std::string* out_error) {
+    CacheHeader header;
+    // zeroed padding included so the same scene always
+    //   produces the exact same bytes
+    memset((void*)&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.byte_order = CACHE_BYTE_ORDER;
+    header.source = source;
+    header.camera = scene.camera;
+
+    struct SectionData {
+        const void* data;
+        uint64_t size;
+    };
+    SectionData sections[(uint32_t)CacheSection::Count];
+
+    auto add_section = [&header, &sections](CacheSection section, auto span) {
+        using T = typename decltype(span)::element_type;
+        header.sections[(uint32_t)section] = {0, (uint32_t)span.size(), (uint32_t)sizeof(T)};
+        sections[(uint32_t)section] = {span.data(), span.size_bytes()};
+    };
+
+    add_section(CacheSection::Materials, scene.materials);
+    add_section(CacheSection::WorldSpheres, scene.world_spheres);
+    add_section(CacheSection::AssetSpheres, scene.asset_spheres);
+    add_section(CacheSection::Assets, scene.assets);
+    add_section(CacheSection::Instances, scene.instances);
+
+    uint64_t offset = align_offset(sizeof(CacheHeader));
+    for (uint32_t i = 0; i < (uint32_t)CacheSection::Count; i++) {
+        header.sections[i].offset = offset;
+        offset = align_offset(offset + sections[i].size);
+    }
+    header.file_size = offset;
+
+    std::string temp_path = std::string(path) + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            *out_error = "couldn't write \"" + temp_path + "\"";
+            return false;
+        }
+
+        static const char padding[CACHE_LINE_SIZE] = {};
+        uint64_t written = sizeof(CacheHeader);
+        out.write((const char*)&header, sizeof(header));
+        for (uint32_t i = 0; i < (uint32_t)CacheSection::Count; i++) {
+            out.write(padding, header.sections[i].offset - written);
+            out.write((const char*)sections[i].data, sections[i].size);
+            written = header.sections[i].offset + sections[i].size;
+        }
+        out.write(padding, header.file_size - written);
+
+        if (!out) {
+            *out_error = "couldn't write \"" + temp_path + "\"";
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        *out_error = "couldn't move cache into place: " + error.message();
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <stdint.h>
+#include "scene_data.h"
+#include "../mapped_file.h"
+
+// identifies the text file a cache was made from, a cache
+//   is only used while both still match
+struct SceneSourceStamp {
+    uint64_t size;
+    int64_t modified_time;
+};
+
+// binary scene cache: a versioned header followed by every array of a
+//   SceneView exactly as it sits in memory, each aligned to a cache line.
+//   opening one maps the file and points the view straight into it so
+//   loading costs a few page faults no matter how big the scene is
+class SceneCache {
+   private:
+    MappedFile file;
+    SceneView view;
+
+   public:
+    SceneCache() = default;
+
+    // fails when the file is missing, was written by a different
+    //   version or layout, belongs to a different source file or has
+    //   indices that point outside its arrays
+    bool Open(const char* path, const SceneSourceStamp& source, std::string* out_error);
+
+    // the view stays valid for as long as this cache is open
+    const SceneView& get_view() const { return view; }
+
+    // writes to a temporary file first and renames it into place so a
+    //   reader never maps a half written cache
+    static bool Write(const char* path, const SceneView& scene, const SceneSourceStamp& source, std::string* out_error);
+};
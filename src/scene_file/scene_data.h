@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <stdint.h>
+#include "../vec3.h"
+#include "../transform.h"
+#include "../materials/material.h"
+
+// everything in here is plain old data with no pointers so a scene
+//   can be written out and mapped back in as-is, see scene_cache.h
+
+struct SceneCamera {
+    Vec3f position;
+    Vec3f look_at;
+    float focal_length;
+    float viewport_height;
+    uint32_t has_look_at;
+};
+
+struct SceneSphere {
+    Vec3f center;
+    float radius;
+    uint32_t material_index;
+};
+
+// a range of asset spheres that instances place in the world
+struct SceneAsset {
+    uint32_t first_sphere;
+    uint32_t sphere_count;
+};
+
+struct SceneInstance {
+    Transform transform;
+    uint32_t asset_index;
+};
+
+// non-owning view over a scene's arrays, either parsed SceneData
+//   or the inside of a mapped cache file
+struct SceneView {
+    SceneCamera camera;
+    std::span<const MaterialRecord> materials;
+    std::span<const SceneSphere> world_spheres;
+    std::span<const SceneSphere> asset_spheres;
+    std::span<const SceneAsset> assets;
+    std::span<const SceneInstance> instances;
+
+    // bytes taken up by the scene's arrays
+    size_t get_byte_size() const {
+        return materials.size_bytes() +
+               world_spheres.size_bytes() +
+               asset_spheres.size_bytes() +
+               assets.size_bytes() +
+               instances.size_bytes();
+    }
+};
+
+struct SceneData {
+    SceneCamera camera;
+    std::vector<MaterialRecord> materials;
+    std::vector<SceneSphere> world_spheres;
+    std::vector<SceneSphere> asset_spheres;
+    std::vector<SceneAsset> assets;
+    std::vector<SceneInstance> instances;
+
+    SceneView get_view() const {
+        return {camera, materials, world_spheres, asset_spheres, assets, instances};
+    }
+};
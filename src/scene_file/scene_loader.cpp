@@ -0,0 +1,141 @@
+#include "scene_loader.h"
+
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+#include <string_view>
+#include "scene_parser.h"
+#include "../mapped_file.h"
+#include "../objects/blas.h"
+#include "../materials/lambertian.h"
+#include "../materials/metal.h"
+
+static double get_ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool get_source_stamp(const char* path, SceneSourceStamp* out_stamp, std::string* out_error) {
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(path, error);
+    if (error) {
+        *out_error = std::string("couldn't open \"") + path + "\": " + error.message();
+        return false;
+    }
+
+    auto modified_time = std::filesystem::last_write_time(path, error);
+    if (error) {
+        *out_error = std::string("couldn't stat \"") + path + "\": " + error.message();
+        return false;
+    }
+
+    *out_stamp = {size, (int64_t)modified_time.time_since_epoch().count()};
+    return true;
+}
+
+std::string SceneFile::get_cache_path(const char* path) {
+    return std::string(path) + ".cache";
+}
+
+bool SceneFile::Load(const char* path, LoadedScene* out_scene, LoadReport* out_report, std::string* out_error) {
+    *out_report = {false, 0.0, 0.0, 0.0, ""};
+
+    SceneSourceStamp stamp;
+    if (!get_source_stamp(path, &stamp, out_error)) return false;
+
+    std::string cache_path = get_cache_path(path);
+
+    auto start = std::chrono::steady_clock::now();
+    if (out_scene->cache.Open(cache_path.c_str(), stamp, &out_report->cache_message)) {
+        out_scene->view = out_scene->cache.get_view();
+        out_report->from_cache = true;
+        out_report->cache_load_ms = get_ms_since(start);
+        return true;
+    }
+
+    start = std::chrono::steady_clock::now();
+    {
+        MappedFile source;
+        if (!source.Open(path, out_error)) return false;
+
+        std::string_view text((const char*)source.get_data(), source.get_size());
+        if (!Parse(text, path, &out_scene->data, out_error)) return false;
+    }
+    out_scene->view = out_scene->data.get_view();
+    out_report->parse_ms = get_ms_since(start);
+
+    start = std::chrono::steady_clock::now();
+    std::string write_error;
+    if (SceneCache::Write(cache_path.c_str(), out_scene->view, stamp, &write_error)) {
+        out_report->cache_message.clear();
+    } else {
+        out_report->cache_message = write_error;
+    }
+    out_report->cache_write_ms = get_ms_since(start);
+
+    return true;
+}
+
+static std::shared_ptr<Material> create_material(const MaterialRecord& record) {
+    if (record.type == MaterialType::Metal) {
+        return std::make_shared<Metal>(record.albedo, record.fuzz);
+    }
+
+    return std::make_shared<Lambertian>(record.albedo);
+}
+
+CompiledScene SceneFile::Compile(const SceneView& scene) {
+    SceneBuilder builder;
+
+    // materials go in first and in order so builder
+    //   indices are the scene file's indices
+    std::vector<std::shared_ptr<Material>> materials;
+    materials.reserve(scene.materials.size());
+    for (const MaterialRecord& record : scene.materials) {
+        materials.push_back(create_material(record));
+        builder.AddMaterial(materials.back());
+    }
+
+    builder.spheres.reserve(scene.world_spheres.size());
+    for (const SceneSphere& sphere : scene.world_spheres) {
+        builder.spheres.push_back({sphere.center, sphere.radius, sphere.material_index});
+    }
+
+    // each asset only carries the materials it actually uses
+    std::vector<std::shared_ptr<const Blas>> blases;
+    blases.reserve(scene.assets.size());
+    for (const SceneAsset& asset : scene.assets) {
+        std::unordered_map<uint32_t, uint32_t> local_indices;
+        std::vector<std::shared_ptr<Material>> asset_materials;
+        std::vector<SceneBuilder::SpherePrimitive> spheres;
+        spheres.reserve(asset.sphere_count);
+
+        for (uint32_t i = asset.first_sphere; i < asset.first_sphere + asset.sphere_count; i++) {
+            const SceneSphere& sphere = scene.asset_spheres[i];
+            auto it = local_indices.find(sphere.material_index);
+            if (it == local_indices.end()) {
+                it = local_indices.emplace(sphere.material_index, (uint32_t)asset_materials.size()).first;
+                asset_materials.push_back(materials[sphere.material_index]);
+            }
+
+            spheres.push_back({sphere.center, sphere.radius, it->second});
+        }
+
+        blases.push_back(std::make_shared<Blas>(spheres, asset_materials));
+    }
+
+    builder.instances.reserve(scene.instances.size());
+    for (const SceneInstance& instance : scene.instances) {
+        builder.AddInstance(blases[instance.asset_index], instance.transform);
+    }
+
+    return CompiledScene::Compile(builder);
+}
+
+Camera SceneFile::create_camera(const SceneView& scene, float aspect_ratio) {
+    Camera camera(scene.camera.position, aspect_ratio, scene.camera.focal_length, scene.camera.viewport_height);
+    if (scene.camera.has_look_at) {
+        camera.LookAt(scene.camera.look_at);
+    }
+
+    return camera;
+}
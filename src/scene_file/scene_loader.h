@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include "scene_data.h"
+#include "scene_cache.h"
+#include "../camera.h"
+#include "../objects/compiled_scene.h"
+
+namespace SceneFile {
+    // a loaded scene and whichever storage its view points into
+    struct LoadedScene {
+        SceneData data;
+        SceneCache cache;
+        SceneView view;
+    };
+
+    struct LoadReport {
+        bool from_cache;
+        double parse_ms;
+        double cache_write_ms;
+        double cache_load_ms;
+        // why the cache couldn't be used or written, empty if it was fine
+        std::string cache_message;
+    };
+
+    // the cache sits next to the scene file
+    std::string get_cache_path(const char* path);
+
+    // maps the cache next to the file if it's still up to date, otherwise
+    //   parses the text and writes a fresh cache for next time. a cache
+    //   that can't be written is reported but doesn't fail the load
+    bool Load(const char* path, LoadedScene* out_scene, LoadReport* out_report, std::string* out_error);
+
+    CompiledScene Compile(const SceneView& scene);
+    Camera create_camera(const SceneView& scene, float aspect_ratio);
+};
@@ -0,0 +1,314 @@
+#include "scene_parser.h"
+
+#include <charconv>
+#include <unordered_map>
+#include "../math_utils.h"
+#include "../samplers/hash.h"
+
+// matches Scenes::create_default_camera
+static SceneCamera get_default_camera() {
+    return {{0, 0, -5}, {0, 0, 0}, 1.0f, 2.0f, 0};
+}
+
+// walks the text one line at a time without copying anything
+class Tokenizer {
+   private:
+    const char* cursor;
+    const char* line_end;
+    const char* end;
+    uint32_t line;
+
+   public:
+    Tokenizer(std::string_view text)
+      : cursor(text.data()),
+        line_end(text.data()),
+        end(text.data() + text.size()),
+        line(0) { }
+
+    // moves to the start of the next line, false once there are none left
+    bool NextLine() {
+        if (line > 0) {
+            cursor = line_end < end ? line_end + 1 : end;
+        }
+        if (cursor >= end) return false;
+
+        line++;
+        line_end = cursor;
+        while (line_end < end && *line_end != '\n') line_end++;
+        return true;
+    }
+
+    // next token on the current line, empty once the line (or a comment) ends
+    std::string_view NextToken() {
+        while (cursor < line_end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) cursor++;
+        if (cursor >= line_end || *cursor == '#') return {};
+
+        const char* start = cursor;
+        while (cursor < line_end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r' && *cursor != '#') cursor++;
+        return std::string_view(start, cursor - start);
+    }
+
+    uint32_t get_line() const { return line; }
+};
+
+static uint64_t hash_name(std::string_view name) {
+    return Hash::fnv1a(name.data(), name.size());
+}
+
+static bool parse_float(std::string_view token, float* out_value) {
+    if (!token.empty() && token[0] == '+') token.remove_prefix(1);
+    if (token.empty()) return false;
+
+    auto result = std::from_chars(token.data(), token.data() + token.size(), *out_value);
+    return result.ec == std::errc() && result.ptr == token.data() + token.size();
+}
+
+// all the state for one parse, statements report errors through Fail
+class Parser {
+   private:
+    Tokenizer tokens;
+    const char* file_name;
+    SceneData* scene;
+    std::string* error;
+    // hashed names, a 64 bit hash colliding within one file isn't a concern
+    std::unordered_map<uint64_t, uint32_t> material_names;
+    std::unordered_map<uint64_t, uint32_t> asset_names;
+    bool in_asset;
+
+    bool Fail(std::string_view message) {
+        *error = std::string(file_name) + ":" + std::to_string(tokens.get_line()) + ": " + std::string(message);
+        return false;
+    }
+
+    bool ReadFloat(const char* what, float* out_value) {
+        std::string_view token = tokens.NextToken();
+        if (!parse_float(token, out_value)) {
+            return Fail(std::string("expected ") + what + ", got \"" + std::string(token) + "\"");
+        }
+
+        return true;
+    }
+
+    bool ReadVec3(const char* what, Vec3f* out_value) {
+        return ReadFloat(what, &out_value->x) && ReadFloat(what, &out_value->y) && ReadFloat(what, &out_value->z);
+    }
+
+    bool ReadName(const char* what, std::string_view* out_name) {
+        *out_name = tokens.NextToken();
+        if (out_name->empty()) {
+            return Fail(std::string("expected ") + what);
+        }
+
+        return true;
+    }
+
+    bool ExpectLineEnd() {
+        std::string_view extra = tokens.NextToken();
+        if (!extra.empty()) {
+            return Fail("unexpected \"" + std::string(extra) + "\"");
+        }
+
+        return true;
+    }
+
+    bool ParseCamera() {
+        SceneCamera& camera = scene->camera;
+        if (!ReadVec3("camera position", &camera.position)) return false;
+        if (!ReadFloat("focal length", &camera.focal_length)) return false;
+        if (!ReadFloat("viewport height", &camera.viewport_height)) return false;
+
+        std::string_view option = tokens.NextToken();
+        if (option == "look_at") {
+            if (!ReadVec3("look at position", &camera.look_at)) return false;
+            camera.has_look_at = 1;
+        } else if (!option.empty()) {
+            return Fail("unknown camera option \"" + std::string(option) + "\"");
+        }
+
+        return ExpectLineEnd();
+    }
+
+    bool ParseMaterial() {
+        std::string_view name;
+        if (!ReadName("material name", &name)) return false;
+
+        uint64_t hash = hash_name(name);
+        if (material_names.count(hash) > 0) {
+            return Fail("material \"" + std::string(name) + "\" is already defined");
+        }
+
+        MaterialRecord record = {{0, 0, 0}, 0.0f, MaterialType::Lambertian};
+        std::string_view type = tokens.NextToken();
+        if (type == "lambertian") {
+            if (!ReadVec3("albedo", &record.albedo)) return false;
+        } else if (type == "metal") {
+            record.type = MaterialType::Metal;
+            if (!ReadVec3("albedo", &record.albedo)) return false;
+            if (!ReadFloat("fuzz", &record.fuzz)) return false;
+            // same limit as the Metal constructor
+            record.fuzz = std::min(record.fuzz, 1.0f);
+        } else {
+            return Fail("unknown material type \"" + std::string(type) + "\"");
+        }
+
+        material_names[hash] = (uint32_t)scene->materials.size();
+        scene->materials.push_back(record);
+        return ExpectLineEnd();
+    }
+
+    bool ParseSphere() {
+        SceneSphere sphere;
+        if (!ReadVec3("sphere center", &sphere.center)) return false;
+        if (!ReadFloat("sphere radius", &sphere.radius)) return false;
+        // also catches NaN
+        if (!(sphere.radius > 0.0f)) {
+            return Fail("sphere radius has to be positive");
+        }
+
+        std::string_view material;
+        if (!ReadName("material name", &material)) return false;
+
+        auto it = material_names.find(hash_name(material));
+        if (it == material_names.end()) {
+            return Fail("unknown material \"" + std::string(material) + "\"");
+        }
+        sphere.material_index = it->second;
+
+        if (in_asset) {
+            scene->asset_spheres.push_back(sphere);
+            scene->assets.back().sphere_count++;
+        } else {
+            scene->world_spheres.push_back(sphere);
+        }
+
+        return ExpectLineEnd();
+    }
+
+    bool ParseAsset() {
+        if (in_asset) {
+            return Fail("assets can't be nested");
+        }
+
+        std::string_view name;
+        if (!ReadName("asset name", &name)) return false;
+
+        uint64_t hash = hash_name(name);
+        if (asset_names.count(hash) > 0) {
+            return Fail("asset \"" + std::string(name) + "\" is already defined");
+        }
+
+        asset_names[hash] = (uint32_t)scene->assets.size();
+        scene->assets.push_back({(uint32_t)scene->asset_spheres.size(), 0});
+        in_asset = true;
+        return ExpectLineEnd();
+    }
+
+    bool ParseEnd() {
+        if (!in_asset) {
+            return Fail("\"end\" without an asset");
+        }
+        if (scene->assets.back().sphere_count == 0) {
+            return Fail("asset has no spheres");
+        }
+
+        in_asset = false;
+        return ExpectLineEnd();
+    }
+
+    bool ParseInstance() {
+        if (in_asset) {
+            return Fail("assets can't contain instances");
+        }
+
+        std::string_view name;
+        if (!ReadName("asset name", &name)) return false;
+
+        auto it = asset_names.find(hash_name(name));
+        if (it == asset_names.end()) {
+            return Fail("unknown asset \"" + std::string(name) + "\"");
+        }
+
+        Vec3f position;
+        if (!ReadVec3("instance position", &position)) return false;
+
+        Transform rotation;
+        Transform scale;
+        for (std::string_view option = tokens.NextToken(); !option.empty(); option = tokens.NextToken()) {
+            if (option == "rotate") {
+                Vec3f axis;
+                float degrees;
+                if (!ReadVec3("rotation axis", &axis) || !ReadFloat("rotation angle", &degrees)) return false;
+                if (Vec3f::length_sq(axis) <= 0.0f) {
+                    return Fail("rotation axis can't be zero");
+                }
+
+                rotation = Transform::rotate(Vec3f::normalize(axis), degrees * Utils::PI / 180.0f);
+            } else if (option == "scale") {
+                Vec3f factors;
+                if (!ReadVec3("scale", &factors)) return false;
+                // a zero factor squashes the instance flat and leaves
+                //   no inverse to bring rays into object space
+                if (factors.x == 0.0f || factors.y == 0.0f || factors.z == 0.0f) {
+                    return Fail("scale can't be zero");
+                }
+
+                scale = Transform::scale(factors);
+            } else {
+                return Fail("unknown instance option \"" + std::string(option) + "\"");
+            }
+        }
+
+        scene->instances.push_back({Transform::translate(position) * rotation * scale, it->second});
+        return true;
+    }
+
+   public:
+    Parser(std::string_view text, const char* file_name, SceneData* scene, std::string* error)
+      : tokens(text),
+        file_name(file_name),
+        scene(scene),
+        error(error),
+        in_asset(false) { }
+
+    bool Run() {
+        *scene = SceneData();
+        scene->camera = get_default_camera();
+
+        while (tokens.NextLine()) {
+            std::string_view keyword = tokens.NextToken();
+            if (keyword.empty()) continue;
+
+            bool ok;
+            if (keyword == "sphere") {
+                ok = ParseSphere();
+            } else if (keyword == "material") {
+                ok = ParseMaterial();
+            } else if (keyword == "instance") {
+                ok = ParseInstance();
+            } else if (keyword == "asset") {
+                ok = ParseAsset();
+            } else if (keyword == "end") {
+                ok = ParseEnd();
+            } else if (keyword == "camera") {
+                ok = ParseCamera();
+            } else if (keyword == "mesh") {
+                ok = Fail("meshes aren't supported yet, only spheres");
+            } else {
+                ok = Fail("unknown statement \"" + std::string(keyword) + "\"");
+            }
+
+            if (!ok) return false;
+        }
+
+        if (in_asset) {
+            return Fail("asset is missing its \"end\"");
+        }
+
+        return true;
+    }
+};
+
+bool SceneFile::Parse(std::string_view text, const char* file_name, SceneData* out_scene, std::string* out_error) {
+    Parser parser(text, file_name, out_scene, out_error);
+    return parser.Run();
+}
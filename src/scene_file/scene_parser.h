@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "scene_data.h"
+
+// text scene format, one statement per line and "#" starts a comment:
+//
+//   camera <x y z> <focal length> <viewport height> [look_at <x y z>]
+//   material <name> lambertian <r g b>
+//   material <name> metal <r g b> <fuzz>
+//   sphere <x y z> <radius> <material>
+//   asset <name>
+//       sphere ...
+//   end
+//   instance <asset> <x y z> [rotate <axis x y z> <degrees>] [scale <x y z>]
+//
+// names have to be defined before they're used. triangle meshes
+//   aren't supported since there's no triangle primitive yet
+namespace SceneFile {
+    // parses straight out of the given text, tokens are views into it so
+    //   nothing is allocated per line or token, only the output arrays
+    //   and the name tables grow. errors are "name:line: message"
+    bool Parse(std::string_view text, const char* file_name, SceneData* out_scene, std::string* out_error);
+};
@@ -0,0 +1,110 @@
+#include "scenes.h"
+
+#include <memory>
+#include <cmath>
+#include "objects/sphere.h"
+#include "objects/instance.h"
+#include "materials/metal.h"
+#include "materials/lambertian.h"
+#include "samplers/hash.h"
+#include "math_utils.h"
+
+HittableList Scenes::create_default() {
+    auto mat_ground = std::make_shared<Lambertian>(Vec3f(0.8f, 0.8f, 0));
+    auto mat_lamb1 = std::make_shared<Lambertian>(Vec3f(1.0f, 0.25f, 0.25f));
+    auto mat_metal1 = std::make_shared<Metal>(Vec3f(0.8f, 0.8f, 0.8f), 0.9f);
+    auto mat_metal2 = std::make_shared<Metal>(Vec3f(0.2f, 0.8f, 0.8f), 0.3f);
+
+    return HittableList({
+        std::make_shared<Sphere>(Vec3f(0, -1001, 0), 1000.0f, mat_ground),
+        std::make_shared<Sphere>(Vec3f(0, 0, 0), 1.0f, mat_lamb1),
+        std::make_shared<Sphere>(Vec3f(-3, 0, 0), 1.0f, mat_metal1),
+        std::make_shared<Sphere>(Vec3f(3, 0, 0), 1.0f, mat_metal2),
+    });
+}
+
+HittableList Scenes::create_random_spheres(uint32_t grid_size, uint32_t seed) {
+    HittableList objects;
+
+    auto mat_ground = std::make_shared<Lambertian>(Vec3f(0.5f, 0.5f, 0.5f));
+    objects.Add(std::make_shared<Sphere>(Vec3f(0, -1001, 0), 1000.0f, mat_ground));
+
+    uint32_t state = seed;
+    auto rand = [&state]() {
+        state = Hash::mix(state + 1);
+        return Hash::to_unit_float(state);
+    };
+
+    float half = grid_size * 0.5f;
+    for (uint32_t z = 0; z < grid_size; z++) {
+        for (uint32_t x = 0; x < grid_size; x++) {
+            Vec3f center(
+                x - half + 0.9f * rand(),
+                -0.8f,
+                z - half * 0.5f + 0.9f * rand()
+            );
+
+            std::shared_ptr<Material> material;
+            if (rand() < 0.7f) {
+                material = std::make_shared<Lambertian>(Vec3f(rand() * rand(), rand() * rand(), rand() * rand()));
+            } else {
+                material = std::make_shared<Metal>(Vec3f(0.5f + rand() * 0.5f), rand() * 0.5f);
+            }
+
+            objects.Add(std::make_shared<Sphere>(center, 0.2f, material));
+        }
+    }
+
+    return objects;
+}
+
+HittableList Scenes::create_instanced(uint32_t instance_count, uint32_t seed) {
+    HittableList objects;
+
+    auto mat_ground = std::make_shared<Lambertian>(Vec3f(0.5f, 0.5f, 0.5f));
+    objects.Add(std::make_shared<Sphere>(Vec3f(0, -1001, 0), 1000.0f, mat_ground));
+
+    uint32_t state = seed;
+    auto rand = [&state]() {
+        state = Hash::mix(state + 1);
+        return Hash::to_unit_float(state);
+    };
+
+    // one "rock" asset, a lumpy cluster of spheres built once and
+    //   shared by every instance
+    std::shared_ptr<Material> mat_rock = std::make_shared<Lambertian>(Vec3f(0.45f, 0.35f, 0.3f));
+    std::shared_ptr<Material> mat_vein = std::make_shared<Metal>(Vec3f(0.9f, 0.75f, 0.4f), 0.2f);
+    HittableList rock;
+    rock.Add(std::make_shared<Sphere>(Vec3f(0, 0, 0), 0.3f, mat_rock));
+    for (uint32_t i = 0; i < 12; i++) {
+        float angle = i * 2.0f * Utils::PI / 12.0f;
+        Vec3f offset(std::cos(angle) * 0.25f, (rand() - 0.5f) * 0.3f, std::sin(angle) * 0.25f);
+        rock.Add(std::make_shared<Sphere>(offset, 0.08f + rand() * 0.08f, i % 4 == 0 ? mat_vein : mat_rock));
+    }
+    std::shared_ptr<const Blas> rock_blas = Blas::Build(rock);
+
+    uint32_t grid_size = (uint32_t)std::ceil(std::sqrt((float)instance_count));
+    float half = grid_size * 0.5f;
+    for (uint32_t i = 0; i < instance_count; i++) {
+        float x = (i % grid_size) - half + 0.5f + (rand() - 0.5f) * 0.4f;
+        float z = (i / grid_size) - half * 0.5f + (rand() - 0.5f) * 0.4f;
+        float size = 0.6f + rand() * 0.8f;
+        Vec3f axis = Vec3f::normalize(Vec3f(rand() - 0.5f, 1.0f, rand() - 0.5f));
+
+        Transform transform = Transform::translate(Vec3f(x, -1.0f + 0.3f * size, z)) *
+                              Transform::rotate(axis, rand() * 2.0f * Utils::PI) *
+                              Transform::scale(Vec3f(size, size * (0.7f + rand() * 0.3f), size));
+        objects.Add(std::make_shared<Instance>(rock_blas, transform));
+    }
+
+    return objects;
+}
+
+Camera Scenes::create_default_camera(float aspect_ratio) {
+    return Camera(
+        {0, 0, -5},   // pos
+        aspect_ratio, // aspect
+        1.0f,         // focal length
+        2.0f          // viewport height
+    );
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "objects/hittable_list.h"
+#include "camera.h"
+
+namespace Scenes {
+    HittableList create_default();
+    // ground plus a grid_size x grid_size field of small randomly
+    //   placed spheres with random materials
+    HittableList create_random_spheres(uint32_t grid_size, uint32_t seed);
+    // ground plus instance_count copies of one small sphere cluster
+    //   asset, each with a random rotation, scale and position
+    HittableList create_instanced(uint32_t instance_count, uint32_t seed);
+    Camera create_default_camera(float aspect_ratio);
+};
@@ -0,0 +1,119 @@
+#include "shading_rate.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+// fovea radii as fractions of the image height, full rate inside the
+//   first, half rate out to the second and quarter rate past that
+constexpr float FOVEA_FULL_RATE_RADIUS = 0.2f;
+constexpr float FOVEA_HALF_RATE_RADIUS = 0.45f;
+// luminance standard deviation over mean above which a tile needs full
+//   rate, or half rate. the epsilon stops dark tiles' noise counting
+constexpr float CONTRAST_FULL_RATE = 0.3f;
+constexpr float CONTRAST_HALF_RATE = 0.1f;
+constexpr float CONTRAST_EPSILON = 0.05f;
+
+uint32_t ShadingRate::get_foveated_rate(uint32_t x_start, uint32_t y_start, uint32_t x_end, uint32_t y_end, float focus_x, float focus_y, uint32_t image_height) {
+    // distance to the closest point of the tile, so the fovea
+    //   never ends up halfway through a coarse tile
+    float dx = std::max({(float)x_start - focus_x, 0.0f, focus_x - (float)x_end});
+    float dy = std::max({(float)y_start - focus_y, 0.0f, focus_y - (float)y_end});
+    float distance = std::sqrt(dx * dx + dy * dy) / (float)image_height;
+
+    if (distance <= FOVEA_FULL_RATE_RADIUS) return FULL_RATE;
+    if (distance <= FOVEA_HALF_RATE_RADIUS) return 2;
+    return COARSEST_RATE;
+}
+
+uint32_t ShadingRate::get_variance_rate(const float* linear, uint32_t width, uint32_t height, uint32_t stride) {
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    for (uint32_t y = 0; y < height; y++) {
+        const float* row = linear + (size_t)y * stride * 4;
+        for (uint32_t x = 0; x < width; x++) {
+            const float* pixel = row + (size_t)x * 4;
+            double luminance = 0.2126 * pixel[0] + 0.7152 * pixel[1] + 0.0722 * pixel[2];
+            sum += luminance;
+            sum_squares += luminance * luminance;
+        }
+    }
+
+    double count = (double)width * height;
+    double mean = sum / count;
+    double variance = std::max(0.0, sum_squares / count - mean * mean);
+    double contrast = std::sqrt(variance) / (mean + CONTRAST_EPSILON);
+
+    if (contrast >= CONTRAST_FULL_RATE) return FULL_RATE;
+    if (contrast >= CONTRAST_HALF_RATE) return 2;
+    return COARSEST_RATE;
+}
+
+void ShadingRate::FillTile(const float* blocks, uint32_t rate, uint32_t width, uint32_t height, bool nearest, float* out, uint32_t stride) {
+    uint32_t blocks_x = (width + rate - 1) / rate;
+    uint32_t blocks_y = (height + rate - 1) / rate;
+
+    // where pixel p lands between block centres
+    auto get_position = [rate](uint32_t p, uint32_t block_count, uint32_t* out_b0, uint32_t* out_b1, float* out_t) {
+        float position = ((float)p + 0.5f) / (float)rate - 0.5f;
+        position = std::clamp(position, 0.0f, (float)(block_count - 1));
+        *out_b0 = (uint32_t)position;
+        *out_b1 = std::min(*out_b0 + 1, block_count - 1);
+        *out_t = position - (float)*out_b0;
+    };
+
+    for (uint32_t y = 0; y < height; y++) {
+        float* out_row = out + (size_t)y * stride * 4;
+
+        if (nearest) {
+            const float* block_row = blocks + (size_t)(y / rate) * blocks_x * 4;
+            for (uint32_t x = 0; x < width; x++) {
+                memcpy(out_row + (size_t)x * 4, block_row + (size_t)(x / rate) * 4, sizeof(float) * 4);
+            }
+            continue;
+        }
+
+        uint32_t by0;
+        uint32_t by1;
+        float ty;
+        get_position(y, blocks_y, &by0, &by1, &ty);
+        const float* row0 = blocks + (size_t)by0 * blocks_x * 4;
+        const float* row1 = blocks + (size_t)by1 * blocks_x * 4;
+
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t bx0;
+            uint32_t bx1;
+            float tx;
+            get_position(x, blocks_x, &bx0, &bx1, &tx);
+
+            for (uint32_t c = 0; c < 4; c++) {
+                float top = row0[bx0 * 4 + c] + (row0[bx1 * 4 + c] - row0[bx0 * 4 + c]) * tx;
+                float bottom = row1[bx0 * 4 + c] + (row1[bx1 * 4 + c] - row1[bx0 * 4 + c]) * tx;
+                out_row[(size_t)x * 4 + c] = top + (bottom - top) * ty;
+            }
+        }
+    }
+}
+
+const char* ShadingRate::source_name(ShadingRateSource source) {
+    switch (source) {
+        case ShadingRateSource::Off: return "off";
+        case ShadingRateSource::Center: return "center";
+        case ShadingRateSource::Cursor: return "cursor";
+        case ShadingRateSource::Variance: return "variance";
+    }
+
+    return "unknown";
+}
+
+bool ShadingRate::parse_source(const char* name, ShadingRateSource* out_source) {
+    static const ShadingRateSource sources[] = {ShadingRateSource::Off, ShadingRateSource::Center, ShadingRateSource::Cursor, ShadingRateSource::Variance};
+    for (ShadingRateSource source : sources) {
+        if (strcmp(name, source_name(source)) == 0) {
+            *out_source = source;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+
+// where the full res tiles' shading rates come from. a tile at rate N is
+//   shaded once per N by N block of pixels and the blocks are filled in
+//   between, so rate 4 costs a sixteenth of full rate
+enum class ShadingRateSource {
+    // every pixel shaded on its own
+    Off,
+    // full rate around the middle of the screen, coarser further out
+    Center,
+    // same but around Renderer::set_focus, e.g. the mouse
+    Cursor,
+    // tiles are shaded coarse first and redone finer where what came
+    //   out has contrast
+    Variance
+};
+
+namespace ShadingRate {
+    constexpr uint32_t FULL_RATE = 1;
+    constexpr uint32_t COARSEST_RATE = 4;
+
+    // rate for the tile covering [x_start, x_end) by [y_start, y_end) from
+    //   how far it is from the focus point. the fovea scales with the
+    //   image height
+    uint32_t get_foveated_rate(uint32_t x_start, uint32_t y_start, uint32_t x_end, uint32_t y_end, float focus_x, float focus_y, uint32_t image_height);
+
+    // rate for a shaded tile from the luminance contrast of its width by
+    //   height linear RGBA values, stride is in pixels
+    uint32_t get_variance_rate(const float* linear, uint32_t width, uint32_t height, uint32_t stride);
+
+    // fills a width by height tile of linear RGBA (stride pixels per row)
+    //   from blocks, one value per rate by rate block packed row by row.
+    //   nearest repeats each block, otherwise it's bilinear between block
+    //   centres, clamped at the tile's edges
+    void FillTile(const float* blocks, uint32_t rate, uint32_t width, uint32_t height, bool nearest, float* out, uint32_t stride);
+
+    const char* source_name(ShadingRateSource source);
+    bool parse_source(const char* name, ShadingRateSource* out_source);
+};
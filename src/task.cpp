@@ -0,0 +1,127 @@
+#include "task.h"
+
+#include <new>
+#include <vector>
+
+// address no coroutine handle can have
+static char done_marker;
+static void* const DONE = &done_marker;
+
+// freed coroutine frames by size, never given back to the heap. the
+//   few coroutine types there are all reach a steady count quickly
+struct FreeFrame {
+    size_t size;
+    void* ptr;
+};
+static std::mutex free_frames_mtx;
+static std::vector<FreeFrame> free_frames;
+
+void* Task::promise_type::operator new(size_t size) {
+    {
+        std::lock_guard<std::mutex> lock(free_frames_mtx);
+        for (size_t i = 0; i < free_frames.size(); i++) {
+            if (free_frames[i].size == size) {
+                void* ptr = free_frames[i].ptr;
+                free_frames[i] = free_frames.back();
+                free_frames.pop_back();
+                return ptr;
+            }
+        }
+    }
+
+    return ::operator new(size);
+}
+
+void Task::promise_type::operator delete(void* ptr, size_t size) {
+    std::lock_guard<std::mutex> lock(free_frames_mtx);
+    free_frames.push_back({size, ptr});
+}
+
+std::coroutine_handle<> Task::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+    void* waiting = handle.promise().state.exchange(DONE);
+    if (waiting != nullptr) {
+        return std::coroutine_handle<>::from_address(waiting);
+    }
+
+    return std::noop_coroutine();
+}
+
+Task& Task::operator=(Task&& other) {
+    if (this != &other) {
+        if (handle) handle.destroy();
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+
+    return *this;
+}
+
+Task::~Task() {
+    if (handle) handle.destroy();
+}
+
+bool Task::is_done() const {
+    return !handle || handle.promise().state.load() == DONE;
+}
+
+bool Task::Awaiter::await_ready() const {
+    return !handle || handle.promise().state.load() == DONE;
+}
+
+bool Task::Awaiter::await_suspend(std::coroutine_handle<> waiting) {
+    // loses to the task finishing in between, then carry straight on
+    void* expected = nullptr;
+    return handle.promise().state.compare_exchange_strong(expected, waiting.address());
+}
+
+void TaskQueue::Push(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        handles.push_back(handle);
+    }
+    ready_cd.notify_all();
+}
+
+void TaskQueue::RunUntil(const std::function<bool()>& done) {
+    while (!done()) {
+        std::coroutine_handle<> handle;
+
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            ready_cd.wait(lock, [&] { return !handles.empty() || stopped || done(); });
+            if (handles.empty() || done()) return;
+
+            handle = handles.front();
+            handles.erase(handles.begin());
+        }
+
+        handle.resume();
+    }
+}
+
+void TaskQueue::Notify() {
+    // through the lock so a RunUntil between checking done
+    //   and going to sleep can't miss it
+    { std::lock_guard<std::mutex> lock(mtx); }
+    ready_cd.notify_all();
+}
+
+void TaskQueue::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopped = true;
+    }
+    ready_cd.notify_all();
+}
+
+TaskThread::TaskThread() : running(true) {
+    thread = std::thread([this] {
+        queue.RunUntil([this] { return !running.load(); });
+    });
+}
+
+TaskThread::~TaskThread() {
+    running = false;
+    queue.Stop();
+    thread.join();
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <vector>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+// a coroutine that starts running as soon as it's called and can be
+//   co_awaited by one other coroutine, which then resumes wherever it
+//   finishes. the Task owns the coroutine frame, keep it alive until
+//   is_done or it's destroyed while still suspended somewhere
+class Task {
+   public:
+    struct promise_type {
+        // nullptr while running with nobody waiting, DONE once finished,
+        //   otherwise the waiting coroutine's address
+        std::atomic<void*> state = nullptr;
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        void return_void() { }
+        void unhandled_exception() { std::terminate(); }
+
+        // stays suspended at the end so the Task can still read state
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+            void await_resume() noexcept { }
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        // frames are recycled, a frame loop would otherwise
+        //   allocate a few coroutines every frame
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr, size_t size);
+    };
+
+   private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) { }
+
+   public:
+    Task() : handle(nullptr) { }
+    Task(Task&& other) : handle(other.handle) { other.handle = nullptr; }
+    Task& operator=(Task&& other);
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task();
+
+    // an empty Task counts as done
+    bool is_done() const;
+
+    struct Awaiter {
+        std::coroutine_handle<promise_type> handle;
+
+        bool await_ready() const;
+        bool await_suspend(std::coroutine_handle<> waiting);
+        void await_resume() { }
+    };
+    Awaiter operator co_await() const { return Awaiter {handle}; }
+};
+
+// coroutines waiting to be resumed on one particular thread, in the order
+//   they were scheduled. either drained by hand (e.g. the main thread
+//   with RunUntil) or by a TaskThread
+class TaskQueue {
+   private:
+    // only ever a handful long, a vector keeps its capacity
+    //   where a deque would allocate as it moves along
+    std::vector<std::coroutine_handle<>> handles;
+    std::mutex mtx;
+    std::condition_variable ready_cd;
+    bool stopped;
+
+   public:
+    TaskQueue() : stopped(false) { }
+
+    struct ScheduleAwaiter {
+        TaskQueue* queue;
+
+        bool await_ready() { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { queue->Push(handle); }
+        void await_resume() { }
+    };
+
+    // "co_await queue.Schedule()" carries on wherever the queue is drained
+    ScheduleAwaiter Schedule() { return ScheduleAwaiter {this}; }
+
+    void Push(std::coroutine_handle<> handle);
+
+    // resumes queued coroutines until done() is true, blocking while
+    //   there's nothing to run. done is checked before every one, so
+    //   anything queued behind the point it became true stays queued
+    void RunUntil(const std::function<bool()>& done);
+
+    // wakes RunUntil to check done again
+    void Notify();
+
+    // makes a RunUntil that's out of work return instead of blocking
+    void Stop();
+};
+
+// a thread of its own that drains a TaskQueue until destroyed
+class TaskThread {
+   private:
+    TaskQueue queue;
+    std::atomic<bool> running;
+    std::thread thread;
+
+   public:
+    TaskThread();
+    ~TaskThread();
+
+    TaskQueue::ScheduleAwaiter Schedule() { return queue.Schedule(); }
+};
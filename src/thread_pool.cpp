@@ -1,44 +1,129 @@
 #include "thread_pool.h"
 #include <chrono>
 #include <iostream>
+#include <algorithm>
+#include <string>
+#include <cmath>
+#include "profiler.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// jobs the ring buffer starts with room for
+constexpr size_t INITIAL_QUEUE_CAPACITY = 64;
+// long enough that claiming a chunk (one atomic add) is noise
+constexpr double TARGET_CHUNK_NS = 50000.0;
+// so the last chunks to finish leave the other threads idle
+//   for at most an eighth of their share
+constexpr uint32_t CHUNKS_PER_THREAD = 8;
+// how much of the per item cost the latest run makes up
+constexpr double GRAIN_COST_SMOOTHING = 0.5;
+
+uint32_t GrainSize::get_balanced(uint32_t item_count, uint32_t thread_count) {
+    uint32_t chunks = std::max(thread_count, 1u) * CHUNKS_PER_THREAD;
+    return std::max((item_count + chunks - 1) / chunks, 1u);
+}
+
+uint32_t GrainSize::Get(uint32_t item_count, uint32_t thread_count) const {
+    uint32_t balanced = get_balanced(item_count, thread_count);
+    if (ns_per_item <= 0.0) return balanced;
+
+    double target = std::ceil(TARGET_CHUNK_NS / ns_per_item);
+    return (uint32_t)std::clamp(target, 1.0, (double)balanced);
+}
+
+void GrainSize::Record(uint64_t ns, uint32_t item_count) {
+    if (item_count == 0 || ns == 0) return;
+
+    double measured = (double)ns / item_count;
+    ns_per_item = ns_per_item == 0.0 ? measured : ns_per_item + (measured - ns_per_item) * GRAIN_COST_SMOOTHING;
+}
+
+ThreadPool::ThreadPool(const ThreadPlacement& placement)
+  : placement(placement),
+    job_queue(INITIAL_QUEUE_CAPACITY),
+    queue_head(0),
+    queue_size(0) {
+    bool restricted = placement.policy != ThreadPlacementPolicy::Unpinned || !placement.cpus.empty() || placement.numa_node >= 0;
+    std::string error;
+    if (restricted && !CpuTopology::select_cpus(placement, &placement_cpus, &error)) {
+        std::cerr << "ignoring thread placement, " << error << "\n";
+        this->placement = ThreadPlacement();
+        this->placement.thread_count = placement.thread_count;
+        placement_cpus.clear();
+    }
+
+    thread_count = this->placement.thread_count;
+    if (thread_count == 0) {
+        thread_count = placement_cpus.empty() ? std::thread::hardware_concurrency() : (uint32_t)placement_cpus.size();
+    }
+    thread_count = std::max(thread_count, 1u);
 
-ThreadPool::ThreadPool(uint32_t thread_count)
-  : thread_count(thread_count) {
     Start();
 }
 
-ThreadPool::ThreadPool() : ThreadPool(std::thread::hardware_concurrency()) { }
+ThreadPool::ThreadPool(uint32_t thread_count) : ThreadPool(ThreadPlacement {.thread_count = thread_count}) { }
+
+ThreadPool::ThreadPool() : ThreadPool(ThreadPlacement()) { }
 
 ThreadPool::~ThreadPool() {
     End();
 }
 
-void ThreadPool::Work(uint32_t thread_index) {
+void ThreadPool::PlaceCurrentThread(uint32_t thread_index) {
+    if (!placement_cpus.empty()) {
+        if (placement.policy == ThreadPlacementPolicy::Unpinned) {
+            CpuTopology::PinCurrentThread(placement_cpus);
+        } else {
+            uint32_t cpu = placement_cpus[thread_index % placement_cpus.size()];
+            if (CpuTopology::PinCurrentThread(std::vector<uint32_t>(1, cpu))) {
+                worker_cpus[thread_index] = (int32_t)cpu;
+            }
+        }
+    }
+
+    // before the worker touches anything so its scratch memory
+    //   (samplers, arenas, the pages of tiles it shades) lands there
+    if (placement.numa_node >= 0) {
+        CpuTopology::PreferNode(placement.numa_node);
+    }
+}
+
+void ThreadPool::Work(uint32_t thread_index, std::latch* started) {
+#ifdef __linux__
+    worker_thread_ids[thread_index] = (int32_t)syscall(SYS_gettid);
+#endif
+    PlaceCurrentThread(thread_index);
+    started->count_down();
+
     while (running) {
-        if (job_queue.empty()) {
+        if (queue_size == 0) {
             wait_cd.notify_all();
         }
 
-        std::function<void(uint32_t)> func;
+        Job job;
 
         {
             std::unique_lock<std::mutex> lock(mtx);
 
             queue_cd.wait(lock, [this] {
-                return !job_queue.empty() || !running;
+                return queue_size > 0 || !running;
             });
 
-            if (!running && job_queue.empty()) {
+            if (!running && queue_size == 0) {
                 return;
             }
 
             worker_threads_idle[thread_index] = false;
 
-            func = job_queue.front();
-            job_queue.pop();
+            job = std::move(job_queue[queue_head]);
+            queue_head = (queue_head + 1) % job_queue.size();
+            queue_size--;
         }
 
-        func(thread_index);
+        job(thread_index);
 
         {
             std::lock_guard<std::mutex> lock(mtx);
@@ -59,10 +144,16 @@ void ThreadPool::Start() {
     running = true;
 
     worker_threads_idle.resize(thread_count);
+    worker_thread_ids.assign(thread_count, -1);
+    worker_cpus.assign(thread_count, -1);
+
+    // wait for every worker to report in so their ids are valid
+    std::latch started(thread_count);
     for (uint32_t i = 0; i < thread_count; i++) {
-        worker_threads.emplace_back(&ThreadPool::Work, this, i);
         worker_threads_idle[i] = true;
+        worker_threads.emplace_back(&ThreadPool::Work, this, i, &started);
     }
+    started.wait();
 }
 
 void ThreadPool::End() {
@@ -79,17 +170,33 @@ void ThreadPool::End() {
 
     worker_threads.clear();
     worker_threads_idle.clear();
+    worker_thread_ids.clear();
+    worker_cpus.clear();
 }
 
-void ThreadPool::QueueJob(std::function<void(uint32_t)> func) {
+void ThreadPool::QueueJob(Job job) {
     {
         std::lock_guard<std::mutex> lock(mtx);
-        job_queue.push(func);
+
+        if (queue_size == job_queue.size()) {
+            // unwrap into a buffer twice the size
+            std::vector<Job> grown(job_queue.size() * 2);
+            for (size_t i = 0; i < queue_size; i++) {
+                grown[i] = std::move(job_queue[(queue_head + i) % job_queue.size()]);
+            }
+            job_queue = std::move(grown);
+            queue_head = 0;
+        }
+
+        job_queue[(queue_head + queue_size) % job_queue.size()] = std::move(job);
+        queue_size++;
     }
     queue_cd.notify_one();
 }
 
 void ThreadPool::Wait() {
+    PROFILE_EVENT(Profiler::Stage::PoolWait);
+
     std::unique_lock<std::mutex> lock(mtx);
-    wait_cd.wait(lock, [this] { return job_queue.empty() && IsIdle(); });
+    wait_cd.wait(lock, [this] { return queue_size == 0 && IsIdle(); });
 }
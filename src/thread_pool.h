@@ -4,25 +4,66 @@
 #include <thread>
 #include <mutex>
 #include <stdint.h>
-#include <functional>
-#include <queue>
 #include <condition_variable>
+#include <latch>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include "job.h"
+#include "cpu_topology.h"
+
+// chunk size for a ParallelFor over items that cost about the same, from
+//   how long they took the last time the loop ran. keep one per loop,
+//   item costs differ wildly between loops
+class GrainSize {
+   private:
+    // smoothed per thread cost of one item, 0 until measured
+    double ns_per_item;
+
+   public:
+    GrainSize() : ns_per_item(0.0) { }
+
+    // the smallest chunk that's still long enough to make claiming it
+    //   cheap, but never so big that threads run out of chunks to balance
+    uint32_t Get(uint32_t item_count, uint32_t thread_count) const;
+    void Record(uint64_t ns, uint32_t item_count);
+
+    // item_count split into a few chunks per thread
+    static uint32_t get_balanced(uint32_t item_count, uint32_t thread_count);
+};
 
 class ThreadPool {
    private:
     std::vector<std::thread> worker_threads;
     std::vector<bool> worker_threads_idle;
-    std::queue<std::function<void(uint32_t)>> job_queue;
+    std::vector<int32_t> worker_thread_ids;
+    ThreadPlacement placement;
+    // cpus the workers are restricted to, empty when nothing restricts them.
+    //   pinned workers get one each, round robin, others float over all
+    std::vector<uint32_t> placement_cpus;
+    std::vector<int32_t> worker_cpus;
+    // ring buffer of queued jobs, it only grows so once it's big
+    //   enough for a frame queueing jobs never allocates
+    std::vector<Job> job_queue;
+    size_t queue_head;
+    size_t queue_size;
     std::mutex mtx;
     std::condition_variable queue_cd;
     std::condition_variable wait_cd;
     uint32_t thread_count;
     bool running;
 
-    void Work(uint32_t thread_index);
+    void Work(uint32_t thread_index, std::latch* started);
+    void PlaceCurrentThread(uint32_t thread_index);
     bool IsIdle();
 
+    template <typename F>
+    void RunParallelFor(uint32_t begin, uint32_t end, uint32_t grain, GrainSize* tuner, F& func);
+
    public:
+    // a placement that can't be satisfied (e.g. a node with no cpus
+    //   the process may use) is reported and falls back to unpinned
+    ThreadPool(const ThreadPlacement& placement);
     ThreadPool(uint32_t thread_count);
     ThreadPool();
     ~ThreadPool();
@@ -30,8 +71,87 @@ class ThreadPool {
     void Start();
     void End();
 
-    void QueueJob(std::function<void(uint32_t)> func);
+    // captures have to fit in a Job, see job.h
+    void QueueJob(Job job);
     void Wait();
 
+    // calls func(chunk_begin, chunk_end, thread_index) over [begin, end) in
+    //   chunks of grain items (see GrainSize::get_balanced) and waits
+    //   for all of them, along with anything queued before. chunks are
+    //   claimed as threads free up, so uneven items still balance.
+    //   func is called directly, not through a Job, so it can capture anything
+    template <typename F>
+    void ParallelFor(uint32_t begin, uint32_t end, uint32_t grain, F&& func) {
+        RunParallelFor(begin, end, grain, nullptr, func);
+    }
+
+    // same but the chunk size comes from how long the loop's items took
+    //   last time, and this run's timing is recorded into grain
+    template <typename F>
+    void ParallelFor(uint32_t begin, uint32_t end, GrainSize* grain, F&& func) {
+        RunParallelFor(begin, end, grain->Get(end > begin ? end - begin : 0, thread_count), grain, func);
+    }
+
+    // calls func(x_start, y_start, x_end, y_end, thread_index) for every
+    //   tile_size square of a width by height image, row by row, clipped
+    //   at the right and bottom edges
+    template <typename F>
+    void ParallelForTiles(uint32_t width, uint32_t height, uint32_t tile_size, F&& func) {
+        uint32_t tiles_x = (width + tile_size - 1) / tile_size;
+        uint32_t tiles_y = (height + tile_size - 1) / tile_size;
+
+        ParallelFor(0, tiles_x * tiles_y, 1, [&](uint32_t tile_begin, uint32_t tile_end, uint32_t thread_index) {
+            for (uint32_t tile = tile_begin; tile < tile_end; tile++) {
+                uint32_t x_start = (tile % tiles_x) * tile_size;
+                uint32_t y_start = (tile / tiles_x) * tile_size;
+                func(x_start, y_start, std::min(x_start + tile_size, width), std::min(y_start + tile_size, height), thread_index);
+            }
+        });
+    }
+
     uint32_t get_thread_count() const { return thread_count; }
+
+    // kernel thread ids of the workers (linux only, -1 elsewhere),
+    //   used to attach per-thread hardware counters
+    const std::vector<int32_t>& get_worker_thread_ids() const { return worker_thread_ids; }
+
+    // the cpu each worker is pinned to, -1 for ones that aren't
+    const std::vector<int32_t>& get_worker_cpus() const { return worker_cpus; }
+    const ThreadPlacement& get_placement() const { return placement; }
 };
+
+template <typename F>
+void ThreadPool::RunParallelFor(uint32_t begin, uint32_t end, uint32_t grain, GrainSize* tuner, F& func) {
+    if (begin >= end) return;
+    grain = std::max(grain, 1u);
+
+    // 64 bit so claiming past the end can't wrap back into range
+    struct {
+        std::atomic<uint64_t> next;
+        std::atomic<uint64_t> busy_ns;
+    } shared = {begin, 0};
+
+    uint32_t chunk_count = (end - begin + grain - 1) / grain;
+    bool timed = tuner != nullptr;
+    for (uint32_t i = 0; i < std::min(thread_count, chunk_count); i++) {
+        QueueJob([&shared, &func, end, grain, timed](uint32_t thread_index) {
+            auto start = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+            while (true) {
+                uint64_t chunk_begin = shared.next.fetch_add(grain, std::memory_order_relaxed);
+                if (chunk_begin >= end) break;
+                func((uint32_t)chunk_begin, (uint32_t)std::min<uint64_t>(chunk_begin + grain, end), thread_index);
+            }
+
+            if (timed) {
+                shared.busy_ns += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            }
+        });
+    }
+
+    Wait();
+
+    if (timed) {
+        tuner->Record(shared.busy_ns, end - begin);
+    }
+}
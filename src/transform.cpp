@@ -0,0 +1,102 @@
+#include "transform.h"
+
+#include <cmath>
+
+Transform::Transform() {
+    for (uint32_t r = 0; r < 3; r++) {
+        for (uint32_t c = 0; c < 4; c++) {
+            m[r][c] = r == c ? 1.0f : 0.0f;
+        }
+    }
+}
+
+Transform Transform::translate(const Vec3f& offset) {
+    Transform t;
+    t.m[0][3] = offset.x;
+    t.m[1][3] = offset.y;
+    t.m[2][3] = offset.z;
+    return t;
+}
+
+Transform Transform::scale(const Vec3f& factors) {
+    Transform t;
+    t.m[0][0] = factors.x;
+    t.m[1][1] = factors.y;
+    t.m[2][2] = factors.z;
+    return t;
+}
+
+Transform Transform::rotate(const Vec3f& axis, float angle) {
+    // rodrigues' rotation formula
+    float s = std::sin(angle);
+    float c = std::cos(angle);
+    float k = 1.0f - c;
+    const Vec3f& a = axis;
+
+    Transform t;
+    t.m[0][0] = a.x * a.x * k + c;
+    t.m[0][1] = a.x * a.y * k - a.z * s;
+    t.m[0][2] = a.x * a.z * k + a.y * s;
+    t.m[1][0] = a.y * a.x * k + a.z * s;
+    t.m[1][1] = a.y * a.y * k + c;
+    t.m[1][2] = a.y * a.z * k - a.x * s;
+    t.m[2][0] = a.z * a.x * k - a.y * s;
+    t.m[2][1] = a.z * a.y * k + a.x * s;
+    t.m[2][2] = a.z * a.z * k + c;
+    return t;
+}
+
+Transform Transform::operator*(const Transform& other) const {
+    Transform t;
+    for (uint32_t r = 0; r < 3; r++) {
+        for (uint32_t c = 0; c < 4; c++) {
+            t.m[r][c] = m[r][0] * other.m[0][c] +
+                        m[r][1] * other.m[1][c] +
+                        m[r][2] * other.m[2][c] +
+                        (c == 3 ? m[r][3] : 0.0f);
+        }
+    }
+
+    return t;
+}
+
+Transform Transform::get_inverse() const {
+    // inverse of the 3x3 part through the adjugate, the
+    //   translation is then moved by that inverse
+    float det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    float inv_det = det != 0.0f ? 1.0f / det : 0.0f;
+
+    Transform t;
+    t.m[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) * inv_det;
+    t.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+    t.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+    t.m[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) * inv_det;
+    t.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+    t.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+    t.m[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) * inv_det;
+    t.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+    t.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+
+    Vec3f translation = t.apply_vector(Vec3f(m[0][3], m[1][3], m[2][3]));
+    t.m[0][3] = -translation.x;
+    t.m[1][3] = -translation.y;
+    t.m[2][3] = -translation.z;
+    return t;
+}
+
+Aabb Transform::apply_bounds(const Aabb& box) const {
+    // transform all eight corners and bound those
+    Aabb result;
+    for (uint32_t i = 0; i < 8; i++) {
+        Vec3f corner(
+            (i & 1) ? box.max.x : box.min.x,
+            (i & 2) ? box.max.y : box.min.y,
+            (i & 4) ? box.max.z : box.min.z
+        );
+        result.Expand(apply_point(corner));
+    }
+
+    return result;
+}
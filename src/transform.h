@@ -0,0 +1,52 @@
+#pragma once
+
+#include "vec3.h"
+#include "objects/aabb.h"
+
+// affine 3x4 transform, row major with the translation in the last column
+class Transform {
+   private:
+    float m[3][4];
+
+   public:
+    // identity
+    Transform();
+
+    static Transform translate(const Vec3f& offset);
+    static Transform scale(const Vec3f& factors);
+    // angle in radians around a (unit length) axis
+    static Transform rotate(const Vec3f& axis, float angle);
+
+    // applies other first, then this
+    Transform operator*(const Transform& other) const;
+
+    Transform get_inverse() const;
+
+    Vec3f apply_point(const Vec3f& p) const {
+        return {
+            m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+            m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+            m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]
+        };
+    }
+
+    Vec3f apply_vector(const Vec3f& v) const {
+        return {
+            m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+            m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+            m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z
+        };
+    }
+
+    // multiplies by the transpose of the linear part, normals go to
+    //   world space by calling this on the world-to-object transform
+    Vec3f apply_transposed(const Vec3f& n) const {
+        return {
+            m[0][0] * n.x + m[1][0] * n.y + m[2][0] * n.z,
+            m[0][1] * n.x + m[1][1] * n.y + m[2][1] * n.z,
+            m[0][2] * n.x + m[1][2] * n.y + m[2][2] * n.z
+        };
+    }
+
+    Aabb apply_bounds(const Aabb& box) const;
+};
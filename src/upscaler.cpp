@@ -0,0 +1,351 @@
+#include "upscaler.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "profiler.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define RTRT_UPSCALE_AVX2
+// compiled for AVX2 on its own and only called after checking the cpu,
+//   the rest of the build stays baseline x86-64
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+// neighbours count as the same surface as the nearest one if they hit the
+//   same object or are within this fraction of its depth. the object test
+//   keeps grazing floors smooth, the depth test keeps contact points soft
+constexpr float EDGE_DEPTH_TOLERANCE = 0.1f;
+// streaming stores write whole 32 byte lines
+constexpr uint32_t STREAM_ALIGNMENT = 32;
+constexpr uint32_t AVX2_PIXELS = 8;
+
+// where output coordinate x lands between source samples, pixel centres line up
+static void get_source_position(uint32_t x, uint32_t src_size, uint32_t dst_size, uint32_t* out_x0, uint32_t* out_x1, float* out_fx) {
+    float sx = ((float)x + 0.5f) * ((float)src_size / (float)dst_size) - 0.5f;
+    sx = std::clamp(sx, 0.0f, (float)(src_size - 1));
+
+    *out_x0 = (uint32_t)sx;
+    *out_x1 = std::min(*out_x0 + 1, src_size - 1);
+    *out_fx = sx - (float)*out_x0;
+}
+
+// pixels to go before dst_row + x is aligned for streaming stores,
+//   or the whole row if it never can be
+static uint32_t get_aligned_start(const uint8_t* dst_row, uint32_t width) {
+    uintptr_t address = (uintptr_t)dst_row;
+    if (address % 4 != 0) return width;
+
+    uint32_t misaligned = (uint32_t)(address % STREAM_ALIGNMENT);
+    uint32_t start = misaligned == 0 ? 0 : (STREAM_ALIGNMENT - misaligned) / 4;
+    return std::min(start, width);
+}
+
+// a 0 or 1 for each of the four neighbours of every surface mask,
+//   multiplying by these drops neighbours without branching
+struct MaskWeights {
+    alignas(16) float values[16][4];
+
+    constexpr MaskWeights() : values() {
+        for (uint32_t mask = 0; mask < 16; mask++) {
+            for (uint32_t i = 0; i < 4; i++) {
+                values[mask][i] = (mask >> i) & 1 ? 1.0f : 0.0f;
+            }
+        }
+    }
+};
+constexpr MaskWeights MASK_WEIGHTS;
+
+static void bilinear_pixel(const float* blended, uint32_t x0, uint32_t x1, const float* fx, float* out) {
+    for (uint32_t c = 0; c < 4; c++) {
+        float a = blended[x0 * 4 + c];
+        float b = blended[x1 * 4 + c];
+        out[c] = a + (b - a) * fx[c];
+    }
+}
+
+static void edge_aware_pixel(const float* row0, const float* row1, uint32_t x0, uint32_t x1, const float* wx, const float* wy, uint32_t mask, float* out) {
+    const float* keep = MASK_WEIGHTS.values[mask];
+    float weights[4];
+    for (uint32_t i = 0; i < 4; i++) {
+        weights[i] = (wx[i] * wy[i]) * keep[i];
+    }
+
+    // the nearest neighbour always keeps its weight, so the sum is never 0
+    float inv_sum = 1.0f / ((weights[0] + weights[1]) + (weights[2] + weights[3]));
+    for (uint32_t i = 0; i < 4; i++) {
+        weights[i] = weights[i] * inv_sum;
+    }
+
+    for (uint32_t c = 0; c < 4; c++) {
+        float v = row0[x0 * 4 + c] * weights[0];
+        v = v + row0[x1 * 4 + c] * weights[1];
+        v = v + row1[x0 * 4 + c] * weights[2];
+        v = v + row1[x1 * 4 + c] * weights[3];
+        out[c] = v;
+    }
+}
+
+#ifdef RTRT_UPSCALE_AVX2
+
+AVX2_FUNCTION static __m256 load_pair(const float* row, uint32_t x_even, uint32_t x_odd) {
+    return _mm256_set_m128(_mm_load_ps(row + x_odd * 4), _mm_load_ps(row + x_even * 4));
+}
+
+// out is the cache line aligned scratch row, so every pair lands on a 32 byte boundary
+AVX2_FUNCTION static uint32_t bilinear_row_avx2(const float* blended, const uint32_t* x0s, const uint32_t* x1s, const float* fxs, uint32_t width, float* out) {
+    uint32_t x = 0;
+    for (; x + AVX2_PIXELS <= width; x += AVX2_PIXELS) {
+        for (uint32_t i = 0; i < 4; i++) {
+            uint32_t p = x + i * 2;
+            __m256 a = load_pair(blended, x0s[p], x0s[p + 1]);
+            __m256 b = load_pair(blended, x1s[p], x1s[p + 1]);
+            __m256 f = _mm256_loadu_ps(fxs + (size_t)p * 4);
+            _mm256_store_ps(out + (size_t)p * 4, _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), f)));
+        }
+    }
+
+    return x;
+}
+
+// same operations in the same order as edge_aware_pixel, so both give the same floats
+AVX2_FUNCTION static uint32_t edge_aware_row_avx2(const float* row0, const float* row1, const uint32_t* x0s, const uint32_t* x1s, const float* wxs, const float* wy, const uint8_t* masks, const uint32_t* mask_slots, uint32_t width, float* out) {
+    const float* keep_table = &MASK_WEIGHTS.values[0][0];
+    __m256 wy_pair = _mm256_broadcast_ps((const __m128*)wy);
+    __m256 one = _mm256_set1_ps(1.0f);
+
+    uint32_t x = 0;
+    for (; x + AVX2_PIXELS <= width; x += AVX2_PIXELS) {
+        for (uint32_t i = 0; i < 4; i++) {
+            uint32_t p = x + i * 2;
+            // w00 w10 w01 w11 of both pixels
+            __m256 keep = load_pair(keep_table, masks[mask_slots[p]], masks[mask_slots[p + 1]]);
+            __m256 w = _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(wxs + (size_t)p * 4), wy_pair), keep);
+            __m256 sum = _mm256_hadd_ps(w, w);
+            sum = _mm256_hadd_ps(sum, sum);
+            w = _mm256_mul_ps(w, _mm256_div_ps(one, sum));
+
+            // then broadcast within each lane
+            __m256 v = _mm256_mul_ps(load_pair(row0, x0s[p], x0s[p + 1]), _mm256_shuffle_ps(w, w, 0x00));
+            v = _mm256_add_ps(v, _mm256_mul_ps(load_pair(row0, x1s[p], x1s[p + 1]), _mm256_shuffle_ps(w, w, 0x55)));
+            v = _mm256_add_ps(v, _mm256_mul_ps(load_pair(row1, x0s[p], x0s[p + 1]), _mm256_shuffle_ps(w, w, 0xaa)));
+            v = _mm256_add_ps(v, _mm256_mul_ps(load_pair(row1, x1s[p], x1s[p + 1]), _mm256_shuffle_ps(w, w, 0xff)));
+            _mm256_store_ps(out + (size_t)p * 4, v);
+        }
+    }
+
+    return x;
+}
+
+AVX2_FUNCTION static uint32_t stream_row_avx2(const uint8_t* row, uint32_t x, uint32_t width, uint8_t* dst_row) {
+    for (; x + AVX2_PIXELS <= width; x += AVX2_PIXELS) {
+        __m256i pixels = _mm256_loadu_si256((const __m256i*)(row + (size_t)x * 4));
+        _mm256_stream_si256((__m256i*)(dst_row + (size_t)x * 4), pixels);
+    }
+
+    return x;
+}
+
+#endif
+
+Upscaler::Upscaler(uint32_t src_width, uint32_t src_height, uint32_t dst_width, uint32_t dst_height, uint32_t thread_count)
+  : src_width(std::max(1u, src_width)),
+    src_height(std::max(1u, src_height)),
+    dst_width(dst_width),
+    dst_height(dst_height),
+    use_avx2(has_avx2()) {
+    column_x0.resize(dst_width);
+    column_x1.resize(dst_width);
+    column_fx.resize((size_t)dst_width * 4);
+    column_nearest.resize(dst_width);
+    column_wx.resize((size_t)dst_width * 4);
+    column_mask_slot.resize(dst_width);
+    for (uint32_t x = 0; x < dst_width; x++) {
+        float fx;
+        get_source_position(x, this->src_width, dst_width, &column_x0[x], &column_x1[x], &fx);
+        for (uint32_t c = 0; c < 4; c++) {
+            column_fx[(size_t)x * 4 + c] = fx;
+        }
+        column_nearest[x] = fx < 0.5f ? column_x0[x] : column_x1[x];
+
+        float* wx = &column_wx[(size_t)x * 4];
+        wx[0] = 1.0f - fx;
+        wx[1] = fx;
+        wx[2] = 1.0f - fx;
+        wx[3] = fx;
+        column_mask_slot[x] = column_x0[x] * 2 + (fx < 0.5f ? 0 : 1);
+    }
+
+    scratch.resize(thread_count);
+    for (Scratch& s : scratch) {
+        s.blended.resize((size_t)this->src_width * 4);
+        s.filtered.resize((size_t)dst_width * 4);
+        s.resolved.resize((size_t)dst_width * 4);
+        s.surface_masks.resize((size_t)this->src_width * 2);
+    }
+}
+
+void Upscaler::set_use_avx2(bool use_avx2) {
+    this->use_avx2 = use_avx2 && has_avx2();
+}
+
+bool Upscaler::has_avx2() {
+#ifdef RTRT_UPSCALE_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+const char* Upscaler::filter_name(UpscaleFilter filter) {
+    switch (filter) {
+        case UpscaleFilter::Nearest: return "nearest";
+        case UpscaleFilter::Bilinear: return "bilinear";
+        case UpscaleFilter::EdgeAware: return "edge_aware";
+    }
+
+    return "unknown";
+}
+
+bool Upscaler::parse_filter(const char* name, UpscaleFilter* out_filter) {
+    static const UpscaleFilter filters[] = {UpscaleFilter::Nearest, UpscaleFilter::Bilinear, UpscaleFilter::EdgeAware};
+    for (UpscaleFilter filter : filters) {
+        if (strcmp(name, filter_name(filter)) == 0) {
+            *out_filter = filter;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Upscaler::UpscaleRowNearest(const float* src, uint32_t y, Scratch* s) const {
+    uint32_t y0;
+    uint32_t y1;
+    float fy;
+    get_source_position(y, src_height, dst_height, &y0, &y1, &fy);
+    uint32_t src_y = fy < 0.5f ? y0 : y1;
+    const float* src_row = src + (size_t)src_y * src_width * 4;
+
+    float* out = s->filtered.data();
+    for (uint32_t x = 0; x < dst_width; x++) {
+        memcpy(out + (size_t)x * 4, src_row + (size_t)column_nearest[x] * 4, sizeof(float) * 4);
+    }
+}
+
+void Upscaler::UpscaleRowBilinear(const float* src, uint32_t y, Scratch* s) const {
+    uint32_t y0;
+    uint32_t y1;
+    float fy;
+    get_source_position(y, src_height, dst_height, &y0, &y1, &fy);
+
+    // the vertical half of the filter is shared by the whole row, do it
+    //   once at source width and only the horizontal half per pixel
+    const float* row0 = src + (size_t)y0 * src_width * 4;
+    const float* row1 = src + (size_t)y1 * src_width * 4;
+    float* blended = s->blended.data();
+    for (uint32_t i = 0; i < src_width * 4; i++) {
+        blended[i] = row0[i] + (row1[i] - row0[i]) * fy;
+    }
+
+    float* out = s->filtered.data();
+    uint32_t x = 0;
+#ifdef RTRT_UPSCALE_AVX2
+    if (use_avx2) {
+        x = bilinear_row_avx2(blended, column_x0.data(), column_x1.data(), column_fx.data(), dst_width, out);
+    }
+#endif
+
+    for (; x < dst_width; x++) {
+        bilinear_pixel(blended, column_x0[x], column_x1[x], &column_fx[(size_t)x * 4], out + (size_t)x * 4);
+    }
+}
+
+void Upscaler::UpscaleRowEdgeAware(const float* src, const GBufferSample* gbuffer, uint32_t y, Scratch* s) const {
+    uint32_t y0;
+    uint32_t y1;
+    float fy;
+    get_source_position(y, src_height, dst_height, &y0, &y1, &fy);
+
+    // which neighbours survive only depends on the source cell and which
+    //   corner is nearest, so test the G-buffer once per cell instead of
+    //   once per output pixel
+    const GBufferSample* gbuffer0 = gbuffer + (size_t)y0 * src_width;
+    const GBufferSample* gbuffer1 = gbuffer + (size_t)y1 * src_width;
+    uint8_t* masks = s->surface_masks.data();
+    for (uint32_t x0 = 0; x0 < src_width; x0++) {
+        uint32_t x1 = std::min(x0 + 1, src_width - 1);
+        const GBufferSample* g[4] = {&gbuffer0[x0], &gbuffer0[x1], &gbuffer1[x0], &gbuffer1[x1]};
+        for (uint32_t side = 0; side < 2; side++) {
+            const GBufferSample& nearest = *g[(fy < 0.5f ? 0 : 2) + side];
+            float tolerance = nearest.depth * EDGE_DEPTH_TOLERANCE;
+            uint8_t mask = 0;
+            for (uint32_t i = 0; i < 4; i++) {
+                bool same_surface = g[i]->object_id == nearest.object_id || std::fabs(g[i]->depth - nearest.depth) <= tolerance;
+                mask |= (uint8_t)same_surface << i;
+            }
+            masks[x0 * 2 + side] = mask;
+        }
+    }
+
+    alignas(16) float wy[4] = {1.0f - fy, 1.0f - fy, fy, fy};
+
+    const float* row0 = src + (size_t)y0 * src_width * 4;
+    const float* row1 = src + (size_t)y1 * src_width * 4;
+    float* out = s->filtered.data();
+    uint32_t x = 0;
+#ifdef RTRT_UPSCALE_AVX2
+    if (use_avx2) {
+        x = edge_aware_row_avx2(row0, row1, column_x0.data(), column_x1.data(), column_wx.data(), wy, masks, column_mask_slot.data(), dst_width, out);
+    }
+#endif
+
+    for (; x < dst_width; x++) {
+        edge_aware_pixel(row0, row1, column_x0[x], column_x1[x], &column_wx[(size_t)x * 4], wy, masks[column_mask_slot[x]], out + (size_t)x * 4);
+    }
+}
+
+void Upscaler::StoreRow(const uint8_t* row, uint8_t* dst_row) const {
+    uint32_t x = 0;
+#ifdef RTRT_UPSCALE_AVX2
+    if (use_avx2) {
+        x = get_aligned_start(dst_row, dst_width);
+        memcpy(dst_row, row, (size_t)x * 4);
+        x = stream_row_avx2(row, x, dst_width, dst_row);
+    }
+#endif
+
+    memcpy(dst_row + (size_t)x * 4, row + (size_t)x * 4, (size_t)(dst_width - x) * 4);
+}
+
+void Upscaler::UpscaleRows(const float* src, const GBufferSample* gbuffer, UpscaleFilter filter, const ResolveSettings& settings, uint32_t y_start, uint32_t y_end, uint32_t thread_index, uint8_t* dst) {
+    PROFILE_EVENT(Profiler::Stage::Upscale);
+
+    Scratch* s = &scratch[thread_index];
+    if (filter == UpscaleFilter::EdgeAware && gbuffer == nullptr) {
+        filter = UpscaleFilter::Bilinear;
+    }
+
+    for (uint32_t y = y_start; y < y_end; y++) {
+        switch (filter) {
+            case UpscaleFilter::Nearest: UpscaleRowNearest(src, y, s); break;
+            case UpscaleFilter::Bilinear: UpscaleRowBilinear(src, y, s); break;
+            case UpscaleFilter::EdgeAware: UpscaleRowEdgeAware(src, gbuffer, y, s); break;
+        }
+
+        // the row is still in L1, resolve it there and only touch
+        //   the output with the finished bytes
+        Resolve::ResolvePixels(s->filtered.data(), y * dst_width, dst_width, dst_width, settings, s->resolved.data());
+        StoreRow(s->resolved.data(), dst + (size_t)y * dst_width * 4);
+    }
+
+#ifdef RTRT_UPSCALE_AVX2
+    // streaming stores aren't ordered with normal ones,
+    //   fence before anyone else reads the output
+    if (use_avx2) {
+        _mm_sfence();
+    }
+#endif
+}
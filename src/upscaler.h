@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "aligned_allocator.h"
+#include "resolve.h"
+
+enum class UpscaleFilter {
+    Nearest,
+    Bilinear,
+    // bilinear, but neighbours that aren't on the same surface as the
+    //   nearest one are left out so silhouettes stay sharp
+    EdgeAware
+};
+
+// what the primary ray through a low res pixel's centre hit
+struct GBufferSample {
+    float depth;
+    uint32_t object_id;
+};
+
+// stretches a low res linear float RGBA image (plus its G-buffer for EdgeAware) over a bigger
+//   RGBA8 one. filtering happens on linear radiance and each output row is
+//   resolved at output resolution, so tone mapping and sRGB encoding never
+//   get interpolated. rows are processed whole, with AVX2 and streaming
+//   stores where the cpu has it, so the output never gets pulled into
+//   cache just to be overwritten
+class Upscaler {
+   private:
+    // per worker thread, one output row on its way through the filter and resolve
+    struct Scratch {
+        std::vector<float, AlignedAllocator<float, CACHE_LINE_SIZE>> blended;
+        std::vector<float, AlignedAllocator<float, CACHE_LINE_SIZE>> filtered;
+        std::vector<uint8_t, AlignedAllocator<uint8_t, CACHE_LINE_SIZE>> resolved;
+        // per source column and nearest side, which of the four
+        //   neighbours are on the nearest one's surface
+        std::vector<uint8_t> surface_masks;
+    };
+
+    uint32_t src_width;
+    uint32_t src_height;
+    uint32_t dst_width;
+    uint32_t dst_height;
+    bool use_avx2;
+    // per output column: the two source columns either side of
+    //   it and how far across it is, repeated for every channel
+    std::vector<uint32_t> column_x0;
+    std::vector<uint32_t> column_x1;
+    std::vector<float, AlignedAllocator<float, CACHE_LINE_SIZE>> column_fx;
+    // whichever of the two is closer
+    std::vector<uint32_t> column_nearest;
+    // edge aware: horizontal weights of the four neighbours and
+    //   where the column's entry in Scratch::surface_masks is
+    std::vector<float, AlignedAllocator<float, CACHE_LINE_SIZE>> column_wx;
+    std::vector<uint32_t> column_mask_slot;
+    std::vector<Scratch> scratch;
+
+    // each fills scratch->filtered with output row y, still linear
+    void UpscaleRowNearest(const float* src, uint32_t y, Scratch* scratch) const;
+    void UpscaleRowBilinear(const float* src, uint32_t y, Scratch* scratch) const;
+    void UpscaleRowEdgeAware(const float* src, const GBufferSample* gbuffer, uint32_t y, Scratch* scratch) const;
+    void StoreRow(const uint8_t* row, uint8_t* dst_row) const;
+
+   public:
+    Upscaler(uint32_t src_width, uint32_t src_height, uint32_t dst_width, uint32_t dst_height, uint32_t thread_count);
+
+    // output rows [y_start, y_end) of dst, resolved with settings. src is
+    //   4 floats per pixel, 16 byte aligned, and gbuffer is only read by
+    //   EdgeAware. thread_index picks the scratch buffers, two threads
+    //   can't share one
+    void UpscaleRows(const float* src, const GBufferSample* gbuffer, UpscaleFilter filter, const ResolveSettings& settings, uint32_t y_start, uint32_t y_end, uint32_t thread_index, uint8_t* dst);
+
+    // off forces the scalar path even on cpus with AVX2, for benchmarking
+    void set_use_avx2(bool use_avx2);
+    bool get_use_avx2() const { return use_avx2; }
+
+    static bool has_avx2();
+    static const char* filter_name(UpscaleFilter filter);
+    // inverse of filter_name, returns false for unknown names
+    static bool parse_filter(const char* name, UpscaleFilter* out_filter);
+};
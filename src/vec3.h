@@ -12,17 +12,16 @@ struct Vec3 {
     Vec3() : x(), y(), z() { }
     Vec3(T s) : x(s), y(s), z(s) { }
     Vec3(T x, T y, T z) : x(x), y(y), z(z) { }
-    Vec3(const Vec3<T>& v) : x(v.x), y(v.y), z(v.z) { }
-
-    Vec3<T>& operator=(const Vec3<T>& other) {
-        x = other.x;
-        y = other.y;
-        z = other.z;
-        return *this;
-    }
+    // defaulted so Vec3 stays trivially copyable and can be
+    //   written to and mapped from files as-is (see scene_cache.h)
+    Vec3(const Vec3<T>& v) = default;
+    Vec3<T>& operator=(const Vec3<T>& other) = default;
 
     Vec3<T> operator-() const { return Vec3<T>(-x, -y, -z); }
 
+    T& operator[](uint32_t axis) { return (&x)[axis]; }
+    const T& operator[](uint32_t axis) const { return (&x)[axis]; }
+
     // ~~~ one-sided operators ~~~
 
     Vec3<T>& operator+=(const Vec3<T>& other) {
@@ -85,7 +84,7 @@ struct Vec3 {
         return Vec3<T>(
             a.y * b.z - a.z * b.y,
             a.z * b.x - a.x * b.z,
-            a.x * b.y - a.y * b.z
+            a.x * b.y - a.y * b.x
         );
     }
     static Vec3<T> normalize(const Vec3<T>& v) {
@@ -95,6 +94,14 @@ struct Vec3 {
     static Vec3<T> reflect(const Vec3<T>& v, const Vec3<T>& n) {
         return v - (n * static_cast<T>(2) * dot(v, n));
     }
+
+    // component-wise
+    static Vec3<T> min(const Vec3<T>& a, const Vec3<T>& b) {
+        return Vec3<T>(a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y, a.z < b.z ? a.z : b.z);
+    }
+    static Vec3<T> max(const Vec3<T>& a, const Vec3<T>& b) {
+        return Vec3<T>(a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y, a.z > b.z ? a.z : b.z);
+    }
 };
 
 // ~~~ vector math operators ~~~